@@ -0,0 +1,64 @@
+#include "fault_simulator.h"
+#include <stddef.h>
+
+// Bump allocator for data that lives as long as the circuit. Allocations are
+// carved out of large chunks and released all at once by arena_free().
+
+#define ARENA_CHUNK_SIZE ((size_t)1 << 20)
+#define ARENA_ALIGN 64
+
+struct ArenaChunk {
+    ArenaChunk* next;
+    size_t used;
+    size_t size;
+    char* data;
+};
+
+void arena_init(Arena* arena) {
+    arena->head = NULL;
+    arena->bytes = 0;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    // Cache-line alignment keeps every array vector-load friendly
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (size == 0) size = ARENA_ALIGN;
+    ArenaChunk* chunk = arena->head;
+    if (!chunk || chunk->used + size > chunk->size) {
+        size_t chunk_size = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+        chunk = (ArenaChunk*)malloc(sizeof(ArenaChunk) + chunk_size + ARENA_ALIGN);
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        uintptr_t base = (uintptr_t)(chunk + 1);
+        chunk->data = (char*)((base + ARENA_ALIGN - 1) & ~(uintptr_t)(ARENA_ALIGN - 1));
+        // Oversized blocks go behind the current chunk so its free space stays usable
+        if (arena->head && size > ARENA_CHUNK_SIZE) {
+            chunk->next = arena->head->next;
+            arena->head->next = chunk;
+        } else {
+            chunk->next = arena->head;
+            arena->head = chunk;
+        }
+        arena->bytes += chunk_size;
+    }
+    void* ptr = chunk->data + chunk->used;
+    chunk->used += size;
+    return ptr;
+}
+
+void* arena_calloc(Arena* arena, size_t count, size_t size) {
+    void* ptr = arena_alloc(arena, count * size);
+    memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void arena_free(Arena* arena) {
+    ArenaChunk* chunk = arena->head;
+    while (chunk) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->head = NULL;
+    arena->bytes = 0;
+}
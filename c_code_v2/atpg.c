@@ -0,0 +1,541 @@
+#include "fault_simulator.h"
+
+// Deterministic test generation (PODEM) for the faults a simulation run left
+// undetected.
+//
+// The good and the faulty machine are simulated side by side with the
+// program's three-valued fold-then-finish tables; a net's five-valued value
+// is the pair (good, faulty): D is 1/0, D_BAR is 0/1, and anything with an X is X.
+// Decisions are primary input assignments only. Each one is implied
+// event-driven from the changed input, level by level, and every net that
+// leaves X is recorded so the next fault starts from a clean slate.
+//
+// A fault is tested once a D or D_BAR reaches a primary output. A partial
+// assignment fails when the fault site holds its stuck-at value or the
+// D-frontier is empty; the last decision is then flipped or undone. A search
+// that runs out of decisions without hitting the backtrack limit proves the
+// fault redundant.
+//
+// Target faults are taken in batches and spread over the worker threads.
+// The tests of a batch get their X inputs filled from a seeded generator
+// and are fault simulated; only tests that detect some fault first are
+// kept, and faults they detect are not targeted again.
+
+typedef enum { PODEM_TESTED, PODEM_REDUNDANT, PODEM_ABORTED } PodemResult;
+
+// One search's workspace; a thread reuses it for every fault it targets
+typedef struct {
+    const Circuit* circuit;
+    const bool* is_output;
+    const int* input_index;   // net ID -> primary input index, -1 otherwise
+    const int* op_level;      // level of each op
+    uint8_t* good;            // LogicValue per net, X slot included
+    uint8_t* faulty;
+    int* touched;             // nets that left X since the last reset
+    uint8_t* is_touched;
+    int num_touched;
+    int* queue;               // ops waiting for evaluation, bucketed by level
+    int* queue_fill;          // next free slot of each level's bucket
+    uint8_t* queued;
+    int* cone;                // ops in the fault site's fanout cone, in program order
+    int num_cone;
+    uint8_t* in_cone;
+    int* cone_index;          // position of a cone op in 'cone'
+    uint8_t* x_path;          // per cone position: X nets lead from the op to an output
+    int* decision_input;      // decision stack: input index and whether
+    uint8_t* decision_flipped; // the other value was tried already
+    // Fault under test
+    int stem_net;             // stem fault: net forced in the faulty machine, -1 otherwise
+    int branch_pin;           // branch fault: fanin entry forced, -1 otherwise
+    int site_net;             // net whose good value activates the fault
+    int stuck_at;
+} PodemWorker;
+
+static inline LogicValue five_valued(uint8_t good, uint8_t faulty) {
+    if (good == X || faulty == X) return X;
+    if (good == faulty) return (LogicValue)good;
+    return good == ONE ? D : D_BAR;
+}
+
+static void worker_init(PodemWorker* w, const Circuit* circuit, const bool* is_output, const int* input_index,
+                        const int* op_level) {
+    const EvalProgram* prog = &circuit->program;
+    int num_nets = circuit->nets.count + 1;
+    w->circuit = circuit;
+    w->is_output = is_output;
+    w->input_index = input_index;
+    w->op_level = op_level;
+    w->good = (uint8_t*)malloc(num_nets);
+    w->faulty = (uint8_t*)malloc(num_nets);
+    memset(w->good, X, num_nets);
+    memset(w->faulty, X, num_nets);
+    w->touched = (int*)malloc(num_nets * sizeof(int));
+    w->is_touched = (uint8_t*)calloc(num_nets, 1);
+    w->num_touched = 0;
+    w->queue = (int*)malloc((prog->num_ops + 1) * sizeof(int));
+    w->queue_fill = (int*)malloc((prog->num_levels + 1) * sizeof(int));
+    for (int l = 0; l < prog->num_levels; l++) w->queue_fill[l] = prog->level_start[l];
+    w->queued = (uint8_t*)calloc(prog->num_ops + 1, 1);
+    w->cone = (int*)malloc((prog->num_ops + 1) * sizeof(int));
+    w->in_cone = (uint8_t*)calloc(prog->num_ops + 1, 1);
+    w->num_cone = 0;
+    w->cone_index = (int*)malloc((prog->num_ops + 1) * sizeof(int));
+    w->x_path = (uint8_t*)malloc(prog->num_ops + 1);
+    w->decision_input = (int*)malloc((circuit->num_primary_inputs + 1) * sizeof(int));
+    w->decision_flipped = (uint8_t*)malloc(circuit->num_primary_inputs + 1);
+}
+
+static void worker_free(PodemWorker* w) {
+    free(w->good);
+    free(w->faulty);
+    free(w->touched);
+    free(w->is_touched);
+    free(w->queue);
+    free(w->queue_fill);
+    free(w->queued);
+    free(w->cone);
+    free(w->in_cone);
+    free(w->cone_index);
+    free(w->x_path);
+    free(w->decision_input);
+    free(w->decision_flipped);
+}
+
+// Helper: Store a net's pair of values, queueing its readers if it changed
+static void set_net(PodemWorker* w, int net, uint8_t good, uint8_t faulty) {
+    if (net == w->stem_net) faulty = (uint8_t)w->stuck_at;
+    if (w->good[net] == good && w->faulty[net] == faulty) return;
+    w->good[net] = good;
+    w->faulty[net] = faulty;
+    if (!w->is_touched[net]) {
+        w->is_touched[net] = 1;
+        w->touched[w->num_touched++] = net;
+    }
+    const EvalProgram* prog = &w->circuit->program;
+    for (int e = prog->fanout_start[net]; e < prog->fanout_start[net + 1]; e++) {
+        int k = prog->fanout[e];
+        if (w->queued[k]) continue;
+        w->queued[k] = 1;
+        w->queue[w->queue_fill[w->op_level[k]]++] = k;
+    }
+}
+
+// Helper: Evaluate queued ops level by level until nothing changes
+static void imply(PodemWorker* w) {
+    const EvalProgram* prog = &w->circuit->program;
+    for (int l = 1; l < prog->num_levels; l++) {
+        // Ops only queue readers on higher levels, so this bucket is final
+        for (int q = prog->level_start[l]; q < w->queue_fill[l]; q++) {
+            int k = w->queue[q];
+            w->queued[k] = 0;
+            const uint8_t (*rule)[3] = prog->lut[prog->op[k]];
+            int first = prog->in_start[k];
+            uint8_t good = w->good[prog->in[first]];
+            uint8_t faulty = first == w->branch_pin ? (uint8_t)w->stuck_at : w->faulty[prog->in[first]];
+            for (int j = first + 1; j < prog->in_start[k + 1]; j++) {
+                good = rule[good][w->good[prog->in[j]]];
+                faulty = rule[faulty][j == w->branch_pin ? (uint8_t)w->stuck_at : w->faulty[prog->in[j]]];
+            }
+            const uint8_t* final = prog->lut_final[prog->op[k]];
+            set_net(w, prog->out[k], final[good], final[faulty]);
+        }
+        w->queue_fill[l] = prog->level_start[l];
+    }
+}
+
+// Helper: Assign a primary input (X to undo) and imply the consequences
+static void assign_input(PodemWorker* w, int input, uint8_t value) {
+    int net = w->circuit->primary_inputs[input];
+    set_net(w, net, value, value);
+    imply(w);
+}
+
+static int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Helper: Set up the fault: its cone, and the faulty machine's forced value
+static void worker_begin_fault(PodemWorker* w, const Fault* fault) {
+    const EvalProgram* prog = &w->circuit->program;
+    w->stuck_at = fault->stuck_at_value;
+    w->site_net = fault->net;
+    int root_op = -1;
+    if (fault->gate < 0) {
+        w->stem_net = fault->net;
+        w->branch_pin = -1;
+    } else {
+        w->stem_net = -1;
+        root_op = prog->gate_op[fault->gate];
+        w->branch_pin = prog->in_start[root_op] + fault->pin;
+    }
+    // Fanout cone: breadth-first over the fanout CSR, then into program
+    // (topological) order
+    w->num_cone = 0;
+    if (root_op >= 0) {
+        w->in_cone[root_op] = 1;
+        w->cone[w->num_cone++] = root_op;
+    } else {
+        for (int e = prog->fanout_start[fault->net]; e < prog->fanout_start[fault->net + 1]; e++) {
+            int k = prog->fanout[e];
+            if (w->in_cone[k]) continue;
+            w->in_cone[k] = 1;
+            w->cone[w->num_cone++] = k;
+        }
+    }
+    for (int c = 0; c < w->num_cone; c++) {
+        int out = prog->out[w->cone[c]];
+        for (int e = prog->fanout_start[out]; e < prog->fanout_start[out + 1]; e++) {
+            int k = prog->fanout[e];
+            if (w->in_cone[k]) continue;
+            w->in_cone[k] = 1;
+            w->cone[w->num_cone++] = k;
+        }
+    }
+    qsort(w->cone, w->num_cone, sizeof(int), compare_ints);
+    for (int c = 0; c < w->num_cone; c++) w->cone_index[w->cone[c]] = c;
+    if (w->stem_net >= 0) {
+        set_net(w, w->stem_net, X, (uint8_t)w->stuck_at);
+    } else if (!w->queued[root_op]) {
+        w->queued[root_op] = 1;
+        w->queue[w->queue_fill[w->op_level[root_op]]++] = root_op;
+    }
+    imply(w);
+}
+
+// Helper: Return every net to X for the next fault
+static void worker_end_fault(PodemWorker* w) {
+    for (int t = 0; t < w->num_touched; t++) {
+        int net = w->touched[t];
+        w->good[net] = w->faulty[net] = X;
+        w->is_touched[net] = 0;
+    }
+    w->num_touched = 0;
+    for (int c = 0; c < w->num_cone; c++) w->in_cone[w->cone[c]] = 0;
+    w->num_cone = 0;
+}
+
+// Helper: Value a fanin entry carries into its op in the faulty machine
+static inline uint8_t faulty_pin(const PodemWorker* w, int entry) {
+    return entry == w->branch_pin ? (uint8_t)w->stuck_at : w->faulty[w->circuit->program.in[entry]];
+}
+
+typedef enum { SEARCH_FAILED, SEARCH_OPEN, SEARCH_DETECTED } SearchState;
+
+// Helper: Check the current assignment. An open search also gets the op of
+// the D-frontier to push the fault effect through, or -1 to activate first.
+// Frontier ops count only with an X-path: a chain of X nets to an output.
+static SearchState check_state(PodemWorker* w, int* frontier) {
+    const EvalProgram* prog = &w->circuit->program;
+    int site = w->site_net;
+    if (w->stem_net >= 0 && w->is_output[site] && five_valued(w->good[site], w->faulty[site]) >= D) return SEARCH_DETECTED;
+    if (w->good[site] == (uint8_t)w->stuck_at) return SEARCH_FAILED;
+    *frontier = -1;
+    // Readers of a cone net are in the cone and later in program order, so
+    // a reverse sweep sees them first; the first frontier op is the deepest
+    for (int c = w->num_cone - 1; c >= 0; c--) {
+        int k = w->cone[c];
+        int out = prog->out[k];
+        LogicValue value = five_valued(w->good[out], w->faulty[out]);
+        w->x_path[c] = 0;
+        if (value >= D && w->is_output[out]) return SEARCH_DETECTED;
+        if (value != X || prog->op[k] == OP_UNSUPPORTED) continue;
+        bool x_path = w->is_output[out];
+        for (int e = prog->fanout_start[out]; !x_path && e < prog->fanout_start[out + 1]; e++) {
+            x_path = w->x_path[w->cone_index[prog->fanout[e]]];
+        }
+        w->x_path[c] = x_path;
+        if (!x_path || *frontier >= 0 || w->good[site] == X) continue;
+        for (int e = prog->in_start[k]; e < prog->in_start[k + 1]; e++) {
+            if (five_valued(w->good[prog->in[e]], faulty_pin(w, e)) >= D) {
+                *frontier = k;
+                break;
+            }
+        }
+    }
+    if (w->good[site] == X) {
+        // Not activated yet: the effect would enter at the site's readers
+        if (w->stem_net < 0) return w->x_path[0] ? SEARCH_OPEN : SEARCH_FAILED; // the faulty op leads the cone
+        if (w->is_output[site]) return SEARCH_OPEN;
+        for (int e = prog->fanout_start[site]; e < prog->fanout_start[site + 1]; e++) {
+            if (w->x_path[w->cone_index[prog->fanout[e]]]) return SEARCH_OPEN;
+        }
+        return SEARCH_FAILED;
+    }
+    return *frontier >= 0 ? SEARCH_OPEN : SEARCH_FAILED;
+}
+
+// Helper: Value of an op's inputs that does not decide its output
+static uint8_t non_controlling(int op) {
+    return op == OR || op == NOR ? ZERO : ONE;
+}
+
+static bool inverting(int op) {
+    return op == NAND || op == NOR || op == NOT || op == XNOR;
+}
+
+// Helper: Trace an objective back to a primary input assignment, choosing an
+// X input at each op: the easiest (lowest level) if one input can set the
+// output, the hardest if all of them have to. Returns the input index, or
+// -1 if the trace ends on a net no input controls.
+static int backtrace(const PodemWorker* w, int net, uint8_t value, uint8_t* input_value) {
+    const Circuit* circuit = w->circuit;
+    const EvalProgram* prog = &circuit->program;
+    while (w->input_index[net] < 0) {
+        if (net >= circuit->nets.count || circuit->net_driver[net] < 0) return -1;
+        int k = prog->gate_op[circuit->net_driver[net]];
+        if (k < 0 || prog->op[k] == OP_UNSUPPORTED) return -1;
+        int op = prog->op[k];
+        uint8_t in_value = inverting(op) ? (uint8_t)(value ^ 1) : value;
+        bool all_needed = op == XOR || op == XNOR || in_value == non_controlling(op);
+        int chosen = -1;
+        for (int e = prog->in_start[k]; e < prog->in_start[k + 1]; e++) {
+            int in = prog->in[e];
+            if (w->good[in] != X && faulty_pin(w, e) != X) continue;
+            if (chosen < 0 || (all_needed ? prog->net_level[in] > prog->net_level[chosen]
+                                          : prog->net_level[in] < prog->net_level[chosen])) chosen = in;
+        }
+        if (chosen < 0) return -1;
+        if (op == XOR || op == XNOR) {
+            // Aim for the parity the known inputs leave open
+            for (int e = prog->in_start[k]; e < prog->in_start[k + 1]; e++) {
+                if (prog->in[e] != chosen && w->good[prog->in[e]] == ONE) in_value ^= 1;
+            }
+        }
+        net = chosen;
+        value = in_value;
+    }
+    *input_value = value;
+    return w->input_index[net];
+}
+
+// Run PODEM for one fault; a test leaves its input values in 'cube'
+static PodemResult podem(PodemWorker* w, const Fault* fault, int backtrack_limit, uint8_t* cube) {
+    const EvalProgram* prog = &w->circuit->program;
+    worker_begin_fault(w, fault);
+    int depth = 0;
+    int backtracks = 0;
+    bool complete = true;   // every failure so far was proven, not given up on
+    PodemResult result;
+    for (;;) {
+        int frontier;
+        SearchState state = check_state(w, &frontier);
+        if (state == SEARCH_DETECTED) {
+            result = PODEM_TESTED;
+            break;
+        }
+        if (state == SEARCH_OPEN) {
+            int objective_net;
+            uint8_t objective_value;
+            if (frontier < 0) {
+                objective_net = w->site_net;
+                objective_value = (uint8_t)(w->stuck_at ^ 1);
+            } else {
+                // Set an X input of the frontier op to its non-controlling value
+                objective_net = -1;
+                for (int e = prog->in_start[frontier]; e < prog->in_start[frontier + 1]; e++) {
+                    int in = prog->in[e];
+                    if (w->good[in] == X || faulty_pin(w, e) == X) {
+                        objective_net = in;
+                        break;
+                    }
+                }
+                int op = prog->op[frontier];
+                objective_value = op == XOR || op == XNOR ? ZERO : non_controlling(op);
+            }
+            uint8_t value;
+            int input = objective_net >= 0 ? backtrace(w, objective_net, objective_value, &value) : -1;
+            if (input >= 0) {
+                w->decision_input[depth] = input;
+                w->decision_flipped[depth] = 0;
+                depth++;
+                assign_input(w, input, value);
+                continue;
+            }
+            // No input reaches the objective: this branch is given up, not refuted
+            complete = false;
+        }
+        // Backtrack: flip the deepest decision not flipped yet, undo the rest
+        while (depth > 0 && w->decision_flipped[depth - 1]) {
+            assign_input(w, w->decision_input[--depth], X);
+        }
+        if (depth == 0) {
+            result = complete ? PODEM_REDUNDANT : PODEM_ABORTED;
+            break;
+        }
+        if (++backtracks > backtrack_limit) {
+            result = PODEM_ABORTED;
+            break;
+        }
+        int input = w->decision_input[depth - 1];
+        w->decision_flipped[depth - 1] = 1;
+        assign_input(w, input, (uint8_t)(w->good[w->circuit->primary_inputs[input]] ^ 1));
+    }
+    if (result == PODEM_TESTED) {
+        for (int i = 0; i < w->circuit->num_primary_inputs; i++) cube[i] = w->good[w->circuit->primary_inputs[i]];
+    }
+    worker_end_fault(w);
+    return result;
+}
+
+// Work item: one target fault of the current batch
+typedef struct {
+    const Circuit* circuit;
+    PodemWorker* workers;
+    const int* targets;
+    PodemResult* results;
+    uint8_t* cubes;           // num_primary_inputs values per target
+    int backtrack_limit;
+} AtpgTask;
+
+static void atpg_task(void* ctx, int thread_id, int item) {
+    AtpgTask* task = (AtpgTask*)ctx;
+    const Circuit* circuit = task->circuit;
+    task->results[item] = podem(&task->workers[thread_id], &circuit->faults[task->targets[item]], task->backtrack_limit,
+                                task->cubes + (size_t)item * circuit->num_primary_inputs);
+}
+
+// Helper: Random fill bits for the X inputs of one test (splitmix64), so
+// the fill depends on the seed and the fault, not on thread timing
+static uint64_t fill_bits(uint64_t seed, int fault, int word) {
+    return splitmix64(seed + 0x9e3779b97f4a7c15ull * ((uint64_t)fault * 1315423911u + (uint64_t)word + 1));
+}
+
+int run_atpg(const char* engine, Circuit* circuit, const SimOptions* options, const AtpgOptions* atpg,
+             int first_vector, const char* vectors_filename) {
+    int num_inputs = circuit->num_primary_inputs;
+    int num_classes = circuit->num_faults + circuit->num_dominated_faults;
+    int num_threads = options->num_threads > 1 ? options->num_threads : 1;
+    int batch_size = 16 * num_threads < 64 ? 16 * num_threads : 64;
+    printf("\nRunning PODEM test generation (backtrack limit %d, %d thread%s)...\n", atpg->backtrack_limit,
+           num_threads, num_threads > 1 ? "s" : "");
+
+    const EvalProgram* prog = &circuit->program;
+    int* op_level = (int*)malloc((prog->num_ops + 1) * sizeof(int));
+    for (int l = 0; l < prog->num_levels; l++) {
+        for (int k = prog->level_start[l]; k < prog->level_start[l + 1]; k++) op_level[k] = l;
+    }
+    bool* is_output = (bool*)calloc(circuit->nets.count + 1, sizeof(bool));
+    for (int i = 0; i < circuit->num_primary_outputs; i++) is_output[circuit->primary_outputs[i]] = true;
+    int* input_index = (int*)malloc((circuit->nets.count + 1) * sizeof(int));
+    for (int n = 0; n <= circuit->nets.count; n++) input_index[n] = -1;
+    for (int i = 0; i < num_inputs; i++) input_index[circuit->primary_inputs[i]] = i;
+
+    AtpgTask task;
+    task.circuit = circuit;
+    task.workers = (PodemWorker*)malloc(num_threads * sizeof(PodemWorker));
+    for (int t = 0; t < num_threads; t++) worker_init(&task.workers[t], circuit, is_output, input_index, op_level);
+    int* targets = (int*)malloc(batch_size * sizeof(int));
+    task.targets = targets;
+    task.results = (PodemResult*)malloc(batch_size * sizeof(PodemResult));
+    task.cubes = (uint8_t*)malloc((size_t)batch_size * num_inputs + 1);
+    task.backtrack_limit = atpg->backtrack_limit;
+
+    // Generated tests, packed 64 to a block like any vector set
+    size_t block_capacity = 16;
+    uint64_t* tests = (uint64_t*)malloc(block_capacity * (num_inputs + 1) * sizeof(uint64_t));
+    int num_tests = 0;
+    uint64_t* batch_words = (uint64_t*)malloc((num_inputs + 1) * sizeof(uint64_t));
+    int* batch_fault = (int*)malloc(batch_size * sizeof(int));
+    int* remap = (int*)malloc(batch_size * sizeof(int));
+    bool* was_detected = (bool*)malloc((num_classes + 1) * sizeof(bool));
+    TestVectors batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.num_inputs = num_inputs;
+    batch.packed = batch_words;
+    SimOptions batch_options = *options;
+    batch_options.quiet = true;
+
+    int num_redundant = 0, num_aborted = 0, num_generated = 0;
+    int next = 0;
+    for (;;) {
+        int count = 0;
+        while (next < num_classes && count < batch_size) {
+            const Fault* fault = &circuit->faults[next];
+            if (!fault->detected && !fault->redundant) targets[count++] = next;
+            next++;
+        }
+        if (count == 0) break;
+        parallel_for(count, num_threads, atpg_task, &task);
+
+        // Pack the tests, filling X inputs at random
+        int num_batch = 0;
+        memset(batch_words, 0, num_inputs * sizeof(uint64_t));
+        for (int t = 0; t < count; t++) {
+            if (task.results[t] == PODEM_REDUNDANT) {
+                circuit->faults[targets[t]].redundant = true;
+                num_redundant++;
+            }
+            if (task.results[t] == PODEM_ABORTED) num_aborted++;
+            if (task.results[t] != PODEM_TESTED) continue;
+            const uint8_t* cube = task.cubes + (size_t)t * num_inputs;
+            uint64_t fill = 0;
+            for (int i = 0; i < num_inputs; i++) {
+                if (i % 64 == 0) fill = fill_bits(atpg->seed, targets[t], i / 64);
+                uint64_t bit = cube[i] == X ? (fill >> (i % 64)) & 1 : cube[i];
+                batch_words[i] |= bit << num_batch;
+            }
+            batch_fault[num_batch++] = targets[t];
+        }
+        num_generated += num_batch;
+        if (num_batch == 0) continue;
+
+        // Fault simulate the batch; keep the tests that detect a fault first
+        batch.num_vectors = num_batch;
+        batch.num_blocks = 1;
+        for (int f = 0; f < num_classes; f++) was_detected[f] = circuit->faults[f].detected;
+        run_fault_simulation(engine, circuit, &batch, &batch_options);
+        for (int v = 0; v < num_batch; v++) remap[v] = -1;
+        for (int f = 0; f < num_classes; f++) {
+            if (circuit->faults[f].detected && !was_detected[f]) remap[circuit->faults[f].first_detected_vector] = 0;
+        }
+        for (int v = 0; v < num_batch; v++) {
+            if (!circuit->faults[batch_fault[v]].detected) {
+                fprintf(stderr, "Warning: the test generated for fault %d does not detect it\n", batch_fault[v]);
+            }
+            if (remap[v] < 0) continue;
+            remap[v] = first_vector + num_tests;
+            if ((size_t)num_tests / 64 == block_capacity) {
+                block_capacity *= 2;
+                tests = (uint64_t*)realloc(tests, block_capacity * (num_inputs + 1) * sizeof(uint64_t));
+            }
+            uint64_t* block = tests + (size_t)(num_tests / 64) * num_inputs;
+            if (num_tests % 64 == 0) memset(block, 0, num_inputs * sizeof(uint64_t));
+            for (int i = 0; i < num_inputs; i++) block[i] |= ((batch_words[i] >> v) & 1) << (num_tests % 64);
+            num_tests++;
+        }
+        for (int f = 0; f < num_classes; f++) {
+            Fault* fault = &circuit->faults[f];
+            if (fault->detected && !was_detected[f]) fault->first_detected_vector = remap[fault->first_detected_vector];
+        }
+    }
+
+    TestVectors generated;
+    memset(&generated, 0, sizeof(generated));
+    generated.num_inputs = num_inputs;
+    generated.num_vectors = num_tests;
+    generated.num_blocks = (num_tests + 63) / 64;
+    generated.packed = tests;
+    int status = write_test_vectors(&generated, vectors_filename);
+    if (status != 0) fprintf(stderr, "Failed to write generated tests.\n");
+    else {
+        printf("PODEM: %d tests generated, %d kept after fault simulation and written to %s; "
+               "%d faults proven redundant, %d aborted.\n",
+               num_generated, num_tests, vectors_filename, num_redundant, num_aborted);
+    }
+
+    for (int t = 0; t < num_threads; t++) worker_free(&task.workers[t]);
+    free(task.workers);
+    free(targets);
+    free(task.results);
+    free(task.cubes);
+    free(tests);
+    free(batch_words);
+    free(batch_fault);
+    free(remap);
+    free(was_detected);
+    free(input_index);
+    free(is_output);
+    free(op_level);
+    return status == 0 ? num_tests : -1;
+}
@@ -0,0 +1,52 @@
+#ifndef BENCH_RNG_H
+#define BENCH_RNG_H
+
+#include <stdint.h>
+
+// Seeded xoshiro256** generator shared by the benchmark generators, so a
+// given seed produces the same netlist and vectors on every platform
+
+typedef struct {
+    uint64_t s[4];
+} BenchRng;
+
+static inline uint64_t rng_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// Helper: splitmix64 step, used to expand the seed
+static inline uint64_t rng_splitmix(uint64_t* x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static inline void rng_seed(BenchRng* rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) rng->s[i] = rng_splitmix(&seed);
+}
+
+static inline uint64_t rng_next(BenchRng* rng) {
+    uint64_t* s = rng->s;
+    uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return result;
+}
+
+// Uniform integer in [0, n)
+static inline uint64_t rng_below(BenchRng* rng, uint64_t n) {
+    return (uint64_t)(((unsigned __int128)rng_next(rng) * n) >> 64);
+}
+
+// Uniform double in [0, 1)
+static inline double rng_unit(BenchRng* rng) {
+    return (rng_next(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+#endif // BENCH_RNG_H
@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "bench_rng.h"
+
+// Random netlist generator for benchmarking.
+// Gates are spread evenly over 'depth' levels. Every gate takes its first
+// input from the level just below it, so the circuit has exactly that depth,
+// and its other inputs from a window of recent levels. With probability
+// 'skew' an input is instead copied from a random earlier pin, which picks
+// nets in proportion to their fanout and gives the heavy-tailed fanout of
+// real designs. Nets nobody reads become primary outputs. Flip-flops, when
+// requested, are extra level-0 sources whose D inputs are random gates.
+//
+// Output is structural Verilog, or ISCAS .bench when the file name ends in
+// ".bench".
+
+static const char* const MIX_NAMES[] = { "and", "nand", "or", "nor", "xor", "xnor", "not", "buf" };
+static const char* const BENCH_NAMES[] = { "AND", "NAND", "OR", "NOR", "XOR", "XNOR", "NOT", "BUFF" };
+#define NUM_KINDS 8
+
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [options] <output.v|output.bench>\n", program);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  -g <gates>    Logic gates (default 1000; suffixes k and M)\n");
+    fprintf(stderr, "  -i <inputs>   Primary inputs (default 64)\n");
+    fprintf(stderr, "  -d <depth>    Logic levels (default 32)\n");
+    fprintf(stderr, "  -k <fanin>    Maximum inputs per gate (default 4)\n");
+    fprintf(stderr, "  -w <levels>   Window of earlier levels for the other inputs (default 4)\n");
+    fprintf(stderr, "  -p <skew>     Probability of a fanout-proportional input pick, 0..1 (default 0.2)\n");
+    fprintf(stderr, "  -m <mix>      Gate mix weights, e.g. and=3,nand=3,or=3,nor=3,xor=1,xnor=1,not=2,buf=1\n");
+    fprintf(stderr, "  -r <flops>    Flip-flops (default 0: combinational)\n");
+    fprintf(stderr, "  -s <seed>     Random seed (default 1)\n");
+}
+
+// Helper: Parse a count with an optional k/M suffix
+static long parse_count(const char* text) {
+    char* end;
+    double value = strtod(text, &end);
+    if (*end == 'k' || *end == 'K') value *= 1e3;
+    else if (*end == 'm' || *end == 'M') value *= 1e6;
+    return (long)value;
+}
+
+// Helper: Parse "name=weight,..." into the weight table
+static bool parse_mix(const char* text, double* weights) {
+    for (int t = 0; t < NUM_KINDS; t++) weights[t] = 0.0;
+    while (*text) {
+        const char* eq = strchr(text, '=');
+        if (!eq) return false;
+        int kind = -1;
+        for (int t = 0; t < NUM_KINDS; t++) {
+            if (strlen(MIX_NAMES[t]) == (size_t)(eq - text) && strncmp(text, MIX_NAMES[t], eq - text) == 0) kind = t;
+        }
+        if (kind < 0) return false;
+        char* end;
+        weights[kind] = strtod(eq + 1, &end);
+        text = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',') return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    long num_gates = 1000, num_inputs = 64, depth = 32, max_fanin = 4, window = 4, num_flops = 0;
+    double skew = 0.2;
+    uint64_t seed = 1;
+    double weights[NUM_KINDS] = { 3, 3, 3, 3, 1, 1, 2, 1 };
+    int argi = 1;
+    while (argi + 1 < argc && argv[argi][0] == '-') {
+        const char* value = argv[argi + 1];
+        switch (argv[argi][1]) {
+            case 'g': num_gates = parse_count(value); break;
+            case 'i': num_inputs = parse_count(value); break;
+            case 'd': depth = parse_count(value); break;
+            case 'k': max_fanin = parse_count(value); break;
+            case 'w': window = parse_count(value); break;
+            case 'p': skew = atof(value); break;
+            case 'r': num_flops = parse_count(value); break;
+            case 's': seed = strtoull(value, NULL, 10); break;
+            case 'm':
+                if (!parse_mix(value, weights)) {
+                    fprintf(stderr, "Error: bad gate mix '%s'\n", value);
+                    return 1;
+                }
+                break;
+            default: print_usage(argv[0]); return 1;
+        }
+        argi += 2;
+    }
+    if (argc - argi != 1 || num_gates < 1 || num_inputs < 1 || depth < 1 || max_fanin < 2 || window < 1 || num_flops < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (depth > num_gates) depth = num_gates;
+    double total_weight = 0.0;
+    for (int t = 0; t < NUM_KINDS; t++) total_weight += weights[t];
+    if (total_weight <= 0.0) {
+        fprintf(stderr, "Error: gate mix has no positive weight\n");
+        return 1;
+    }
+    BenchRng rng;
+    rng_seed(&rng, seed);
+
+    // Nets: inputs, flip-flop outputs, then one per gate in level order
+    long num_sources = num_inputs + num_flops;
+    long num_nets = num_sources + num_gates;
+    long* level_start = (long*)malloc((depth + 2) * sizeof(long));
+    level_start[0] = 0;
+    for (long l = 1; l <= depth; l++) level_start[l] = num_sources + (num_gates * (l - 1)) / depth;
+    level_start[depth + 1] = num_nets;
+    uint8_t* kind = (uint8_t*)malloc(num_gates);
+    long* fanin_start = (long*)malloc((num_gates + 1) * sizeof(long));
+    long* fanin = (long*)malloc((num_gates * max_fanin + 1) * sizeof(long));
+    uint32_t* fanout = (uint32_t*)calloc(num_nets, sizeof(uint32_t));
+    long num_pins = 0;
+    for (long l = 1; l <= depth; l++) {
+        long low = level_start[l - window > 0 ? l - window : 0];
+        long below = level_start[l - 1];
+        for (long n = level_start[l]; n < level_start[l + 1]; n++) {
+            long g = n - num_sources;
+            double pick = rng_unit(&rng) * total_weight;
+            int t = 0;
+            while (t < NUM_KINDS - 1 && pick >= weights[t]) pick -= weights[t++];
+            while (t > 0 && weights[t] <= 0.0) t--;
+            kind[g] = (uint8_t)t;
+            int arity = t >= 6 ? 1 : 2 + (int)rng_below(&rng, max_fanin - 1);
+            fanin_start[g] = num_pins;
+            for (int j = 0; j < arity; j++) {
+                long net = -1;
+                for (int attempt = 0; attempt < 8; attempt++) {
+                    if (j == 0) net = below + (long)rng_below(&rng, level_start[l] - below);
+                    else if (fanin_start[g] > 0 && rng_unit(&rng) < skew) net = fanin[rng_below(&rng, fanin_start[g])];
+                    else net = low + (long)rng_below(&rng, level_start[l] - low);
+                    bool repeated = false;
+                    for (long e = fanin_start[g]; e < num_pins; e++) repeated |= fanin[e] == net;
+                    if (!repeated) break;
+                    net = -1;
+                }
+                if (net < 0) continue;
+                fanin[num_pins++] = net;
+                fanout[net]++;
+            }
+        }
+    }
+    fanin_start[num_gates] = num_pins;
+    long* flop_d = (long*)malloc((num_flops + 1) * sizeof(long));
+    for (long f = 0; f < num_flops; f++) {
+        flop_d[f] = num_sources + (long)rng_below(&rng, num_gates);
+        fanout[flop_d[f]]++;
+    }
+
+    const char* filename = argv[argi];
+    size_t name_len = strlen(filename);
+    bool bench = name_len > 6 && strcmp(filename + name_len - 6, ".bench") == 0;
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        perror("Error opening output file");
+        return 1;
+    }
+    char name[32];
+    #define NET_NAME(n) ((n) < num_inputs ? (snprintf(name, sizeof(name), "I%ld", (n)), name) : \
+                         (n) < num_sources ? (snprintf(name, sizeof(name), "Q%ld", (n) - num_inputs), name) : \
+                         (snprintf(name, sizeof(name), "n%ld", (n) - num_sources), name))
+    long num_outputs = 0;
+    if (bench) {
+        fprintf(file, "# %ld gates, %ld inputs, %ld flip-flops, depth %ld, seed %llu\n",
+                num_gates, num_inputs, num_flops, depth, (unsigned long long)seed);
+        for (long n = 0; n < num_inputs; n++) fprintf(file, "INPUT(%s)\n", NET_NAME(n));
+        for (long n = num_sources; n < num_nets; n++) {
+            if (fanout[n] == 0) {
+                fprintf(file, "OUTPUT(%s)\n", NET_NAME(n));
+                num_outputs++;
+            }
+        }
+        for (long f = 0; f < num_flops; f++) {
+            fprintf(file, "%s = DFF(", NET_NAME(num_inputs + f));
+            fprintf(file, "%s)\n", NET_NAME(flop_d[f]));
+        }
+        for (long g = 0; g < num_gates; g++) {
+            fprintf(file, "%s = %s(", NET_NAME(num_sources + g), BENCH_NAMES[kind[g]]);
+            for (long e = fanin_start[g]; e < fanin_start[g + 1]; e++) {
+                fprintf(file, "%s%s", e > fanin_start[g] ? ", " : "", NET_NAME(fanin[e]));
+            }
+            fprintf(file, ")\n");
+        }
+    } else {
+        fprintf(file, "// %ld gates, %ld inputs, %ld flip-flops, depth %ld, seed %llu\n",
+                num_gates, num_inputs, num_flops, depth, (unsigned long long)seed);
+        fprintf(file, "module bench (");
+        for (long n = 0; n < num_inputs; n++) fprintf(file, "%s%s", n > 0 ? ", " : "", NET_NAME(n));
+        for (long n = num_sources; n < num_nets; n++) {
+            if (fanout[n] == 0) fprintf(file, ", %s", NET_NAME(n));
+        }
+        fprintf(file, ");\n");
+        for (long n = 0; n < num_inputs; n++) fprintf(file, "input %s;\n", NET_NAME(n));
+        for (long n = num_sources; n < num_nets; n++) {
+            if (fanout[n] == 0) {
+                fprintf(file, "output %s;\n", NET_NAME(n));
+                num_outputs++;
+            }
+        }
+        for (long g = 0; g < num_gates; g++) {
+            fprintf(file, "%s g%ld (%s", MIX_NAMES[kind[g]], g, NET_NAME(num_sources + g));
+            for (long e = fanin_start[g]; e < fanin_start[g + 1]; e++) fprintf(file, ", %s", NET_NAME(fanin[e]));
+            fprintf(file, ");\n");
+        }
+        for (long f = 0; f < num_flops; f++) {
+            fprintf(file, "dff ff%ld (%s", f, NET_NAME(num_inputs + f));
+            fprintf(file, ", %s);\n", NET_NAME(flop_d[f]));
+        }
+        fprintf(file, "endmodule\n");
+    }
+    #undef NET_NAME
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) ok = false;
+    if (!ok) {
+        perror("Error writing output file");
+        return 1;
+    }
+    printf("Wrote %s: %ld gates, %ld inputs, %ld outputs, %ld flip-flops, depth %ld\n",
+           filename, num_gates, num_inputs, num_outputs, num_flops, depth);
+    free(flop_d);
+    free(fanout);
+    free(fanin);
+    free(fanin_start);
+    free(kind);
+    free(level_start);
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "bench_rng.h"
+
+// Seeded random test vector generator for benchmarking. Writes the simulator's
+// text format, one vector per line with one 0/1 per input and no separators.
+// Pass the output through `fault_simulator.exe --pack-vectors` for the packed
+// binary format.
+
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [options] <inputs> <vectors> <output.txt>\n", program);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  -p <prob>     Probability of a 1 on each input (default 0.5)\n");
+    fprintf(stderr, "  -s <seed>     Random seed (default 1)\n");
+}
+
+int main(int argc, char* argv[]) {
+    double probability = 0.5;
+    uint64_t seed = 1;
+    int argi = 1;
+    while (argi + 1 < argc && argv[argi][0] == '-') {
+        if (strcmp(argv[argi], "-p") == 0) probability = atof(argv[argi + 1]);
+        else if (strcmp(argv[argi], "-s") == 0) seed = strtoull(argv[argi + 1], NULL, 10);
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+        argi += 2;
+    }
+    if (argc - argi != 3 || atol(argv[argi]) < 1 || atol(argv[argi + 1]) < 0 || probability < 0.0 || probability > 1.0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    long num_inputs = atol(argv[argi]);
+    long num_vectors = atol(argv[argi + 1]);
+    FILE* file = fopen(argv[argi + 2], "w");
+    if (!file) {
+        perror("Error opening output file");
+        return 1;
+    }
+    BenchRng rng;
+    rng_seed(&rng, seed);
+    // A 64-bit draw below the threshold is a 1; p = 0.5 takes one bit per input
+    uint64_t threshold = probability >= 1.0 ? UINT64_MAX : (uint64_t)(probability * 18446744073709551616.0);
+    char* line = (char*)malloc(num_inputs + 2);
+    for (long v = 0; v < num_vectors; v++) {
+        uint64_t bits = 0;
+        for (long i = 0; i < num_inputs; i++) {
+            if (probability == 0.5) {
+                if ((i & 63) == 0) bits = rng_next(&rng);
+                line[i] = (char)('0' + ((bits >> (i & 63)) & 1));
+            } else {
+                line[i] = rng_next(&rng) < threshold || probability >= 1.0 ? '1' : '0';
+            }
+        }
+        line[num_inputs] = '\n';
+        fwrite(line, 1, num_inputs + 1, file);
+    }
+    free(line);
+    int status = ferror(file) ? 1 : 0;
+    if (fclose(file) != 0) status = 1;
+    if (status) perror("Error writing output file");
+    return status;
+}
@@ -0,0 +1,320 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <math.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+// Benchmark harness. For every circuit size and engine it generates (once,
+// cached in the work directory) a seeded random netlist and vector set, runs
+// the simulator as a child process and reports wall time, the simulator's
+// own per-phase times, simulation throughput in gate-vectors per second and
+// the child's peak resident set size (from wait4). Results can be written as
+// CSV and compared against an earlier CSV to flag regressions.
+
+#define MAX_ITEMS 32
+#define MAX_EXTRA_ARGS 16
+
+typedef struct {
+    const char* engine;
+    long gates;
+    long vectors;
+    bool ok;
+    const char* status;     // "ok", "timeout", "failed"
+    double wall;
+    double setup, load, simulate, report;
+    long peak_rss_kb;
+} BenchResult;
+
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [options]\n", program);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  -s <sizes>    Gate counts, comma separated (default 1k,10k,100k,1M,10M)\n");
+    fprintf(stderr, "  -e <engines>  deductive, ppsfp and/or sequential (default deductive,ppsfp)\n");
+    fprintf(stderr, "  -v <vectors>  Vectors per run (default 1024)\n");
+    fprintf(stderr, "  -j <threads>  Simulator threads (default 1)\n");
+    fprintf(stderr, "  -t <seconds>  Time limit per run (default 600)\n");
+    fprintf(stderr, "  -a <arg>      Extra simulator argument, repeatable (e.g. -a --no-drop)\n");
+    fprintf(stderr, "  -x <path>     Simulator binary (default ./fault_simulator)\n");
+    fprintf(stderr, "  -g <dir>      Directory holding gen_netlist and gen_vectors (default .)\n");
+    fprintf(stderr, "  -w <dir>      Work directory for generated inputs and logs (default bench_work)\n");
+    fprintf(stderr, "  -r <seed>     Random seed (default 1)\n");
+    fprintf(stderr, "  -o <csv>      Write results as CSV\n");
+    fprintf(stderr, "  -c <csv>      Compare simulate times with an earlier CSV\n");
+    fprintf(stderr, "  -T <ratio>    Slowdown that counts as a regression (default 1.10)\n");
+}
+
+static double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Helper: Parse a count with an optional k/M suffix
+static long parse_count(const char* text) {
+    char* end;
+    double value = strtod(text, &end);
+    if (*end == 'k' || *end == 'K') value *= 1e3;
+    else if (*end == 'm' || *end == 'M') value *= 1e6;
+    return (long)value;
+}
+
+// Helper: Split a comma separated list in place
+static int split_list(char* text, char** items) {
+    int count = 0;
+    for (char* token = strtok(text, ","); token && count < MAX_ITEMS; token = strtok(NULL, ",")) items[count++] = token;
+    return count;
+}
+
+// Helper: Run a program with stdout and stderr sent to 'log_filename'.
+// Returns the exit status (-1 on failure to start, -2 on timeout).
+static int run_process(char* const argv[], const char* log_filename, int time_limit, struct rusage* usage) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (pid == 0) {
+        int fd = open(log_filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        if (time_limit > 0) alarm(time_limit); // survives exec
+        execv(argv[0], argv);
+        perror(argv[0]);
+        _exit(127);
+    }
+    int status;
+    if (wait4(pid, &status, 0, usage) < 0) {
+        perror("wait4");
+        return -1;
+    }
+    if (WIFSIGNALED(status)) return WTERMSIG(status) == SIGALRM ? -2 : -1;
+    return WEXITSTATUS(status);
+}
+
+static bool file_exists(const char* filename) {
+    struct stat st;
+    return stat(filename, &st) == 0;
+}
+
+// Circuit shape for a gate count: wider and deeper as it grows
+static long inputs_for(long gates) {
+    long inputs = (long)(2 * sqrt((double)gates));
+    return inputs < 32 ? 32 : inputs > 2048 ? 2048 : inputs;
+}
+
+static long depth_for(long gates) {
+    long depth = (long)(4 * log2((double)gates));
+    return depth < 8 ? 8 : depth;
+}
+
+// Helper: Generate the netlist and vectors for one size unless already there
+static bool prepare_inputs(const char* gen_dir, const char* work_dir, long gates, bool sequential, long vectors,
+                           unsigned long seed, char* netlist, char* vector_file, size_t size) {
+    snprintf(netlist, size, "%s/bench_%ld%s_s%lu.v", work_dir, gates, sequential ? "_seq" : "", seed);
+    snprintf(vector_file, size, "%s/bench_%ld%s_s%lu_%ld.txt", work_dir, gates, sequential ? "_seq" : "", seed, vectors);
+    char program[1024], log_filename[1024], gates_arg[32], inputs_arg[32], depth_arg[32], flops_arg[32], seed_arg[32], vectors_arg[32];
+    snprintf(log_filename, sizeof(log_filename), "%s/generate.log", work_dir);
+    snprintf(gates_arg, sizeof(gates_arg), "%ld", gates);
+    snprintf(inputs_arg, sizeof(inputs_arg), "%ld", inputs_for(gates));
+    snprintf(depth_arg, sizeof(depth_arg), "%ld", depth_for(gates));
+    snprintf(flops_arg, sizeof(flops_arg), "%ld", sequential ? gates / 20 : 0);
+    snprintf(seed_arg, sizeof(seed_arg), "%lu", seed);
+    snprintf(vectors_arg, sizeof(vectors_arg), "%ld", vectors);
+    struct rusage usage;
+    if (!file_exists(netlist)) {
+        printf("Generating %s...\n", netlist);
+        fflush(stdout);
+        snprintf(program, sizeof(program), "%s/gen_netlist", gen_dir);
+        char* argv[] = { program, "-g", gates_arg, "-i", inputs_arg, "-d", depth_arg, "-r", flops_arg, "-s", seed_arg, netlist, NULL };
+        if (run_process(argv, log_filename, 0, &usage) != 0) {
+            fprintf(stderr, "Error: netlist generation failed, see %s\n", log_filename);
+            remove(netlist);
+            return false;
+        }
+    }
+    if (!file_exists(vector_file)) {
+        snprintf(program, sizeof(program), "%s/gen_vectors", gen_dir);
+        char* argv[] = { program, "-s", seed_arg, inputs_arg, vectors_arg, vector_file, NULL };
+        if (run_process(argv, log_filename, 0, &usage) != 0) {
+            fprintf(stderr, "Error: vector generation failed, see %s\n", log_filename);
+            remove(vector_file);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Helper: Pull the simulator's phase times out of its log
+static bool read_phase_times(const char* log_filename, BenchResult* result) {
+    FILE* file = fopen(log_filename, "r");
+    if (!file) return false;
+    char line[512];
+    bool found = false;
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "Phase times: setup %lf s, vectors %lf s, simulate %lf s, report %lf s",
+                   &result->setup, &result->load, &result->simulate, &result->report) == 4) found = true;
+    }
+    fclose(file);
+    return found;
+}
+
+// Helper: Simulate-phase time of a matching run in an earlier CSV, or -1
+static double baseline_time(const char* csv_filename, const char* engine, long gates, long vectors) {
+    FILE* file = fopen(csv_filename, "r");
+    if (!file) return -1.0;
+    char line[512];
+    double time = -1.0;
+    while (fgets(line, sizeof(line), file)) {
+        char row_engine[64], status[32];
+        long row_gates, row_vectors;
+        double wall, setup, load, simulate;
+        if (sscanf(line, "%63[^,],%ld,%ld,%31[^,],%lf,%lf,%lf,%lf", row_engine, &row_gates, &row_vectors, status,
+                   &wall, &setup, &load, &simulate) == 8 &&
+            strcmp(row_engine, engine) == 0 && row_gates == gates && row_vectors == vectors && strcmp(status, "ok") == 0) {
+            time = simulate;
+        }
+    }
+    fclose(file);
+    return time;
+}
+
+int main(int argc, char* argv[]) {
+    char default_sizes[] = "1k,10k,100k,1M,10M";
+    char default_engines[] = "deductive,ppsfp";
+    char* size_list = default_sizes;
+    char* engine_list = default_engines;
+    long num_vectors = 1024;
+    int threads = 1, time_limit = 600;
+    unsigned long seed = 1;
+    const char* simulator = "./fault_simulator";
+    const char* gen_dir = ".";
+    const char* work_dir = "bench_work";
+    const char* csv_filename = NULL;
+    const char* baseline_filename = NULL;
+    double regression_ratio = 1.10;
+    char* extra_args[MAX_EXTRA_ARGS];
+    int num_extra_args = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:e:v:j:t:a:x:g:w:r:o:c:T:")) != -1) {
+        switch (opt) {
+            case 's': size_list = optarg; break;
+            case 'e': engine_list = optarg; break;
+            case 'v': num_vectors = parse_count(optarg); break;
+            case 'j': threads = atoi(optarg); break;
+            case 't': time_limit = atoi(optarg); break;
+            case 'a': if (num_extra_args < MAX_EXTRA_ARGS) extra_args[num_extra_args++] = optarg; break;
+            case 'x': simulator = optarg; break;
+            case 'g': gen_dir = optarg; break;
+            case 'w': work_dir = optarg; break;
+            case 'r': seed = strtoul(optarg, NULL, 10); break;
+            case 'o': csv_filename = optarg; break;
+            case 'c': baseline_filename = optarg; break;
+            case 'T': regression_ratio = atof(optarg); break;
+            default: print_usage(argv[0]); return 1;
+        }
+    }
+    if (optind != argc || num_vectors < 1 || threads < 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    char* sizes[MAX_ITEMS];
+    char* engines[MAX_ITEMS];
+    int num_sizes = split_list(size_list, sizes);
+    int num_engines = split_list(engine_list, engines);
+    mkdir(work_dir, 0755);
+
+    BenchResult* results = (BenchResult*)calloc(num_sizes * num_engines, sizeof(BenchResult));
+    int num_results = 0, num_regressions = 0;
+    printf("%-10s %10s %8s %-8s %9s %9s %9s %9s %9s %12s %10s\n", "engine", "gates", "vectors", "status",
+           "wall s", "setup s", "vectors s", "sim s", "report s", "gate-vec/s", "peak MB");
+    for (int s = 0; s < num_sizes; s++) {
+        long gates = parse_count(sizes[s]);
+        for (int e = 0; e < num_engines; e++) {
+            const char* engine = engines[e];
+            bool sequential = strcmp(engine, "sequential") == 0;
+            char netlist[1024], vector_file[1024], log_filename[1024], threads_arg[16], stats_filename[1024];
+            if (!prepare_inputs(gen_dir, work_dir, gates, sequential, num_vectors, seed, netlist, vector_file, sizeof(netlist))) return 1;
+            snprintf(log_filename, sizeof(log_filename), "%s/run_%s_%ld.log", work_dir, engine, gates);
+            snprintf(stats_filename, sizeof(stats_filename), "%s/stats_%s_%ld.txt", work_dir, engine, gates);
+            snprintf(threads_arg, sizeof(threads_arg), "%d", threads);
+            // Sequential netlists pick their engine by themselves
+            char* sim_argv[2 * MAX_EXTRA_ARGS + 12];
+            int n = 0;
+            sim_argv[n++] = (char*)simulator;
+            if (!sequential) {
+                sim_argv[n++] = "-e";
+                sim_argv[n++] = (char*)engine;
+            }
+            sim_argv[n++] = "-j";
+            sim_argv[n++] = threads_arg;
+            for (int a = 0; a < num_extra_args; a++) sim_argv[n++] = extra_args[a];
+            sim_argv[n++] = netlist;
+            sim_argv[n++] = vector_file;
+            sim_argv[n++] = stats_filename;
+            sim_argv[n] = NULL;
+
+            BenchResult* result = &results[num_results++];
+            result->engine = engine;
+            result->gates = gates;
+            result->vectors = num_vectors;
+            struct rusage usage;
+            double start = wall_seconds();
+            int status = run_process(sim_argv, log_filename, time_limit, &usage);
+            result->wall = wall_seconds() - start;
+            result->peak_rss_kb = usage.ru_maxrss;
+            result->ok = status == 0 && read_phase_times(log_filename, result);
+            result->status = result->ok ? "ok" : status == -2 ? "timeout" : "failed";
+            double throughput = result->ok && result->simulate > 0 ? (double)gates * num_vectors / result->simulate : 0.0;
+            printf("%-10s %10ld %8ld %-8s %9.3f %9.3f %9.3f %9.3f %9.3f %12.3e %10.1f", engine, gates, num_vectors,
+                   result->status, result->wall, result->setup, result->load, result->simulate, result->report,
+                   throughput, result->peak_rss_kb / 1024.0);
+            if (baseline_filename && result->ok) {
+                double baseline = baseline_time(baseline_filename, engine, gates, num_vectors);
+                if (baseline > 0) {
+                    double ratio = result->simulate / baseline;
+                    bool regressed = ratio > regression_ratio;
+                    num_regressions += regressed;
+                    printf("  x%.2f vs baseline%s", ratio, regressed ? "  REGRESSION" : "");
+                }
+            }
+            printf("\n");
+            fflush(stdout);
+        }
+    }
+
+    if (csv_filename) {
+        FILE* file = fopen(csv_filename, "w");
+        if (!file) {
+            perror("Error opening CSV file");
+            return 1;
+        }
+        fprintf(file, "engine,gates,vectors,status,wall_s,setup_s,vectors_s,simulate_s,report_s,gate_vectors_per_s,peak_rss_kb\n");
+        for (int r = 0; r < num_results; r++) {
+            const BenchResult* result = &results[r];
+            double throughput = result->ok && result->simulate > 0 ? (double)result->gates * result->vectors / result->simulate : 0.0;
+            fprintf(file, "%s,%ld,%ld,%s,%.6f,%.6f,%.6f,%.6f,%.6f,%.6e,%ld\n", result->engine, result->gates, result->vectors,
+                    result->status, result->wall, result->setup, result->load, result->simulate, result->report,
+                    throughput, result->peak_rss_kb);
+        }
+        fclose(file);
+        printf("Results written to %s\n", csv_filename);
+    }
+    free(results);
+    if (num_regressions > 0) {
+        printf("%d run%s slower than %.2fx the baseline.\n", num_regressions, num_regressions > 1 ? "s" : "", regression_ratio);
+        return 2;
+    }
+    return 0;
+}
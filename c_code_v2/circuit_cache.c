@@ -0,0 +1,291 @@
+#include "fault_simulator.h"
+#include <stddef.h>
+
+// Precompiled circuit cache. After parsing, levelization and fault
+// collapsing, the circuit can be written out as one binary image: a header
+// with the counts, then every array at a 64-byte aligned offset. Arrays hold
+// IDs and offsets only, never pointers, so the image is relocatable; loading
+// it maps the file and points the circuit's arrays straight into the mapping.
+// Only the fault array is copied, since the engines write detection results
+// into it.
+//
+// The header records the FNV-1a hash of the netlist the image was built from
+// plus the options that shaped it; an image that does not match the current
+// netlist, options or format version is ignored and rebuilt. The IDs inside
+// the arrays are trusted once loaded, so the header also carries a checksum
+// of the whole image: a damaged image is rebuilt rather than simulated.
+
+static const char CACHE_MAGIC[8] = { 'T', 'V', 'C', 'C', 'K', 'T', '1', '\0' };
+#define CACHE_VERSION 3
+#define CACHE_ENDIAN_MARK 0x01020304u
+#define CACHE_ALIGN 64
+
+// Arrays of the image, in file order
+enum {
+    SEC_GATE_TYPE, SEC_GATE_OUTPUT, SEC_FANIN_START, SEC_FANIN, SEC_GATE_NAME, SEC_GATE_NAMES,
+    SEC_NET_POOL, SEC_NET_OFFSETS, SEC_NET_HASHES, SEC_NET_SLOTS,
+    SEC_NET_DRIVER, SEC_NET_FANOUT_START, SEC_NET_FANOUT, SEC_PRIMARY_INPUTS, SEC_PRIMARY_OUTPUTS,
+    SEC_FAULTS, SEC_IMPLIED_BY, SEC_FAULT_CLASSES, SEC_CLASS_START,
+    SEC_OP, SEC_OUT, SEC_GATE_OP, SEC_IN_START, SEC_IN, SEC_LEVEL_START, SEC_NET_LEVEL,
+    SEC_FANOUT_START, SEC_FANOUT,
+    NUM_SECTIONS
+};
+
+// On-disk header: layout checks, counts, the evaluation LUTs and the
+// section table
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_mark;
+    uint64_t source_hash;
+    uint64_t checksum;            // of the image, with this field zero
+    uint32_t flags;
+    uint32_t num_opcodes;
+    uint32_t fault_size;          // sizeof(Fault)
+    uint32_t class_member_size;   // sizeof(FaultClassMember)
+    int32_t num_gates;
+    int32_t num_nets;
+    int32_t num_fanins;
+    int32_t num_net_slots;
+    uint64_t names_size;
+    uint64_t pool_size;
+    int32_t num_primary_inputs;
+    int32_t num_primary_outputs;
+    int32_t num_faults;
+    int32_t num_dominated_faults;
+    int32_t num_uncollapsed_faults;
+    int32_t num_ops;
+    int32_t num_levels;
+    int32_t num_op_inputs;        // program in_start[num_ops]
+    int32_t num_op_fanouts;       // program fanout_start[num_nets + 1]
+    int32_t reserved;
+    uint8_t lut[NUM_OPCODES][3][3];
+    uint8_t lut_final[NUM_OPCODES][3];
+    uint64_t section_offset[NUM_SECTIONS];
+    uint64_t section_bytes[NUM_SECTIONS];
+} CacheHeader;
+
+// Helper: Point each section at the circuit array it holds and give its
+// size in bytes, from the counts in the header
+static void cache_sections(Circuit* c, const CacheHeader* h, void** ptr[NUM_SECTIONS], size_t bytes[NUM_SECTIONS]) {
+    EvalProgram* prog = &c->program;
+    size_t num_classes = (size_t)h->num_faults + h->num_dominated_faults;
+    #define SECTION(id, field, size) do { ptr[id] = (void**)&(field); bytes[id] = (size); } while (0)
+    SECTION(SEC_GATE_TYPE, c->gate_type, (size_t)h->num_gates);
+    SECTION(SEC_GATE_OUTPUT, c->gate_output, (size_t)h->num_gates * sizeof(int));
+    SECTION(SEC_FANIN_START, c->fanin_start, ((size_t)h->num_gates + 1) * sizeof(int));
+    SECTION(SEC_FANIN, c->fanin, (size_t)h->num_fanins * sizeof(int));
+    SECTION(SEC_GATE_NAME, c->gate_name, (size_t)h->num_gates * sizeof(uint32_t));
+    SECTION(SEC_GATE_NAMES, c->gate_names, (size_t)h->names_size);
+    SECTION(SEC_NET_POOL, c->nets.pool, (size_t)h->pool_size);
+    SECTION(SEC_NET_OFFSETS, c->nets.offsets, (size_t)h->num_nets * sizeof(uint32_t));
+    SECTION(SEC_NET_HASHES, c->nets.hashes, (size_t)h->num_nets * sizeof(uint32_t));
+    SECTION(SEC_NET_SLOTS, c->nets.slots, (size_t)h->num_net_slots * sizeof(int));
+    SECTION(SEC_NET_DRIVER, c->net_driver, ((size_t)h->num_nets + 1) * sizeof(int));
+    SECTION(SEC_NET_FANOUT_START, c->net_fanout_start, ((size_t)h->num_nets + 2) * sizeof(int));
+    SECTION(SEC_NET_FANOUT, c->net_fanout, (size_t)h->num_fanins * sizeof(int));
+    SECTION(SEC_PRIMARY_INPUTS, c->primary_inputs, (size_t)h->num_primary_inputs * sizeof(int));
+    SECTION(SEC_PRIMARY_OUTPUTS, c->primary_outputs, (size_t)h->num_primary_outputs * sizeof(int));
+    SECTION(SEC_FAULTS, c->faults, num_classes * sizeof(Fault));
+    SECTION(SEC_IMPLIED_BY, c->implied_by, (size_t)h->num_dominated_faults * sizeof(int));
+    SECTION(SEC_FAULT_CLASSES, c->fault_classes, (size_t)h->num_uncollapsed_faults * sizeof(FaultClassMember));
+    SECTION(SEC_CLASS_START, c->class_start, (num_classes + 1) * sizeof(int));
+    SECTION(SEC_OP, prog->op, (size_t)h->num_ops);
+    SECTION(SEC_OUT, prog->out, (size_t)h->num_ops * sizeof(int));
+    SECTION(SEC_GATE_OP, prog->gate_op, ((size_t)h->num_gates + 1) * sizeof(int));
+    SECTION(SEC_IN_START, prog->in_start, ((size_t)h->num_ops + 1) * sizeof(int));
+    SECTION(SEC_IN, prog->in, (size_t)h->num_op_inputs * sizeof(int));
+    SECTION(SEC_LEVEL_START, prog->level_start, ((size_t)h->num_levels + 1) * sizeof(int));
+    SECTION(SEC_NET_LEVEL, prog->net_level, ((size_t)h->num_nets + 1) * sizeof(int));
+    SECTION(SEC_FANOUT_START, prog->fanout_start, ((size_t)h->num_nets + 2) * sizeof(int));
+    SECTION(SEC_FANOUT, prog->fanout, (size_t)h->num_op_fanouts * sizeof(int));
+    #undef SECTION
+}
+
+// FNV-1a over the whole netlist file
+bool hash_file(const char* filename, uint64_t* hash) {
+    MappedFile file;
+    if (!map_file(filename, &file)) return false;
+    *hash = fnv1a64(FNV1A64_INIT, file.data, file.size);
+    unmap_file(&file);
+    return true;
+}
+
+// Helper: fnv1a64() taken a word at a time, folded so every bit reaches the
+// low half; a byte-wise pass is too slow for a whole image. The image is
+// hashed in the same pieces it is written in
+static uint64_t checksum_update(uint64_t h, const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (; size >= 8; p += 8, size -= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        h = (h ^ word) * 1099511628211ull;
+        h ^= h >> 32;
+    }
+    for (; size > 0; p++, size--) h = (h ^ *p) * 1099511628211ull;
+    return h;
+}
+
+Circuit* load_circuit_cache(const char* filename, uint64_t source_hash, uint32_t flags) {
+    MappedFile image;
+    if (!map_file(filename, &image)) return NULL;
+    const CacheHeader* h = (const CacheHeader*)image.data;
+    if (image.size < sizeof(CacheHeader) || memcmp(h->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        h->version != CACHE_VERSION || h->endian_mark != CACHE_ENDIAN_MARK || h->num_opcodes != NUM_OPCODES ||
+        h->fault_size != sizeof(Fault) || h->class_member_size != sizeof(FaultClassMember)) {
+        fprintf(stderr, "Warning: %s is not a circuit cache for this build; rebuilding it\n", filename);
+        unmap_file(&image);
+        return NULL;
+    }
+    if (h->source_hash != source_hash || h->flags != flags) {
+        printf("Circuit cache %s is out of date; rebuilding it.\n", filename);
+        unmap_file(&image);
+        return NULL;
+    }
+    Circuit* circuit = (Circuit*)calloc(1, sizeof(Circuit));
+    void** ptr[NUM_SECTIONS];
+    size_t bytes[NUM_SECTIONS];
+    cache_sections(circuit, h, ptr, bytes);
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        uint64_t offset = h->section_offset[s];
+        if (h->section_bytes[s] != bytes[s] || offset % CACHE_ALIGN != 0 || offset > image.size || bytes[s] > image.size - offset) {
+            fprintf(stderr, "Warning: circuit cache %s is truncated or corrupt; rebuilding it\n", filename);
+            free(circuit);
+            unmap_file(&image);
+            return NULL;
+        }
+        *ptr[s] = (void*)(image.data + offset);
+    }
+    CacheHeader unsigned_header;
+    memcpy(&unsigned_header, h, sizeof(unsigned_header)); // padding included
+    unsigned_header.checksum = 0;
+    uint64_t checksum = checksum_update(FNV1A64_INIT, &unsigned_header, sizeof(unsigned_header));
+    uint64_t checked = sizeof(CacheHeader);
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        if (h->section_offset[s] < checked) break; // overlapping sections: fails the comparison below
+        checksum = checksum_update(checksum, image.data + checked, h->section_offset[s] - checked);
+        checksum = checksum_update(checksum, image.data + h->section_offset[s], bytes[s]);
+        checked = h->section_offset[s] + bytes[s];
+    }
+    if (checksum != h->checksum) {
+        fprintf(stderr, "Warning: circuit cache %s is truncated or corrupt; rebuilding it\n", filename);
+        free(circuit);
+        unmap_file(&image);
+        return NULL;
+    }
+    circuit->image = image;
+    arena_init(&circuit->arena);
+    circuit->num_gates = h->num_gates;
+    circuit->gate_names_size = h->names_size;
+    circuit->nets.count = h->num_nets;
+    circuit->nets.capacity = h->num_nets;
+    circuit->nets.pool_size = h->pool_size;
+    circuit->nets.pool_capacity = h->pool_size;
+    circuit->nets.num_slots = h->num_net_slots;
+    circuit->num_primary_inputs = h->num_primary_inputs;
+    circuit->num_primary_outputs = h->num_primary_outputs;
+    circuit->num_faults = h->num_faults;
+    circuit->num_dominated_faults = h->num_dominated_faults;
+    circuit->num_uncollapsed_faults = h->num_uncollapsed_faults;
+    EvalProgram* prog = &circuit->program;
+    prog->num_ops = h->num_ops;
+    prog->num_levels = h->num_levels;
+    memcpy(prog->lut, h->lut, sizeof(prog->lut));
+    memcpy(prog->lut_final, h->lut_final, sizeof(prog->lut_final));
+    // The engines record detections in the fault array; give it its own memory
+    size_t fault_bytes = bytes[SEC_FAULTS];
+    Fault* faults = (Fault*)arena_alloc(&circuit->arena, fault_bytes + sizeof(Fault));
+    memcpy(faults, circuit->faults, fault_bytes);
+    circuit->faults = faults;
+    return circuit;
+}
+
+bool save_circuit_cache(const char* filename, const Circuit* circuit, uint64_t source_hash, uint32_t flags) {
+    const EvalProgram* prog = &circuit->program;
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.endian_mark = CACHE_ENDIAN_MARK;
+    header.source_hash = source_hash;
+    header.flags = flags;
+    header.num_opcodes = NUM_OPCODES;
+    header.fault_size = sizeof(Fault);
+    header.class_member_size = sizeof(FaultClassMember);
+    header.num_gates = circuit->num_gates;
+    header.num_nets = circuit->nets.count;
+    header.num_fanins = circuit->fanin_start[circuit->num_gates];
+    header.num_net_slots = circuit->nets.num_slots;
+    header.names_size = circuit->gate_names_size;
+    header.pool_size = circuit->nets.pool_size;
+    header.num_primary_inputs = circuit->num_primary_inputs;
+    header.num_primary_outputs = circuit->num_primary_outputs;
+    header.num_faults = circuit->num_faults;
+    header.num_dominated_faults = circuit->num_dominated_faults;
+    header.num_uncollapsed_faults = circuit->num_uncollapsed_faults;
+    header.num_ops = prog->num_ops;
+    header.num_levels = prog->num_levels;
+    header.num_op_inputs = prog->in_start[prog->num_ops];
+    header.num_op_fanouts = prog->fanout_start[circuit->nets.count + 1];
+    memcpy(header.lut, prog->lut, sizeof(header.lut));
+    memcpy(header.lut_final, prog->lut_final, sizeof(header.lut_final));
+    void** ptr[NUM_SECTIONS];
+    size_t bytes[NUM_SECTIONS];
+    cache_sections((Circuit*)circuit, &header, ptr, bytes);
+    uint64_t offset = (sizeof(CacheHeader) + CACHE_ALIGN - 1) & ~(uint64_t)(CACHE_ALIGN - 1);
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        header.section_offset[s] = offset;
+        header.section_bytes[s] = bytes[s];
+        offset = (offset + bytes[s] + CACHE_ALIGN - 1) & ~(uint64_t)(CACHE_ALIGN - 1);
+    }
+
+    // Write next to the target and rename, so a reader never maps a
+    // half-written image
+    size_t name_len = strlen(filename);
+    char* temp_filename = (char*)malloc(name_len + 5);
+    memcpy(temp_filename, filename, name_len);
+    memcpy(temp_filename + name_len, ".tmp", 5);
+    FILE* file = fopen(temp_filename, "wb");
+    if (!file) {
+        perror("Error opening circuit cache file");
+        free(temp_filename);
+        return false;
+    }
+    static const char padding[CACHE_ALIGN] = { 0 };
+    uint64_t written = sizeof(CacheHeader);
+    uint64_t checksum = checksum_update(FNV1A64_INIT, &header, sizeof(header));
+    fwrite(&header, sizeof(header), 1, file); // rewritten with the checksum below
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        fwrite(padding, 1, header.section_offset[s] - written, file);
+        checksum = checksum_update(checksum, padding, header.section_offset[s] - written);
+        Fault* faults = NULL;
+        const void* data = *ptr[s];
+        if (s == SEC_FAULTS) {
+            // Store faults in their pre-simulation state
+            faults = (Fault*)malloc(bytes[s] + sizeof(Fault));
+            memcpy(faults, data, bytes[s]);
+            for (size_t f = 0; f < bytes[s] / sizeof(Fault); f++) {
+                faults[f].detected = false;
+                faults[f].first_detected_vector = -1;
+                faults[f].redundant = false;
+                faults[f].potential = false;
+            }
+            data = faults;
+        }
+        if (bytes[s] > 0) fwrite(data, 1, bytes[s], file);
+        checksum = checksum_update(checksum, data, bytes[s]);
+        free(faults);
+        written = header.section_offset[s] + bytes[s];
+    }
+    header.checksum = checksum;
+    if (fseek(file, 0, SEEK_SET) == 0) fwrite(&header, sizeof(header), 1, file);
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) ok = false;
+    if (ok && rename(temp_filename, filename) != 0) {
+        perror("Error renaming circuit cache file");
+        ok = false;
+    }
+    if (!ok) remove(temp_filename);
+    free(temp_filename);
+    return ok;
+}
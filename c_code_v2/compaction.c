@@ -0,0 +1,84 @@
+#include "fault_simulator.h"
+
+// Static test set compaction by fault simulation with dropping.
+// 1. Forward pass over the whole set: every fault records the first vector
+//    that detects it. A vector that is first for no fault adds nothing.
+// 2. Reverse pass over the remaining vectors: vectors late in the set tend
+//    to detect the hard faults and, on the way, many easy ones the early
+//    vectors were kept for. A vector that is first for nothing in this
+//    order is discarded too.
+// Every detected fault keeps its detecting vector in both passes, so the
+// compacted set detects exactly the faults the original set did. A last
+// forward pass over it, in the original order, gives the statistics.
+
+// Helper: Forget all detections before a fresh pass
+static void reset_detections(Circuit* circuit) {
+    for (int f = 0; f < circuit->num_faults + circuit->num_dominated_faults; f++) {
+        circuit->faults[f].detected = false;
+        circuit->faults[f].first_detected_vector = -1;
+        circuit->faults[f].potential = false;
+    }
+}
+
+// Helper: Mark the vectors some fault was first detected by
+static void mark_first_detections(const Circuit* circuit, bool* keep) {
+    for (int f = 0; f < circuit->num_faults + circuit->num_dominated_faults; f++) {
+        const Fault* fault = &circuit->faults[f];
+        if (fault->detected) keep[fault->first_detected_vector] = true;
+    }
+}
+
+// Helper: Detected faults over the uncollapsed universe
+static int count_detected(const Circuit* circuit) {
+    int detected = 0;
+    for (int f = 0; f < circuit->num_faults + circuit->num_dominated_faults; f++) {
+        if (circuit->faults[f].detected) detected += circuit->class_start[f + 1] - circuit->class_start[f];
+    }
+    return detected;
+}
+
+TestVectors* compact_test_vectors(const char* engine, Circuit* circuit, const TestVectors* tv, const SimOptions* options) {
+    SimOptions pass_options = *options;
+    pass_options.quiet = true;
+    printf("\nCompacting %d vectors with the %s engine...\n", tv->num_vectors, engine);
+
+    reset_detections(circuit);
+    run_fault_simulation(engine, circuit, tv, &pass_options);
+    int detected = count_detected(circuit);
+    bool* keep = (bool*)calloc(tv->num_vectors + 1, sizeof(bool));
+    mark_first_detections(circuit, keep);
+    int* order = (int*)malloc((tv->num_vectors + 1) * sizeof(int));
+    int num_forward = 0;
+    for (int v = tv->num_vectors - 1; v >= 0; v--) {
+        if (keep[v]) order[num_forward++] = v;
+    }
+    printf("Forward pass: %d of %d vectors detect a fault first.\n", num_forward, tv->num_vectors);
+
+    // order[] lists the survivors last to first
+    TestVectors* reversed = select_test_vectors(tv, order, num_forward);
+    reset_detections(circuit);
+    run_fault_simulation(engine, circuit, reversed, &pass_options);
+    free_test_vectors(reversed);
+    memset(keep, 0, (num_forward + 1) * sizeof(bool));
+    mark_first_detections(circuit, keep);
+    int* kept = (int*)malloc((num_forward + 1) * sizeof(int));
+    int num_kept = 0;
+    for (int k = num_forward - 1; k >= 0; k--) {
+        if (keep[k]) kept[num_kept++] = order[k];
+    }
+    printf("Reverse pass: %d vectors kept.\n", num_kept);
+
+    TestVectors* compacted = select_test_vectors(tv, kept, num_kept);
+    reset_detections(circuit);
+    run_fault_simulation(engine, circuit, compacted, &pass_options);
+    if (count_detected(circuit) != detected) {
+        // Unreachable while every engine records true first detections
+        fprintf(stderr, "Error: compacted set detects %d faults, the original %d\n", count_detected(circuit), detected);
+        free_test_vectors(compacted);
+        compacted = NULL;
+    }
+    free(kept);
+    free(order);
+    free(keep);
+    return compacted;
+}
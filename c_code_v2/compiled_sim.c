@@ -0,0 +1,356 @@
+#include "fault_simulator.h"
+
+// Compiled-code simulation. The levelized program is written out as
+// straight-line C, one statement per op with its fanin net IDs as constants,
+// compiled by the system C compiler into a shared object and loaded with
+// dlopen(). One of two kernels is generated, for the engine the circuit
+// runs on:
+// - good(): combinational circuits, two-valued evaluation of every op over
+//   ppsfp's PatternWords (the good machine of a pattern block);
+// - step(): circuits with flip-flops, one clock cycle of the sequential
+//   engine's 64 machines, with the stem and branch fault forces read only
+//   where the fault list has a fault (good and faulty machines in one pass).
+// Artifacts are named after a hash of the generated source, which covers
+// the netlist, the fault list and the word width, so a cache directory can
+// be shared by every circuit and option set; a rerun on an unchanged
+// netlist only pays for generating and hashing the source.
+//
+// The compiler's time grows faster than linearly with the size of a
+// function, so the ops go in small functions, and those in translation
+// units of their own that compile in parallel, one per CPU. Even so gcc
+// takes about 0.25 ms per op (12 s for 50k gates on one core). step()
+// repays that many times over: it makes the sequential engine about 6x
+// faster. good() only replaces ppsfp's good machine, a small part of a
+// combinational run where faults propagate event-driven (it saves 0.06 to
+// 0.9 s, by word width, of 64k vectors on 50k gates), so it is built only
+// for runs long enough to repay it (compiled_kernel_pays_off()).
+//
+// Runs that can see an X keep using the interpreters.
+
+#define KERNEL_CHUNK 32    // ops per generated function
+#define KERNEL_UNIT 4096   // ops per translation unit (a multiple of KERNEL_CHUNK)
+#define KERNEL_BUILD_NS 250000 // build time per op
+
+// Width of ppsfp's PatternWord in 64-bit lanes (the same ISA test as
+// ppsfp.c), the flag the kernel needs to keep that width in registers (it
+// runs in this process, so the CPU has it), and the time good() saves per
+// op and pattern block over the interpreter, measured on a 50k-gate circuit
+#if defined(__AVX512F__)
+#define KERNEL_LANES 8
+#define KERNEL_ISA " -mavx512f"
+#define KERNEL_GOOD_SAVING_NS 9
+#elif defined(__AVX2__)
+#define KERNEL_LANES 4
+#define KERNEL_ISA " -mavx2"
+#define KERNEL_GOOD_SAVING_NS 13
+#else
+#define KERNEL_LANES 1
+#define KERNEL_ISA ""
+#define KERNEL_GOOD_SAVING_NS 16
+#endif
+
+bool compiled_kernel_pays_off(const Circuit* circuit, long long num_vectors) {
+    if (count_flip_flops(circuit) > 0) return true;
+    long long num_blocks = (num_vectors + 64 * KERNEL_LANES - 1) / (64 * KERNEL_LANES);
+    return num_blocks * KERNEL_GOOD_SAVING_NS >= KERNEL_BUILD_NS;
+}
+
+#ifndef _WIN32
+#include <stdarg.h>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+// Growable text buffer for the generated source
+typedef struct {
+    char* data;
+    size_t size;
+    size_t capacity;
+} SourceBuffer;
+
+static void emit(SourceBuffer* b, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+static void emit(SourceBuffer* b, const char* format, ...) {
+    for (;;) {
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(b->data + b->size, b->capacity - b->size, format, args);
+        va_end(args);
+        if (n >= 0 && b->size + (size_t)n < b->capacity) {
+            b->size += (size_t)n;
+            return;
+        }
+        b->capacity = 2 * b->capacity + (n > 0 ? (size_t)n : 0);
+        b->data = (char*)realloc(b->data, b->capacity);
+    }
+}
+
+// Helper: Fold operator and output inversion of an opcode
+static const char* op_operator(uint8_t op, bool* invert) {
+    *invert = op == NAND || op == NOR || op == XNOR || op == NOT;
+    switch (op) {
+        case AND: case NAND: return " & ";
+        case OR: case NOR:   return " | ";
+        case XOR: case XNOR: return " ^ ";
+        default:             return NULL;
+    }
+}
+
+// Helper: The translation unit that holds op k
+static SourceBuffer* chunk_unit(SourceBuffer* units, int k) {
+    return &units[1 + k / KERNEL_UNIT];
+}
+
+// Helper: The good() kernel over PatternWords
+static void emit_good_kernel(SourceBuffer* units, const EvalProgram* prog) {
+    for (int k = 0; k < prog->num_ops; k++) {
+        SourceBuffer* b = chunk_unit(units, k);
+        if (k % KERNEL_CHUNK == 0) emit(b, "void good_%d(W* v) {\n", k / KERNEL_CHUNK);
+        bool invert;
+        const char* join = op_operator(prog->op[k], &invert);
+        if (prog->op[k] == OP_UNSUPPORTED) {
+            emit(b, "    v[%d] = (W){ 0 };\n", prog->out[k]);
+        } else {
+            emit(b, "    v[%d] = %s(", prog->out[k], invert ? "~" : "");
+            for (int j = prog->in_start[k]; j < prog->in_start[k + 1]; j++) {
+                emit(b, "%sv[%d]", j > prog->in_start[k] && join ? join : "", prog->in[j]);
+                if (!join) break;
+            }
+            emit(b, ");\n");
+        }
+        if (k % KERNEL_CHUNK == KERNEL_CHUNK - 1 || k == prog->num_ops - 1) emit(b, "}\n");
+    }
+    int num_chunks = (prog->num_ops + KERNEL_CHUNK - 1) / KERNEL_CHUNK;
+    for (int c = 0; c < num_chunks; c++) emit(&units[0], "void good_%d(W* v);\n", c);
+    emit(&units[0], "void tvc_good(W* v) {\n");
+    for (int c = 0; c < num_chunks; c++) emit(&units[0], "    good_%d(v);\n", c);
+    emit(&units[0], "}\n");
+}
+
+// Helper: The step() kernel; 'stem' and 'branch' flag the nets and input
+// slots that carry a fault
+static void emit_step_kernel(SourceBuffer* units, const EvalProgram* prog, const bool* stem, const bool* branch) {
+    for (int k = 0; k < prog->num_ops; k++) {
+        SourceBuffer* b = chunk_unit(units, k);
+        if (k % KERNEL_CHUNK == 0) {
+            emit(b, "void step_%d(uint64_t* v, const uint64_t (*nf)[2], const uint64_t (*sf)[2]) {\n", k / KERNEL_CHUNK);
+            emit(b, "    (void)nf; (void)sf;\n");
+        }
+        bool invert;
+        const char* join = op_operator(prog->op[k], &invert);
+        int out = prog->out[k];
+        if (prog->op[k] == OP_UNSUPPORTED) {
+            emit(b, "    v[%d] = 0", out);
+        } else {
+            emit(b, "    v[%d] = %s(", out, invert ? "~" : "");
+            for (int j = prog->in_start[k]; j < prog->in_start[k + 1]; j++) {
+                if (j > prog->in_start[k]) emit(b, "%s", join);
+                if (branch[j]) emit(b, "((v[%d] & ~sf[%d][0]) | sf[%d][1])", prog->in[j], j, j);
+                else emit(b, "v[%d]", prog->in[j]);
+                if (!join) break;
+            }
+            emit(b, ")");
+        }
+        if (stem[out]) emit(b, ";\n    v[%d] = (v[%d] & ~nf[%d][0]) | nf[%d][1];\n", out, out, out, out);
+        else emit(b, ";\n");
+        if (k % KERNEL_CHUNK == KERNEL_CHUNK - 1 || k == prog->num_ops - 1) emit(b, "}\n");
+    }
+    int num_chunks = (prog->num_ops + KERNEL_CHUNK - 1) / KERNEL_CHUNK;
+    for (int c = 0; c < num_chunks; c++) {
+        emit(&units[0], "void step_%d(uint64_t* v, const uint64_t (*nf)[2], const uint64_t (*sf)[2]);\n", c);
+    }
+    emit(&units[0], "void tvc_step(uint64_t* v, const uint64_t (*nf)[2], const uint64_t (*sf)[2]) {\n");
+    for (int c = 0; c < num_chunks; c++) emit(&units[0], "    step_%d(v, nf, sf);\n", c);
+    emit(&units[0], "}\n");
+}
+
+// Helper: Generate the kernel source of a circuit: the entry point in
+// units[0], the ops of every KERNEL_UNIT in the units after it
+static void generate_source(const Circuit* circuit, SourceBuffer* units, int num_units) {
+    const EvalProgram* prog = &circuit->program;
+    int num_nets = circuit->nets.count;
+    int num_slots = prog->in_start[prog->num_ops];
+    bool* stem = (bool*)calloc(num_nets + 1, sizeof(bool));
+    bool* branch = (bool*)calloc(num_slots + 1, sizeof(bool));
+    // Faults dropped by dominance are simulated too: force them as well
+    for (int f = 0; f < circuit->num_faults + circuit->num_dominated_faults; f++) {
+        const Fault* fault = &circuit->faults[f];
+        if (fault->gate < 0) {
+            stem[fault->net] = true;
+        } else if (prog->gate_op[fault->gate] >= 0) {
+            branch[prog->in_start[prog->gate_op[fault->gate]] + fault->pin] = true;
+        }
+    }
+    bool sequential = count_flip_flops(circuit) > 0;
+    for (int u = 0; u < num_units; u++) {
+        emit(&units[u], "// Generated by the fault simulator (compiled kernel format 2): %d ops, %d levels, unit %d of %d\n",
+             prog->num_ops, prog->num_levels, u + 1, num_units);
+        emit(&units[u], "#include <stdint.h>\n");
+        if (!sequential) emit(&units[u], "typedef uint64_t W __attribute__((vector_size(%d)));\n", 8 * KERNEL_LANES);
+    }
+    if (sequential) emit_step_kernel(units, prog, stem, branch);
+    else emit_good_kernel(units, prog);
+    free(branch);
+    free(stem);
+}
+
+// Helper: Run shell commands, up to 'jobs' at a time; false if one fails
+static bool run_commands(char* const* commands, int count, int jobs) {
+    pid_t* pids = (pid_t*)malloc((count + 1) * sizeof(pid_t));
+    bool ok = true;
+    int running = 0, next = 0;
+    while (running > 0 || (ok && next < count)) {
+        if (ok && next < count && running < jobs) {
+            pids[next] = fork();
+            if (pids[next] == 0) {
+                execl("/bin/sh", "sh", "-c", commands[next], (char*)NULL);
+                _exit(127);
+            }
+            if (pids[next] < 0) {
+                perror("Error starting the kernel compiler");
+                ok = false;
+            } else {
+                running++;
+                next++;
+            }
+            continue;
+        }
+        int status;
+        pid_t pid = wait(&status);
+        if (pid < 0) break;
+        running--;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            for (int c = 0; c < next; c++) {
+                if (pids[c] == pid) fprintf(stderr, "Error: kernel compilation failed (%s)\n", commands[c]);
+            }
+            ok = false;
+        }
+    }
+    free(pids);
+    return ok;
+}
+
+// Helper: Write the sources next to the artifact (base_N.c) and compile
+// them; the shared object appears under its final name only once it is
+// complete
+static bool build_shared_object(const SourceBuffer* units, int num_units, const char* base, const char* object_path) {
+    const char* cc = getenv("TVC_CC");
+    if (!cc || !*cc) cc = "cc";
+    size_t path_len = strlen(base) + 64;
+    char* source_path = (char*)malloc(path_len);
+    char** objects = (char**)calloc(num_units, sizeof(char*));
+    char** commands = (char**)calloc(num_units, sizeof(char*));
+    size_t link_len = strlen(cc) + strlen(object_path) + 64;
+    bool ok = true;
+    for (int u = 0; ok && u < num_units; u++) {
+        snprintf(source_path, path_len, "%s_%d.c", base, u);
+        FILE* file = fopen(source_path, "w");
+        ok = file && fwrite(units[u].data, 1, units[u].size, file) == units[u].size;
+        if (file && fclose(file) != 0) ok = false;
+        if (!ok) {
+            perror("Error writing compiled kernel source");
+            break;
+        }
+        objects[u] = (char*)malloc(path_len);
+        snprintf(objects[u], path_len, "%s_%d.%ld.o", base, u, (long)getpid());
+        size_t command_len = strlen(cc) + strlen(source_path) + strlen(objects[u]) + 64;
+        commands[u] = (char*)malloc(command_len);
+        snprintf(commands[u], command_len, "%s -Og" KERNEL_ISA " -fPIC -c -o '%s' '%s'", cc, objects[u], source_path);
+        link_len += strlen(objects[u]) + 3;
+    }
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    ok = ok && run_commands(commands, num_units, jobs > 1 ? (int)jobs : 1);
+
+    size_t temp_len = strlen(object_path) + 32;
+    char* temp_path = (char*)malloc(temp_len);
+    snprintf(temp_path, temp_len, "%s.%ld.tmp", object_path, (long)getpid());
+    char* command = (char*)malloc(link_len);
+    size_t used = (size_t)snprintf(command, link_len, "%s -shared -o '%s'", cc, temp_path);
+    for (int u = 0; ok && u < num_units; u++) used += (size_t)snprintf(command + used, link_len - used, " '%s'", objects[u]);
+    if (ok && system(command) != 0) {
+        fprintf(stderr, "Error: kernel compilation failed (%s)\n", command);
+        ok = false;
+    }
+    if (ok && rename(temp_path, object_path) != 0) {
+        perror("Error storing compiled kernel");
+        ok = false;
+    }
+    if (!ok) remove(temp_path);
+    for (int u = 0; u < num_units; u++) {
+        if (objects[u]) remove(objects[u]);
+        free(objects[u]);
+        free(commands[u]);
+    }
+    free(command);
+    free(temp_path);
+    free(commands);
+    free(objects);
+    free(source_path);
+    return ok;
+}
+
+CompiledKernel* load_compiled_kernel(const Circuit* circuit, const char* cache_dir) {
+    if (strchr(cache_dir, '\'')) {
+        fprintf(stderr, "Error: kernel cache directory names may not contain quotes\n");
+        return NULL;
+    }
+    mkdir(cache_dir, 0777); // may exist already; fopen() reports real failures
+    int num_units = 1 + (circuit->program.num_ops + KERNEL_UNIT - 1) / KERNEL_UNIT;
+    SourceBuffer* units = (SourceBuffer*)malloc(num_units * sizeof(SourceBuffer));
+    for (int u = 0; u < num_units; u++) units[u] = (SourceBuffer){ (char*)malloc(1 << 16), 0, 1 << 16 };
+    generate_source(circuit, units, num_units);
+    uint64_t hash = FNV1A64_INIT;
+    for (int u = 0; u < num_units; u++) hash = fnv1a64(hash, units[u].data, units[u].size);
+    size_t len = strlen(cache_dir) + 64;
+    char* base = (char*)malloc(len);
+    char* object_path = (char*)malloc(len);
+    snprintf(base, len, "%s/tvc_%016llx", cache_dir, (unsigned long long)hash);
+    snprintf(object_path, len, "%s.so", base);
+    bool cached = access(object_path, R_OK) == 0;
+    CompiledKernel* kernel = NULL;
+    if (cached || build_shared_object(units, num_units, base, object_path)) {
+        void* handle = dlopen(object_path, RTLD_NOW | RTLD_LOCAL);
+        if (!handle) {
+            fprintf(stderr, "Error loading compiled kernel: %s\n", dlerror());
+        } else {
+            kernel = (CompiledKernel*)calloc(1, sizeof(CompiledKernel));
+            kernel->handle = handle;
+            *(void**)&kernel->good = dlsym(handle, "tvc_good");
+            *(void**)&kernel->step = dlsym(handle, "tvc_step");
+            if (!kernel->good && !kernel->step) {
+                fprintf(stderr, "Error: %s is not a compiled kernel\n", object_path);
+                free_compiled_kernel(kernel);
+                kernel = NULL;
+            } else {
+                kernel->cached = cached;
+            }
+        }
+    }
+    free(object_path);
+    free(base);
+    for (int u = 0; u < num_units; u++) free(units[u].data);
+    free(units);
+    return kernel;
+}
+
+void free_compiled_kernel(CompiledKernel* kernel) {
+    if (!kernel) return;
+    dlclose(kernel->handle);
+    free(kernel);
+}
+
+#else
+
+CompiledKernel* load_compiled_kernel(const Circuit* circuit, const char* cache_dir) {
+    (void)circuit;
+    (void)cache_dir;
+    fprintf(stderr, "Error: compiled kernels need dlopen(), which this platform lacks\n");
+    return NULL;
+}
+
+void free_compiled_kernel(CompiledKernel* kernel) {
+    (void)kernel;
+}
+
+#endif
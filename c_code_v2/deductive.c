@@ -0,0 +1,448 @@
+#include "fault_simulator.h"
+
+// Deductive fault simulation.
+// For every vector the good machine is evaluated once, then a single pass
+// over the levelized program computes, for every net, the sorted list of
+// fault IDs that would flip that net. Lists are combined with the classic
+// per-gate rules (union / intersection / difference on controlling values,
+// symmetric difference for XOR), and faults in a primary output's list are
+// detected by that vector. A gate that reads an X passes no list on, so
+// only definite detections are found; X-potential ones are not reported.
+//
+// In event-driven mode values and lists persist from one vector to the next
+// and only gates downstream of a changed input are re-evaluated.
+
+// Fault list of one net: sorted fault IDs, storage reused across vectors
+typedef struct {
+    int* ids;
+    int len;
+    int cap;
+} FaultList;
+
+// Helper: Copy a computed list into a net's storage
+static void list_assign(FaultList* list, const int* ids, int len) {
+    if (len > list->cap) {
+        list->cap = len > 2 * list->cap ? len : 2 * list->cap;
+        list->ids = (int*)realloc(list->ids, list->cap * sizeof(int));
+    }
+    if (len > 0) memcpy(list->ids, ids, len * sizeof(int)); // an empty list may have no storage
+    list->len = len;
+}
+
+// Helper: out = a | b
+static int list_union(const int* a, int na, const int* b, int nb, int* out) {
+    int i = 0, j = 0, n = 0;
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) out[n++] = a[i++];
+        else if (a[i] > b[j]) out[n++] = b[j++];
+        else { out[n++] = a[i++]; j++; }
+    }
+    while (i < na) out[n++] = a[i++];
+    while (j < nb) out[n++] = b[j++];
+    return n;
+}
+
+// Helper: out = a & b
+static int list_intersect(const int* a, int na, const int* b, int nb, int* out) {
+    int i = 0, j = 0, n = 0;
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) i++;
+        else if (a[i] > b[j]) j++;
+        else { out[n++] = a[i++]; j++; }
+    }
+    return n;
+}
+
+// Helper: out = a - b
+static int list_difference(const int* a, int na, const int* b, int nb, int* out) {
+    int i = 0, j = 0, n = 0;
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) out[n++] = a[i++];
+        else if (a[i] > b[j]) j++;
+        else { i++; j++; }
+    }
+    while (i < na) out[n++] = a[i++];
+    return n;
+}
+
+// Helper: out = a ^ b
+static int list_symdiff(const int* a, int na, const int* b, int nb, int* out) {
+    int i = 0, j = 0, n = 0;
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) out[n++] = a[i++];
+        else if (a[i] > b[j]) out[n++] = b[j++];
+        else { i++; j++; }
+    }
+    while (i < na) out[n++] = a[i++];
+    while (j < nb) out[n++] = b[j++];
+    return n;
+}
+
+// Scratch buffers shared by the gate rules; each holds up to num_faults IDs
+typedef struct {
+    int* acc;
+    int* tmp;
+    int* rest;
+} ListScratch;
+
+// Helper: Apply the deductive rule of one gate, given the fault list seen on
+// each input pin. Returns the result length in s->acc.
+static int gate_fault_list(uint8_t op, const int* ins, int num_ins, const uint8_t* values,
+                           const FaultList* const* pin_lists, ListScratch* s) {
+    int n = 0;
+    // An unknown input leaves the effect of every fault on the output unknown
+    for (int j = 0; j < num_ins; j++) {
+        if (values[ins[j]] == X) return 0;
+    }
+    switch (op) {
+        case BUF:
+        case NOT:
+            n = pin_lists[0]->len;
+            if (n > 0) memcpy(s->acc, pin_lists[0]->ids, n * sizeof(int));
+            return n;
+        case XOR:
+        case XNOR:
+            // A fault flips the output iff it flips an odd number of inputs
+            for (int j = 0; j < num_ins; j++) {
+                const FaultList* l = pin_lists[j];
+                n = list_symdiff(s->acc, n, l->ids, l->len, s->tmp);
+                int* t = s->acc; s->acc = s->tmp; s->tmp = t;
+            }
+            return n;
+        case AND: case NAND: case OR: case NOR: {
+            uint8_t controlling = (op == AND || op == NAND) ? ZERO : ONE;
+            // Faults that flip every controlling input and no other input
+            int num_rest = 0, first = 1;
+            for (int j = 0; j < num_ins; j++) {
+                if (values[ins[j]] != controlling) continue;
+                const FaultList* l = pin_lists[j];
+                if (first) {
+                    if (l->len > 0) memcpy(s->acc, l->ids, l->len * sizeof(int));
+                    n = l->len;
+                    first = 0;
+                } else {
+                    n = list_intersect(s->acc, n, l->ids, l->len, s->tmp);
+                    int* t = s->acc; s->acc = s->tmp; s->tmp = t;
+                }
+            }
+            for (int j = 0; j < num_ins; j++) {
+                if (!first && values[ins[j]] == controlling) continue;
+                const FaultList* l = pin_lists[j];
+                num_rest = list_union(s->rest, num_rest, l->ids, l->len, s->tmp);
+                int* t = s->rest; s->rest = s->tmp; s->tmp = t;
+            }
+            if (first) {
+                // No controlling input: any fault that flips some input flips the output
+                if (num_rest > 0) memcpy(s->acc, s->rest, num_rest * sizeof(int));
+                return num_rest;
+            }
+            n = list_difference(s->acc, n, s->rest, num_rest, s->tmp);
+            int* t = s->acc; s->acc = s->tmp; s->tmp = t;
+            return n;
+        }
+        default:
+            return 0;
+    }
+}
+
+// Per-thread simulation state
+typedef struct {
+    const Circuit* circuit;
+    uint8_t* values;              // one value and list per net plus the
+    FaultList* lists;             // constant-X slot used by missing pins
+    ListScratch scratch;
+    int (*net_faults)[2];         // live stem fault IDs of each net, -1 if none
+    int (*pin_faults)[2];         // live branch fault IDs of each op input slot
+    const FaultList** pin_lists;  // per-pin lists of the op being evaluated
+    FaultList* branch_lists;      // pin list plus its branch fault, per pin
+    bool fault_dropping;
+    DetectionMap* detections;     // per-thread results, NULL to record into the circuit
+    DropHint* hint;               // shared with the other threads, NULL when serial
+    uint64_t* block_words;        // packed vector block currently loaded
+    uint64_t* x_words;            // and its X inputs
+    int loaded_block;             // its index, -1 if none
+    bool event_driven;
+    bool primed;                  // values and lists hold the previous vector
+    int* events;                  // event wheel: level L queues its ops in [level_start[L], ...)
+    int* level_count;
+    bool* scheduled;
+    long long evaluations;        // gates evaluated so far
+    int max_arity;
+} DeductiveWorker;
+
+static void worker_init(DeductiveWorker* w, const Circuit* circuit, const SimOptions* options) {
+    const EvalProgram* prog = &circuit->program;
+    int num_nets = circuit->nets.count;
+    w->circuit = circuit;
+    w->values = (uint8_t*)malloc(num_nets + 1);
+    memset(w->values, X, num_nets + 1);
+    w->lists = (FaultList*)calloc(num_nets + 1, sizeof(FaultList));
+    w->scratch.acc = (int*)malloc((circuit->num_faults + 1) * sizeof(int));
+    w->scratch.tmp = (int*)malloc((circuit->num_faults + 1) * sizeof(int));
+    w->scratch.rest = (int*)malloc((circuit->num_faults + 1) * sizeof(int));
+    w->net_faults = (int(*)[2])malloc((num_nets + 1) * sizeof(int[2]));
+    int num_slots = prog->in_start[prog->num_ops];
+    int max_arity = 1;
+    for (int k = 0; k < prog->num_ops; k++) {
+        if (prog->in_start[k + 1] - prog->in_start[k] > max_arity) max_arity = prog->in_start[k + 1] - prog->in_start[k];
+    }
+    w->pin_faults = (int(*)[2])malloc((num_slots + 1) * sizeof(int[2]));
+    w->pin_lists = (const FaultList**)malloc(max_arity * sizeof(FaultList*));
+    w->branch_lists = (FaultList*)calloc(max_arity, sizeof(FaultList));
+    w->max_arity = max_arity;
+    w->fault_dropping = options->fault_dropping;
+    w->detections = NULL;
+    w->hint = NULL;
+    w->block_words = (uint64_t*)malloc((2 * circuit->num_primary_inputs + 1) * sizeof(uint64_t));
+    w->x_words = w->block_words + circuit->num_primary_inputs;
+    w->loaded_block = -1;
+    w->event_driven = options->event_driven;
+    w->primed = false;
+    w->events = (int*)malloc((prog->num_ops + 1) * sizeof(int));
+    w->level_count = (int*)calloc(prog->num_levels, sizeof(int));
+    w->scheduled = (bool*)calloc(prog->num_ops + 1, sizeof(bool));
+    w->evaluations = 0;
+}
+
+static void worker_free(DeductiveWorker* w) {
+    for (int n = 0; n <= w->circuit->nets.count; n++) free(w->lists[n].ids);
+    free(w->lists);
+    free(w->block_words);
+    free(w->events);
+    free(w->level_count);
+    free(w->scheduled);
+    free(w->net_faults);
+    free(w->pin_faults);
+    free(w->pin_lists);
+    for (int j = 0; j < w->max_arity; j++) free(w->branch_lists[j].ids);
+    free(w->branch_lists);
+    free(w->scratch.acc);
+    free(w->scratch.tmp);
+    free(w->scratch.rest);
+    free(w->values);
+}
+
+// Helper: Live-fault map entry of a fault: its net for stem faults, its op
+// input slot for branch faults
+static int* fault_slot(DeductiveWorker* w, const Fault* fault) {
+    const EvalProgram* prog = &w->circuit->program;
+    if (fault->gate < 0) return &w->net_faults[fault->net][fault->stuck_at_value];
+    return &w->pin_faults[prog->in_start[prog->gate_op[fault->gate]] + fault->pin][fault->stuck_at_value];
+}
+
+// Helper: Rebuild the live fault map for vectors starting at 'first_vector'.
+// Dropping a fault clears its entry, so it never enters a list again.
+static void worker_reset_faults(DeductiveWorker* w, int first_vector) {
+    const Circuit* circuit = w->circuit;
+    const EvalProgram* prog = &circuit->program;
+    for (int n = 0; n <= circuit->nets.count; n++) w->net_faults[n][0] = w->net_faults[n][1] = -1;
+    for (int e = 0; e < prog->in_start[prog->num_ops]; e++) w->pin_faults[e][0] = w->pin_faults[e][1] = -1;
+    for (int f = 0; f < circuit->num_faults; f++) {
+        if (w->fault_dropping) {
+            if (w->hint ? drop_hint_dropped(w->hint, f, first_vector) : circuit->faults[f].detected) continue;
+        }
+        *fault_slot(w, &circuit->faults[f]) = f;
+    }
+    // The lists no longer match the live fault set; start from a full pass
+    w->primed = false;
+}
+
+// Helper: Store a net's new list; returns true if it differs from the old one
+static bool store_list(FaultList* list, const int* ids, int len) {
+    bool changed = list->len != len || (len > 0 && memcmp(list->ids, ids, len * sizeof(int)) != 0);
+    if (changed) list_assign(list, ids, len);
+    return changed;
+}
+
+// Helper: Re-evaluate op k (value and fault list); returns true if either changed
+static bool worker_eval_op(DeductiveWorker* w, const EvalProgram* prog, int k) {
+    uint8_t* values = w->values;
+    int out = prog->out[k];
+    const int* ins = prog->in + prog->in_start[k];
+    int num_ins = prog->in_start[k + 1] - prog->in_start[k];
+    const uint8_t (*rule)[3] = prog->lut[prog->op[k]];
+    uint8_t value = values[ins[0]];
+    for (int j = 1; j < num_ins; j++) value = rule[value][values[ins[j]]];
+    value = prog->lut_final[prog->op[k]][value];
+    bool changed = value != values[out];
+    values[out] = value;
+    int n = 0;
+    if (value != X) {
+        // A live branch fault adds itself to the list of the one pin it sits on
+        const int (*pin_faults)[2] = w->pin_faults + prog->in_start[k];
+        for (int j = 0; j < num_ins; j++) {
+            const FaultList* l = &w->lists[ins[j]];
+            int f = values[ins[j]] == X ? -1 : pin_faults[j][values[ins[j]] == ONE ? 0 : 1];
+            if (f >= 0) {
+                FaultList* branch = &w->branch_lists[j];
+                if (l->len + 1 > branch->cap) {
+                    branch->cap = 2 * (l->len + 1);
+                    branch->ids = (int*)realloc(branch->ids, branch->cap * sizeof(int));
+                }
+                branch->len = list_union(l->ids, l->len, &f, 1, branch->ids);
+                l = branch;
+            }
+            w->pin_lists[j] = l;
+        }
+        n = gate_fault_list(prog->op[k], ins, num_ins, values, w->pin_lists, &w->scratch);
+    }
+    // The output's own fault flips it whenever it is activated
+    if (value != X) {
+        int f = w->net_faults[out][value == ONE ? 0 : 1];
+        if (f >= 0) {
+            n = list_union(w->scratch.acc, n, &f, 1, w->scratch.tmp);
+            int* t = w->scratch.acc; w->scratch.acc = w->scratch.tmp; w->scratch.tmp = t;
+        }
+    }
+    w->evaluations++;
+    INSTR_COUNT(COUNTER_GATE_EVALS, 1);
+    INSTR_FAULT_LIST(n);
+    return store_list(&w->lists[out], w->scratch.acc, n) || changed;
+}
+
+// Helper: Queue every op that reads 'net' on the event wheel
+static void schedule_fanouts(DeductiveWorker* w, const EvalProgram* prog, int net) {
+    for (int e = prog->fanout_start[net]; e < prog->fanout_start[net + 1]; e++) {
+        int k = prog->fanout[e];
+        if (w->scheduled[k]) continue;
+        int level = prog->net_level[prog->out[k]];
+        w->scheduled[k] = true;
+        w->events[prog->level_start[level] + w->level_count[level]++] = k;
+    }
+}
+
+// Helper: Deductive simulation of vectors [begin, end)
+static void worker_simulate(DeductiveWorker* w, Circuit* circuit, const TestVectors* tv, int begin, int end) {
+    int num_inputs = tv->num_inputs;
+    const EvalProgram* prog = &circuit->program;
+    uint8_t* values = w->values;
+    FaultList* lists = w->lists;
+    int (*net_faults)[2] = w->net_faults;
+    for (int v = begin; v < end; v++) {
+        // 1. Apply the vector; primary inputs only carry their own fault
+        bool full_pass = !w->event_driven || !w->primed;
+        if (v / 64 != w->loaded_block) {
+            w->loaded_block = v / 64;
+            load_vector_block(tv, w->loaded_block, w->block_words);
+            load_vector_x(tv, w->loaded_block, w->x_words);
+        }
+        for (int i = 0; i < num_inputs; i++) {
+            int net = circuit->primary_inputs[i];
+            uint8_t value = (w->block_words[i] >> (v & 63)) & 1 ? ONE : ZERO;
+            if ((w->x_words[i] >> (v & 63)) & 1) value = X;
+            int f = value == X ? -1 : net_faults[net][value == ONE ? 0 : 1];
+            bool changed = store_list(&lists[net], &f, f >= 0 ? 1 : 0) || value != values[net];
+            values[net] = value;
+            if (changed && !full_pass) schedule_fanouts(w, prog, net);
+        }
+
+        // 2. Propagate values and fault lists in level order
+        if (full_pass) {
+            for (int k = 0; k < prog->num_ops; k++) worker_eval_op(w, prog, k);
+            w->primed = true;
+        } else {
+            // Event-driven: only the fanout of nets that changed
+            for (int level = 1; level < prog->num_levels; level++) {
+                for (int q = 0; q < w->level_count[level]; q++) {
+                    int k = w->events[prog->level_start[level] + q];
+                    w->scheduled[k] = false;
+                    INSTR_COUNT(COUNTER_EVENTS, 1);
+                    if (worker_eval_op(w, prog, k)) schedule_fanouts(w, prog, prog->out[k]);
+                }
+                w->level_count[level] = 0;
+            }
+        }
+
+        // 3. Faults that reach a primary output are detected
+        for (int i = 0; i < circuit->num_primary_outputs; i++) {
+            const FaultList* l = &lists[circuit->primary_outputs[i]];
+            for (int j = 0; j < l->len; j++) {
+                int f = l->ids[j];
+                Fault* fault = &circuit->faults[f];
+                if (w->detections) {
+                    detection_map_set(w->detections, f, v);
+                    if (w->fault_dropping) drop_hint_update(w->hint, f, v);
+                } else {
+                    record_detection(fault, v);
+                }
+                // Lists that still hold a dropped fault are harmless: re-detection keeps the first vector
+                if (w->fault_dropping) *fault_slot(w, fault) = -1;
+            }
+        }
+    }
+}
+
+// Work item of the multithreaded run: one contiguous chunk of vectors
+typedef struct {
+    Circuit* circuit;
+    const TestVectors* tv;
+    int chunk_size;
+    DeductiveWorker* workers;
+} DeductiveTask;
+
+static void deductive_task(void* ctx, int thread_id, int item) {
+    DeductiveTask* task = (DeductiveTask*)ctx;
+    DeductiveWorker* w = &task->workers[thread_id];
+    int begin = item * task->chunk_size;
+    int end = begin + task->chunk_size < task->tv->num_vectors ? begin + task->chunk_size : task->tv->num_vectors;
+    worker_reset_faults(w, begin);
+    worker_simulate(w, task->circuit, task->tv, begin, end);
+}
+
+// Helper: Print the average number of gates evaluated per vector
+static void report_activity(const Circuit* circuit, long long evaluations, int num_vectors) {
+    if (num_vectors == 0 || circuit->program.num_ops == 0) return;
+    double per_vector = (double)evaluations / num_vectors;
+    printf("Activity factor: %.1f gate evaluations per vector (%.2f%% of %d gates)\n",
+           per_vector, 100.0 * per_vector / circuit->program.num_ops, circuit->program.num_ops);
+}
+
+void run_deductive_simulation(Circuit* circuit, const TestVectors* tv, const SimOptions* options) {
+    int num_vectors = tv->num_vectors;
+    int num_threads = options->num_threads > 1 ? options->num_threads : 1;
+    if (!options->quiet) {
+        printf("\nRunning %sDeductive Fault Simulation%s (%d thread%s)...\n", options->event_driven ? "Event-Driven " : "",
+               options->fault_dropping ? " with fault dropping" : "", num_threads, num_threads > 1 ? "s" : "");
+    }
+    long long evaluations = 0;
+
+    if (num_threads > 1) {
+        DeductiveTask task;
+        task.circuit = circuit;
+        task.tv = tv;
+        // Several whole 64-vector blocks per chunk, several chunks per thread
+        // so stealing can even out the load
+        task.chunk_size = (num_vectors + 8 * num_threads - 1) / (8 * num_threads);
+        task.chunk_size = task.chunk_size > 64 ? (task.chunk_size + 63) / 64 * 64 : 64;
+        task.workers = (DeductiveWorker*)malloc(num_threads * sizeof(DeductiveWorker));
+        DetectionMap* detections = (DetectionMap*)malloc(num_threads * sizeof(DetectionMap));
+        DropHint* hint = drop_hint_create(circuit);
+        for (int t = 0; t < num_threads; t++) {
+            worker_init(&task.workers[t], circuit, options);
+            detection_map_init(&detections[t], circuit->num_faults);
+            task.workers[t].detections = &detections[t];
+            task.workers[t].hint = hint;
+        }
+        int num_chunks = (num_vectors + task.chunk_size - 1) / task.chunk_size;
+        parallel_for(num_chunks, num_threads, deductive_task, &task);
+        detection_map_merge(circuit, detections, num_threads);
+        for (int t = 0; t < num_threads; t++) {
+            evaluations += task.workers[t].evaluations;
+            worker_free(&task.workers[t]);
+            detection_map_free(&detections[t]);
+        }
+        drop_hint_free(hint);
+        free(detections);
+        free(task.workers);
+    } else {
+        DeductiveWorker worker;
+        worker_init(&worker, circuit, options);
+        worker_reset_faults(&worker, 0);
+        worker_simulate(&worker, circuit, tv, 0, num_vectors);
+        evaluations = worker.evaluations;
+        worker_free(&worker);
+    }
+    if (options->quiet) return;
+    report_activity(circuit, evaluations, num_vectors);
+    printf("Deductive simulation run complete.\n");
+}
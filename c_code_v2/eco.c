@@ -0,0 +1,827 @@
+#include "fault_simulator.h"
+#include <ctype.h>
+
+// Incremental re-simulation after netlist ECO edits. A run can save its
+// session: the identity of the vector set and options, the circuit's
+// inputs, outputs and gates (type and net names), and the result of every
+// fault of the uncollapsed universe, all keyed by name so they survive
+// edits. An ECO run builds the edited netlist as usual and matches it
+// against the saved session gate by gate on instance names.
+//
+// The outputs of added, removed or changed gates are the seeds: their
+// values may change, and so may those of the outputs in their forward cone.
+// Nets a removed or changed gate no longer reads, and outputs added or
+// removed, keep their values but are observed differently. An output's
+// value in either machine depends only on its fanin cone, so a fault can
+// only change its result if it reaches one of these nets. Those faults form
+// their backward cone, taken through flip-flops for sequential circuits;
+// every other fault keeps its saved result.
+//
+// Outputs outside the seeds' forward cone still see each fault as they did
+// when the session was saved, which bounds the work further. A fault saved
+// as undetected is simulated only towards the outputs the edit changes. On
+// combinational circuits, a fault saved as detected at vector v is still
+// detected at v unless that detection was at a changed output, and as each
+// vector stands alone, such a fault is simulated towards the changed
+// outputs before v and checked towards every output only around v. A fault
+// no longer detected by v is simulated again in full.
+//
+// The faults are simulated on the cone they can reach, extracted as a
+// circuit of its own, so both the good machine and the fault work shrink
+// with the edit. An edit that reaches most of the faults is simulated as a
+// plain full run instead. The edited netlist itself is parsed, levelized
+// and collapsed in full (linear time, or a circuit cache load), which also
+// handles fault classes that the edit split or merged: a class is reused
+// only if all its members are outside the region and were saved with the
+// same result.
+
+static const char SESSION_MAGIC[] = "TVC-session 1";
+
+// Saved fault results
+enum { RESULT_NONE = -1, RESULT_UNDETECTED, RESULT_DETECTED, RESULT_POTENTIAL };
+static const char RESULT_CODES[] = "UDP";
+
+// Gate match states of the edited circuit
+enum { GATE_UNSEEN, GATE_SAME, GATE_CHANGED };
+
+// What an affected class was saved with, when not a detection vector
+enum { SAVED_NONE = -3, SAVED_LOST, SAVED_UNDETECTED };
+
+#define ECO_STAGE_VECTORS 256   // vectors per stage of the bounded searches
+
+// Record cursor over the mapped session file: tokens are separated by
+// blanks, records by newlines
+typedef struct {
+    const char* p;
+    const char* end;
+    int line;
+    const char* filename;
+} SessionReader;
+
+// Helper: Next token of the current record, NULL at its end
+static const char* next_token(SessionReader* r, size_t* len) {
+    while (r->p < r->end && (*r->p == ' ' || *r->p == '\t' || *r->p == '\r')) r->p++;
+    if (r->p >= r->end || *r->p == '\n') return NULL;
+    const char* start = r->p;
+    while (r->p < r->end && !isspace((unsigned char)*r->p)) r->p++;
+    *len = (size_t)(r->p - start);
+    return start;
+}
+
+// Helper: Move to the next record
+static void next_record(SessionReader* r) {
+    const char* nl = (const char*)memchr(r->p, '\n', (size_t)(r->end - r->p));
+    r->p = nl ? nl + 1 : r->end;
+    r->line++;
+}
+
+// Helper: Next token as a number in the given base
+static bool next_number(SessionReader* r, int base, long long* value) {
+    size_t len;
+    const char* token = next_token(r, &len);
+    char text[24];
+    if (!token || len >= sizeof(text)) return false;
+    memcpy(text, token, len);
+    text[len] = '\0';
+    char* end;
+    *value = base == 10 ? strtoll(text, &end, 10) : (long long)strtoull(text, &end, base);
+    return *end == '\0';
+}
+
+static bool token_equals(const char* token, size_t len, const char* name) {
+    return strlen(name) == len && memcmp(token, name, len) == 0;
+}
+
+// Helper: Net ID of a name token, -1 if the circuit has no such net
+static int lookup_net(const Circuit* circuit, const char* token, size_t len) {
+    char buffer[256];
+    char* name = len < sizeof(buffer) ? buffer : (char*)malloc(len + 1);
+    memcpy(name, token, len);
+    name[len] = '\0';
+    int net = symtab_lookup(&circuit->nets, name);
+    if (name != buffer) free(name);
+    return net;
+}
+
+// Helper: Read a "<keyword> <count>" record that opens a section
+static bool read_section(SessionReader* r, const char* keyword, int* count) {
+    size_t len;
+    const char* token = next_token(r, &len);
+    long long value;
+    if (!token || !token_equals(token, len, keyword) || !next_number(r, 10, &value) || value < 0 || value > 0x7fffffff) {
+        fprintf(stderr, "Error: %s line %d: expected '%s <count>'\n", r->filename, r->line, keyword);
+        return false;
+    }
+    *count = (int)value;
+    next_record(r);
+    return true;
+}
+
+int save_eco_session(const char* filename, const char* engine, const Circuit* circuit, const TestVectors* tv,
+                     const SimOptions* options, const EcoOptions* eco) {
+    uint64_t vectors_hash;
+    if (!hash_file(eco->vectors_filename, &vectors_hash)) {
+        perror("Error reading test vector file");
+        return -1;
+    }
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        perror("Error opening session file");
+        return -1;
+    }
+    const SymbolTable* nets = &circuit->nets;
+    fprintf(file, "%s\n", SESSION_MAGIC);
+    fprintf(file, "run %s %d %016llx %d %d\n", engine, tv->num_vectors, (unsigned long long)vectors_hash,
+            eco->full_scan ? 1 : 0, options->unknown_state ? 1 : 0);
+    fprintf(file, "inputs %d\n", circuit->num_primary_inputs);
+    for (int i = 0; i < circuit->num_primary_inputs; i++) fprintf(file, "%s\n", symtab_name(nets, circuit->primary_inputs[i]));
+    fprintf(file, "outputs %d\n", circuit->num_primary_outputs);
+    for (int i = 0; i < circuit->num_primary_outputs; i++) fprintf(file, "%s\n", symtab_name(nets, circuit->primary_outputs[i]));
+    fprintf(file, "gates %d\n", circuit->num_gates);
+    for (int g = 0; g < circuit->num_gates; g++) {
+        fprintf(file, "%s %d %s", gate_name(circuit, g), circuit->gate_type[g], symtab_name(nets, circuit->gate_output[g]));
+        for (int e = circuit->fanin_start[g]; e < circuit->fanin_start[g + 1]; e++) fprintf(file, " %s", symtab_name(nets, circuit->fanin[e]));
+        fputc('\n', file);
+    }
+    fprintf(file, "faults %d\n", circuit->num_uncollapsed_faults);
+    for (int f = 0; f < circuit->num_faults + circuit->num_dominated_faults; f++) {
+        const Fault* fault = &circuit->faults[f];
+        int result = fault->detected ? RESULT_DETECTED : fault->potential ? RESULT_POTENTIAL : RESULT_UNDETECTED;
+        for (int u = circuit->class_start[f]; u < circuit->class_start[f + 1]; u++) {
+            const FaultClassMember* member = &circuit->fault_classes[u];
+            fprintf(file, "%s %s %d %d %c %d\n", symtab_name(nets, member->net),
+                    member->gate >= 0 ? gate_name(circuit, member->gate) : "-", member->gate >= 0 ? member->pin : -1,
+                    member->stuck_at_value, RESULT_CODES[result], fault->detected ? fault->first_detected_vector : -1);
+        }
+    }
+    int status = ferror(file) ? -1 : 0;
+    if (fclose(file) != 0) status = -1;
+    if (status != 0) perror("Error writing session file");
+    return status;
+}
+
+
+// State of an ECO match: the edited circuit and what the session says about it
+typedef struct {
+    const Circuit* circuit;
+    SymbolTable gate_names; // instance names of the edited circuit
+    int* gate_of_name;      // name ID -> gate, -1 if several gates share the name
+    uint8_t* gate_state;    // GATE_* per gate
+    bool* seed;             // nets whose value an edit may change
+    bool* observed;         // nets an edit observes differently
+    int8_t* stem_result;    // [net * 2 + stuck-at], RESULT_*
+    int* stem_first;
+    int8_t* branch_result;  // [fanin slot * 2 + stuck-at]
+    int* branch_first;
+    const char** tokens;    // net names of the gate record being matched
+    size_t* token_lens;
+    int token_capacity;
+    int num_edits;          // gates added, removed or changed
+} EcoMatch;
+
+static void match_init(EcoMatch* m, const Circuit* circuit) {
+    memset(m, 0, sizeof(*m));
+    m->circuit = circuit;
+    symtab_init(&m->gate_names);
+    m->gate_of_name = (int*)malloc((circuit->num_gates + 1) * sizeof(int));
+    for (int g = 0; g < circuit->num_gates; g++) {
+        int id = symtab_intern(&m->gate_names, gate_name(circuit, g));
+        m->gate_of_name[id] = id == m->gate_names.count - 1 ? g : -1;
+    }
+    int num_nets = circuit->nets.count;
+    int num_slots = circuit->fanin_start[circuit->num_gates];
+    m->gate_state = (uint8_t*)calloc(circuit->num_gates + 1, sizeof(uint8_t));
+    m->seed = (bool*)calloc(num_nets + 1, sizeof(bool));
+    m->observed = (bool*)calloc(num_nets + 1, sizeof(bool));
+    m->stem_result = (int8_t*)malloc(2 * num_nets + 1);
+    memset(m->stem_result, RESULT_NONE, 2 * num_nets + 1);
+    m->stem_first = (int*)malloc((2 * num_nets + 1) * sizeof(int));
+    m->branch_result = (int8_t*)malloc(2 * num_slots + 1);
+    memset(m->branch_result, RESULT_NONE, 2 * num_slots + 1);
+    m->branch_first = (int*)malloc((2 * num_slots + 1) * sizeof(int));
+    m->token_capacity = 16;
+    m->tokens = (const char**)malloc(m->token_capacity * sizeof(const char*));
+    m->token_lens = (size_t*)malloc(m->token_capacity * sizeof(size_t));
+}
+
+static void match_free(EcoMatch* m) {
+    symtab_free(&m->gate_names);
+    free(m->gate_of_name);
+    free(m->gate_state);
+    free(m->seed);
+    free(m->observed);
+    free(m->stem_result);
+    free(m->stem_first);
+    free(m->branch_result);
+    free(m->branch_first);
+    free(m->tokens);
+    free(m->token_lens);
+}
+
+// Helper: Gate of the edited circuit with this instance name, -1 if none or ambiguous
+static int lookup_gate(const EcoMatch* m, const char* token, size_t len) {
+    char buffer[256];
+    char* name = len < sizeof(buffer) ? buffer : (char*)malloc(len + 1);
+    memcpy(name, token, len);
+    name[len] = '\0';
+    int id = symtab_lookup(&m->gate_names, name);
+    if (name != buffer) free(name);
+    return id >= 0 ? m->gate_of_name[id] : -1;
+}
+
+// Helper: Mark a net of the edited circuit by name, if it has one
+static void mark_name(const EcoMatch* m, bool* marks, const char* token, size_t len) {
+    int net = lookup_net(m->circuit, token, len);
+    if (net >= 0) marks[net] = true;
+}
+
+// Helper: Match one saved gate record against the edited circuit. A gate
+// is unchanged if a gate of the same instance name has the same type and
+// the same output and input nets, pin by pin.
+static bool match_gate(EcoMatch* m, SessionReader* r) {
+    const Circuit* circuit = m->circuit;
+    size_t name_len;
+    const char* name = next_token(r, &name_len);
+    long long type;
+    if (!name || !next_number(r, 10, &type)) return false;
+    int count = 0;
+    const char* token;
+    size_t len;
+    while ((token = next_token(r, &len)) != NULL) {
+        if (count == m->token_capacity) {
+            m->token_capacity *= 2;
+            m->tokens = (const char**)realloc(m->tokens, m->token_capacity * sizeof(const char*));
+            m->token_lens = (size_t*)realloc(m->token_lens, m->token_capacity * sizeof(size_t));
+        }
+        m->tokens[count] = token;
+        m->token_lens[count++] = len;
+    }
+    if (count == 0) return false; // no output net
+
+    int g = lookup_gate(m, name, name_len);
+    bool same = g >= 0 && m->gate_state[g] == GATE_UNSEEN && circuit->gate_type[g] == type &&
+                count - 1 == circuit->fanin_start[g + 1] - circuit->fanin_start[g] &&
+                token_equals(m->tokens[0], m->token_lens[0], symtab_name(&circuit->nets, circuit->gate_output[g]));
+    for (int k = 1; same && k < count; k++) {
+        int net = circuit->fanin[circuit->fanin_start[g] + k - 1];
+        same = token_equals(m->tokens[k], m->token_lens[k], symtab_name(&circuit->nets, net));
+    }
+    if (same) {
+        m->gate_state[g] = GATE_SAME;
+        return true;
+    }
+    // Removed or changed. Inputs the gate still reads reach its output, a
+    // seed of the edited circuit; only dropped connections need marking.
+    mark_name(m, m->seed, m->tokens[0], m->token_lens[0]);
+    bool same_output = g >= 0 && token_equals(m->tokens[0], m->token_lens[0], symtab_name(&circuit->nets, circuit->gate_output[g]));
+    for (int k = 1; k < count; k++) {
+        bool kept = false;
+        for (int e = same_output ? circuit->fanin_start[g] : 0; same_output && !kept && e < circuit->fanin_start[g + 1]; e++) {
+            kept = token_equals(m->tokens[k], m->token_lens[k], symtab_name(&circuit->nets, circuit->fanin[e]));
+        }
+        if (!kept) mark_name(m, m->observed, m->tokens[k], m->token_lens[k]);
+    }
+    if (g >= 0) m->gate_state[g] = GATE_CHANGED;
+    m->num_edits++;
+    return true;
+}
+
+// Helper: Record one saved fault result against the edited circuit's fault sites
+static bool match_fault(EcoMatch* m, SessionReader* r) {
+    const Circuit* circuit = m->circuit;
+    size_t net_len, gate_len, code_len;
+    const char* net_name = next_token(r, &net_len);
+    const char* gate_token = net_name ? next_token(r, &gate_len) : NULL;
+    long long pin, stuck_at, first;
+    if (!gate_token || !next_number(r, 10, &pin) || !next_number(r, 10, &stuck_at) || (stuck_at != 0 && stuck_at != 1)) return false;
+    const char* code = next_token(r, &code_len);
+    if (!code || code_len != 1 || !strchr(RESULT_CODES, *code) || !next_number(r, 10, &first)) return false;
+    int8_t result = (int8_t)(strchr(RESULT_CODES, *code) - RESULT_CODES);
+    int net = lookup_net(circuit, net_name, net_len);
+    if (net < 0) return true; // the site is gone
+    if (token_equals(gate_token, gate_len, "-")) {
+        m->stem_result[2 * net + stuck_at] = result;
+        m->stem_first[2 * net + stuck_at] = (int)first;
+        return true;
+    }
+    int g = lookup_gate(m, gate_token, gate_len);
+    if (g < 0 || pin < 0 || pin >= circuit->fanin_start[g + 1] - circuit->fanin_start[g] ||
+        circuit->fanin[circuit->fanin_start[g] + pin] != net) return true;
+    int slot = circuit->fanin_start[g] + (int)pin;
+    m->branch_result[2 * slot + stuck_at] = result;
+    m->branch_first[2 * slot + stuck_at] = (int)first;
+    return true;
+}
+
+// Helper: Check that the session was saved for this run, then match its
+// structure and results against the edited circuit
+static bool read_session(EcoMatch* m, SessionReader* r, const char* engine, const TestVectors* tv,
+                         const SimOptions* options, const EcoOptions* eco) {
+    const Circuit* circuit = m->circuit;
+    size_t magic_len = strlen(SESSION_MAGIC);
+    if ((size_t)(r->end - r->p) <= magic_len || memcmp(r->p, SESSION_MAGIC, magic_len) != 0 || r->p[magic_len] != '\n') {
+        fprintf(stderr, "Error: %s is not a saved session\n", r->filename);
+        return false;
+    }
+    next_record(r);
+
+    uint64_t vectors_hash;
+    if (!hash_file(eco->vectors_filename, &vectors_hash)) {
+        perror("Error reading test vector file");
+        return false;
+    }
+    size_t len, engine_len;
+    const char* token = next_token(r, &len);
+    const char* saved_engine = token && token_equals(token, len, "run") ? next_token(r, &engine_len) : NULL;
+    long long num_vectors, hash, full_scan, unknown_state;
+    if (!saved_engine || !next_number(r, 10, &num_vectors) || !next_number(r, 16, &hash) ||
+        !next_number(r, 10, &full_scan) || !next_number(r, 10, &unknown_state)) {
+        fprintf(stderr, "Error: %s line %d: malformed run record\n", r->filename, r->line);
+        return false;
+    }
+    next_record(r);
+    if (!token_equals(saved_engine, engine_len, engine) || num_vectors != tv->num_vectors ||
+        (uint64_t)hash != vectors_hash || (full_scan != 0) != eco->full_scan || (unknown_state != 0) != options->unknown_state) {
+        fprintf(stderr, "Error: %s was saved for another vector set, engine or options; run without --eco.\n", r->filename);
+        return false;
+    }
+
+    int count;
+    if (!read_section(r, "inputs", &count)) return false;
+    bool inputs_match = count == circuit->num_primary_inputs;
+    for (int i = 0; i < count; i++, next_record(r)) {
+        token = next_token(r, &len);
+        if (inputs_match && (!token || !token_equals(token, len, symtab_name(&circuit->nets, circuit->primary_inputs[i])))) {
+            inputs_match = false;
+        }
+    }
+    if (!inputs_match) {
+        fprintf(stderr, "Error: the edit changes the primary inputs, so the saved vectors do not apply; run without --eco.\n");
+        return false;
+    }
+
+    // Outputs added or removed
+    if (!read_section(r, "outputs", &count)) return false;
+    uint8_t* output_state = (uint8_t*)calloc(circuit->nets.count + 1, sizeof(uint8_t)); // bit 0: now, bit 1: saved
+    for (int i = 0; i < circuit->num_primary_outputs; i++) output_state[circuit->primary_outputs[i]] |= 1;
+    for (int i = 0; i < count; i++, next_record(r)) {
+        token = next_token(r, &len);
+        int net = token ? lookup_net(circuit, token, len) : -1;
+        if (net >= 0) output_state[net] |= 2;
+    }
+    for (int n = 0; n < circuit->nets.count; n++) {
+        if (output_state[n] == 1 || output_state[n] == 2) m->observed[n] = true;
+    }
+    free(output_state);
+
+    if (!read_section(r, "gates", &count)) return false;
+    for (int i = 0; i < count; i++, next_record(r)) {
+        if (!match_gate(m, r)) {
+            fprintf(stderr, "Error: %s line %d: malformed gate record\n", r->filename, r->line);
+            return false;
+        }
+    }
+    // Gates the session does not have, or has twice
+    for (int g = 0; g < circuit->num_gates; g++) {
+        if (m->gate_state[g] == GATE_SAME) continue;
+        if (m->gate_state[g] == GATE_UNSEEN) m->num_edits++;
+        m->seed[circuit->gate_output[g]] = true;
+    }
+
+    if (!read_section(r, "faults", &count)) return false;
+    for (int i = 0; i < count; i++, next_record(r)) {
+        if (!match_fault(m, r)) {
+            fprintf(stderr, "Error: %s line %d: malformed fault record\n", r->filename, r->line);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Helper: Mark the nets whose faults can see an edit: the backward cone of
+// the seeds, the nets observed differently and the outputs in the seeds'
+// forward cone. Those outputs, and the outputs observed differently, are
+// marked in changed_output.
+static bool* mark_region(const EcoMatch* m, bool* changed_output) {
+    const Circuit* circuit = m->circuit;
+    int num_nets = circuit->nets.count;
+    bool* reached = (bool*)calloc(num_nets + 1, sizeof(bool));
+    bool* region = (bool*)calloc(num_nets + 1, sizeof(bool));
+    int* queue = (int*)malloc((num_nets + 1) * sizeof(int));
+    int head = 0, tail = 0;
+    for (int n = 0; n < num_nets; n++) {
+        if (m->seed[n]) {
+            reached[n] = true;
+            queue[tail++] = n;
+        }
+    }
+    while (head < tail) {
+        int n = queue[head++];
+        for (int k = circuit->net_fanout_start[n]; k < circuit->net_fanout_start[n + 1]; k++) {
+            int out = circuit->gate_output[circuit->net_fanout[k]];
+            if (!reached[out]) {
+                reached[out] = true;
+                queue[tail++] = out;
+            }
+        }
+    }
+    head = tail = 0;
+    for (int n = 0; n < num_nets; n++) {
+        if (m->seed[n] || m->observed[n]) {
+            region[n] = true;
+            queue[tail++] = n;
+        }
+    }
+    for (int i = 0; i < circuit->num_primary_outputs; i++) {
+        int n = circuit->primary_outputs[i];
+        if (reached[n] || m->observed[n]) changed_output[n] = true;
+        if (reached[n] && !region[n]) {
+            region[n] = true;
+            queue[tail++] = n;
+        }
+    }
+    while (head < tail) {
+        int g = circuit->net_driver[queue[head++]];
+        if (g < 0) continue;
+        for (int e = circuit->fanin_start[g]; e < circuit->fanin_start[g + 1]; e++) {
+            int in = circuit->fanin[e];
+            if (!region[in]) {
+                region[in] = true;
+                queue[tail++] = in;
+            }
+        }
+    }
+    free(queue);
+    free(reached);
+    return region;
+}
+
+// Helper: The part of the circuit the affected faults can reach: every
+// primary input (so the vectors apply unchanged), the outputs reachable
+// from a fault site (only those in 'observe' unless it is NULL) and the
+// fanin cone of those outputs. Any path from a site to such an output stays
+// inside it, so simulating the faults on it gives the results they have at
+// those outputs in the whole circuit. sub_gate receives each gate's index
+// in the result, -1 outside it.
+static Circuit* extract_cone(const Circuit* circuit, const bool* site, const bool* observe, int* sub_gate) {
+    int num_nets = circuit->nets.count;
+    bool* reached = (bool*)calloc(num_nets + 1, sizeof(bool));
+    bool* cone = (bool*)calloc(num_nets + 1, sizeof(bool));
+    int* queue = (int*)malloc((num_nets + 1) * sizeof(int));
+    int head = 0, tail = 0;
+    for (int n = 0; n < num_nets; n++) {
+        if (site[n]) {
+            reached[n] = true;
+            queue[tail++] = n;
+        }
+    }
+    while (head < tail) {
+        int n = queue[head++];
+        for (int k = circuit->net_fanout_start[n]; k < circuit->net_fanout_start[n + 1]; k++) {
+            int out = circuit->gate_output[circuit->net_fanout[k]];
+            if (!reached[out]) {
+                reached[out] = true;
+                queue[tail++] = out;
+            }
+        }
+    }
+    CircuitBuilder builder;
+    builder_init(&builder);
+    const SymbolTable* nets = &circuit->nets;
+    for (int i = 0; i < circuit->num_primary_inputs; i++) {
+        const char* name = symtab_name(nets, circuit->primary_inputs[i]);
+        builder_add_input(&builder, name, strlen(name));
+    }
+    head = tail = 0;
+    for (int i = 0; i < circuit->num_primary_outputs; i++) {
+        int n = circuit->primary_outputs[i];
+        if (!reached[n] || cone[n] || (observe && !observe[n])) continue;
+        cone[n] = true;
+        queue[tail++] = n;
+        const char* name = symtab_name(nets, n);
+        builder_add_output(&builder, name, strlen(name));
+    }
+    while (head < tail) {
+        int g = circuit->net_driver[queue[head++]];
+        if (g < 0) continue;
+        for (int e = circuit->fanin_start[g]; e < circuit->fanin_start[g + 1]; e++) {
+            if (!cone[circuit->fanin[e]]) {
+                cone[circuit->fanin[e]] = true;
+                queue[tail++] = circuit->fanin[e];
+            }
+        }
+    }
+    int* inputs = (int*)malloc((circuit->fanin_start[circuit->num_gates] + 1) * sizeof(int));
+    for (int g = 0; g < circuit->num_gates; g++) {
+        sub_gate[g] = -1;
+        if (circuit->gate_type[g] == INPUT || !cone[circuit->gate_output[g]]) continue;
+        int num_inputs = 0;
+        for (int e = circuit->fanin_start[g]; e < circuit->fanin_start[g + 1]; e++) {
+            inputs[num_inputs++] = symtab_intern(&builder.circuit->nets, symtab_name(nets, circuit->fanin[e]));
+        }
+        int output = symtab_intern(&builder.circuit->nets, symtab_name(nets, circuit->gate_output[g]));
+        const char* name = gate_name(circuit, g);
+        sub_gate[g] = builder_add_gate(&builder, circuit->gate_type[g], name, strlen(name), output, inputs, num_inputs);
+    }
+    free(inputs);
+    free(queue);
+    free(cone);
+    free(reached);
+    Circuit* sub = builder_finish(&builder);
+    if (sub && !levelize_circuit(sub)) {
+        free_circuit(sub);
+        return NULL;
+    }
+    return sub;
+}
+
+// The part of the circuit some classes can reach, with each class mapped
+// onto it
+typedef struct {
+    Circuit* sub;
+    Fault* faults;          // by class; net -1 if the class is outside the cone
+} Cone;
+
+// Helper: Extract the cone of the given classes' sites towards the outputs
+// in 'observe' (NULL: all of them); false if it cannot be levelized
+static bool cone_init(Cone* cone, const Circuit* circuit, const int* classes, int count, const bool* observe) {
+    bool* site = (bool*)calloc(circuit->nets.count + 1, sizeof(bool));
+    for (int k = 0; k < count; k++) {
+        const Fault* fault = &circuit->faults[classes[k]];
+        site[fault->gate < 0 ? fault->net : circuit->gate_output[fault->gate]] = true;
+    }
+    int* sub_gate = (int*)malloc((circuit->num_gates + 1) * sizeof(int));
+    cone->sub = extract_cone(circuit, site, observe, sub_gate);
+    cone->faults = (Fault*)malloc((circuit->num_faults + circuit->num_dominated_faults + 1) * sizeof(Fault));
+    for (int k = 0; cone->sub && k < count; k++) {
+        Fault fault = circuit->faults[classes[k]];
+        fault.net = symtab_lookup(&cone->sub->nets, symtab_name(&circuit->nets, fault.net));
+        if (fault.gate >= 0) {
+            fault.gate = sub_gate[fault.gate];
+            if (fault.gate < 0) fault.net = -1;
+        }
+        fault.detected = false;
+        fault.potential = false;
+        fault.first_detected_vector = -1;
+        cone->faults[classes[k]] = fault;
+    }
+    free(sub_gate);
+    free(site);
+    return cone->sub != NULL;
+}
+
+static void cone_free(Cone* cone) {
+    free_circuit(cone->sub);
+    free(cone->faults);
+}
+
+// Helper: Simulate some of a cone's classes over tv. results[k] receives
+// the outcome of classes[k], its first detection counted within tv; a class
+// outside the cone reaches none of its outputs and stays undetected.
+static void cone_simulate(Cone* cone, const char* engine, const int* classes, int count, const TestVectors* tv,
+                          const SimOptions* options, Fault* results) {
+    Circuit* sub = cone->sub;
+    int* slot = (int*)malloc((count + 1) * sizeof(int));
+    sub->faults = (Fault*)malloc((count + 1) * sizeof(Fault));
+    sub->num_faults = 0;
+    for (int k = 0; k < count; k++) {
+        results[k] = cone->faults[classes[k]];
+        slot[k] = results[k].net >= 0 ? sub->num_faults++ : -1;
+        if (slot[k] >= 0) sub->faults[slot[k]] = results[k];
+    }
+    // The compiled kernel belongs to the whole circuit
+    SimOptions sub_options = *options;
+    sub_options.kernel = NULL;
+    sub_options.quiet = true;
+    if (sub->num_faults > 0) run_fault_simulation(engine, sub, tv, &sub_options);
+    for (int k = 0; k < count; k++) {
+        if (slot[k] >= 0) results[k] = sub->faults[slot[k]];
+    }
+    free(sub->faults);
+    sub->faults = NULL;
+    sub->num_faults = 0;
+    free(slot);
+}
+
+// Helper: Vectors first .. first + count - 1 of a set, as a set of their own
+static TestVectors* vector_range(const TestVectors* tv, int first, int count) {
+    int* vectors = (int*)malloc((count + 1) * sizeof(int));
+    for (int v = 0; v < count; v++) vectors[v] = first + v;
+    TestVectors* range = select_test_vectors(tv, vectors, count);
+    free(vectors);
+    return range;
+}
+
+// Helper: Re-simulate the classes an edit can affect, using what was saved
+// for each (saved[f]):
+// - SAVED_UNDETECTED: observed only at the changed outputs;
+// - a vector v: observed at the changed outputs before v, and checked at
+//   every output up to v, both by stages of vectors; a class not detected
+//   by v LOST its detection;
+// - SAVED_NONE and LOST: simulated over every vector and output.
+// Returns false if one of the cones cannot be levelized.
+static bool resimulate_classes(const char* engine, Circuit* circuit, const int* classes, int count, int* saved,
+                               const bool* changed_output, const TestVectors* tv, const SimOptions* options) {
+    int* changed = (int*)malloc((count + 1) * sizeof(int));
+    int* full = (int*)malloc((count + 1) * sizeof(int));
+    int num_changed = 0, num_full = 0;
+    bool bounded = false;
+    for (int k = 0; k < count; k++) {
+        int f = classes[k];
+        if (saved[f] != SAVED_NONE) changed[num_changed++] = f;
+        else full[num_full++] = f;
+        if (saved[f] >= 0) bounded = true;
+    }
+    Cone changed_cone = { 0 }, full_cone = { 0 };
+    bool ok = cone_init(&changed_cone, circuit, changed, num_changed, changed_output) &&
+              cone_init(&full_cone, circuit, classes, count, NULL);
+    Fault* results = (Fault*)malloc((count + 1) * sizeof(Fault));
+    int* active = (int*)malloc((count + 1) * sizeof(int));
+    int stage_size = bounded ? ECO_STAGE_VECTORS : tv->num_vectors;
+    // The deductive engine pays for every gate on every vector, so there the
+    // check takes the saved vectors alone; the pattern-parallel one pays per
+    // fault, so there it takes the stage up to the last of them instead,
+    // which also covers the changed outputs before each v
+    bool check_saved_only = strcmp(engine, "ppsfp") != 0;
+    int* check_vectors = (int*)malloc((stage_size + 1) * sizeof(int));
+    bool* saved_here = (bool*)malloc((stage_size + 1) * sizeof(bool)); // by vector of the stage
+    for (int start = 0; ok && num_changed > 0 && start < tv->num_vectors; start += stage_size) {
+        int end = start + stage_size < tv->num_vectors ? start + stage_size : tv->num_vectors;
+        TestVectors* stage = end - start < tv->num_vectors ? vector_range(tv, start, end - start) : NULL;
+        int num_active = 0;
+        for (int k = 0; k < num_changed; k++) {
+            int f = changed[k];
+            if (circuit->faults[f].detected) continue;
+            if (saved[f] == SAVED_UNDETECTED || saved[f] >= (check_saved_only ? start : end)) active[num_active++] = f;
+        }
+        cone_simulate(&changed_cone, engine, active, num_active, stage ? stage : tv, options, results);
+        for (int k = 0; k < num_active; k++) {
+            Fault* fault = &circuit->faults[active[k]];
+            int first = start + results[k].first_detected_vector;
+            if (results[k].detected && (saved[active[k]] == SAVED_UNDETECTED || first <= saved[active[k]])) {
+                fault->detected = true;
+                fault->first_detected_vector = first;
+            }
+            fault->potential = fault->potential || results[k].potential;
+        }
+        free_test_vectors(stage);
+
+        // The rest of those saved in this stage, checked at every output: no
+        // unchanged output detects one before its v, so each must be
+        // detected at a check vector up to v
+        num_active = 0;
+        int last = -1;
+        memset(saved_here, 0, (end - start) * sizeof(bool));
+        for (int k = 0; k < num_changed; k++) {
+            int f = changed[k];
+            if (circuit->faults[f].detected || saved[f] < start || saved[f] >= end) continue;
+            active[num_active++] = f;
+            saved_here[saved[f] - start] = true;
+            if (saved[f] > last) last = saved[f];
+        }
+        int num_check = 0;
+        for (int v = start; v <= last; v++) {
+            if (check_saved_only && !saved_here[v - start]) continue;
+            check_vectors[num_check++] = v;
+        }
+        if (num_active == 0) continue;
+        TestVectors* check = select_test_vectors(tv, check_vectors, num_check);
+        cone_simulate(&full_cone, engine, active, num_active, check, options, results);
+        for (int k = 0; k < num_active; k++) {
+            Fault* fault = &circuit->faults[active[k]];
+            int first = results[k].detected ? check_vectors[results[k].first_detected_vector] : -1;
+            if (first >= 0 && first <= saved[active[k]]) {
+                fault->detected = true;
+                fault->first_detected_vector = first;
+            } else {
+                saved[active[k]] = SAVED_LOST;
+                full[num_full++] = active[k];
+            }
+        }
+        free_test_vectors(check);
+    }
+    free(saved_here);
+    free(check_vectors);
+    if (ok) {
+        cone_simulate(&full_cone, engine, full, num_full, tv, options, results);
+        for (int k = 0; k < num_full; k++) {
+            Fault* fault = &circuit->faults[full[k]];
+            fault->detected = results[k].detected;
+            fault->potential = results[k].potential;
+            fault->first_detected_vector = results[k].first_detected_vector;
+        }
+    }
+    free(active);
+    free(results);
+    cone_free(&full_cone);
+    cone_free(&changed_cone);
+    free(full);
+    free(changed);
+    return ok;
+}
+
+int run_eco_simulation(const char* filename, const char* engine, Circuit* circuit, const TestVectors* tv,
+                       const SimOptions* options, const EcoOptions* eco) {
+    MappedFile file;
+    if (!map_file(filename, &file)) {
+        perror("Error opening session file");
+        return -1;
+    }
+    SessionReader reader = { file.data, file.data + file.size, 1, filename };
+    EcoMatch match;
+    match_init(&match, circuit);
+    bool ok = read_session(&match, &reader, engine, tv, options, eco);
+    unmap_file(&file);
+    if (!ok) {
+        match_free(&match);
+        return -1;
+    }
+    bool* changed_output = (bool*)calloc(circuit->nets.count + 1, sizeof(bool));
+    bool* region = mark_region(&match, changed_output);
+
+    // Reuse a class only if every member is outside the region and was
+    // saved with the same result; the others are simulated as plain faults,
+    // narrowed by that result where the members agree. A detection vector
+    // bounds the search only on combinational circuits, where a vector's
+    // outcome does not depend on the ones before it.
+    bool combinational = count_flip_flops(circuit) == 0;
+    int num_classes = circuit->num_faults + circuit->num_dominated_faults;
+    int* affected = (int*)malloc((num_classes + 1) * sizeof(int));
+    int* saved = (int*)malloc((num_classes + 1) * sizeof(int));
+    int num_affected = 0, num_saved_undetected = 0, num_saved_detected = 0;
+    for (int f = 0; f < num_classes; f++) {
+        int result = RESULT_NONE, first = -1;
+        bool known = true, inside = false;
+        for (int u = circuit->class_start[f]; known && u < circuit->class_start[f + 1]; u++) {
+            const FaultClassMember* member = &circuit->fault_classes[u];
+            int key, net;
+            const int8_t* saved_result;
+            const int* saved_first;
+            if (member->gate < 0) {
+                key = 2 * member->net + member->stuck_at_value;
+                net = member->net;
+                saved_result = match.stem_result;
+                saved_first = match.stem_first;
+            } else {
+                key = 2 * (circuit->fanin_start[member->gate] + member->pin) + member->stuck_at_value;
+                net = circuit->gate_output[member->gate];
+                saved_result = match.branch_result;
+                saved_first = match.branch_first;
+            }
+            if (region[net]) inside = true;
+            if (saved_result[key] == RESULT_NONE) known = false;
+            else if (u == circuit->class_start[f]) {
+                result = saved_result[key];
+                first = saved_first[key];
+            } else if (saved_result[key] != result || saved_first[key] != first) {
+                known = false;
+            }
+        }
+        bool reuse = known && !inside;
+        Fault* fault = &circuit->faults[f];
+        fault->detected = reuse && result == RESULT_DETECTED;
+        fault->first_detected_vector = fault->detected ? first : -1;
+        fault->potential = reuse && result == RESULT_POTENTIAL;
+        if (reuse) continue;
+        affected[num_affected++] = f;
+        saved[f] = SAVED_NONE;
+        if (known && result == RESULT_UNDETECTED) {
+            saved[f] = SAVED_UNDETECTED;
+            num_saved_undetected++;
+        } else if (known && result == RESULT_DETECTED && combinational && first >= 0 && first < tv->num_vectors) {
+            saved[f] = first;
+            num_saved_detected++;
+        }
+    }
+    printf("ECO: %d gates added, removed or changed; re-simulating %d of %d collapsed faults, the rest reused from %s.\n",
+           match.num_edits, num_affected, num_classes, filename);
+
+    if (num_affected * 4 >= num_classes * 3) {
+        // Little to reuse: the cones would be most of the circuit
+        printf("ECO: the edit reaches most of the circuit; simulating it in full instead.\n");
+        for (int f = 0; f < num_classes; f++) {
+            circuit->faults[f].detected = false;
+            circuit->faults[f].potential = false;
+            circuit->faults[f].first_detected_vector = -1;
+        }
+        run_fault_simulation(engine, circuit, tv, options);
+        num_affected = num_classes;
+    } else if (resimulate_classes(engine, circuit, affected, num_affected, saved, changed_output, tv, options)) {
+        int num_lost = 0;
+        for (int k = 0; k < num_affected; k++) {
+            if (saved[affected[k]] == SAVED_LOST) num_lost++;
+        }
+        printf("  %d saved as detected (%d lost it), %d as undetected, %d over every vector and output\n",
+               num_saved_detected, num_lost, num_saved_undetected,
+               num_affected - num_saved_detected - num_saved_undetected + num_lost);
+    } else {
+        fprintf(stderr, "Error: failed to levelize the part of the circuit the edit affects\n");
+        num_affected = -1;
+    }
+    free(saved);
+    free(affected);
+    free(region);
+    free(changed_output);
+    match_free(&match);
+    return num_affected;
+}
@@ -0,0 +1,254 @@
+#include "fault_simulator.h"
+
+// Structural fault collapsing.
+// The uncollapsed universe holds SA0/SA1 on every driven net (stem faults)
+// and, for nets that fan out to more than one place, on every gate input pin
+// they feed (branch faults). Faults are merged into equivalence classes with
+// the classic gate rules (e.g. an AND input SA0 is indistinguishable from its
+// output SA0), then classes whose tests are implied by another class are
+// dropped by dominance. Dropped classes follow the others in the fault list
+// and are still simulated, in the same pass, so their first detecting vector
+// is exact; every universe fault keeps a link to the fault that decides it.
+//
+// Transition faults (slow-to-rise, slow-to-fall) use the same lines. A
+// slow-to-rise fault behaves as a SA0 at capture once the line was 0 at
+// launch, so it is stored as a Fault with stuck_at_value 0 (slow-to-fall:
+// 1). Of the gate rules only buffers and inverters keep the initialization
+// condition intact, so only they merge transition faults, and there is no
+// dominance.
+
+// Helper: Union-find root with path halving
+static int find_root(int* parent, int x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+static void unite(int* parent, int a, int b) {
+    if (a < 0 || b < 0) return;
+    a = find_root(parent, a);
+    b = find_root(parent, b);
+    // Keep the lower ID as root so stems represent their classes
+    if (a < b) parent[b] = a;
+    else if (b < a) parent[a] = b;
+}
+
+// Fault lines: a stem per driven net, then a branch per pin of nets with
+// fanout; a pin on a net without fanout shares the stem's line
+typedef struct {
+    int num_stems;
+    int num_lines;
+    int* stem_line;         // net -> stem line, -1 if undriven
+    int* line_net;          // net behind each stem line
+    int* pin_line;          // fanin slot -> line
+    int* line_pin;          // fanin slot behind each branch line
+    int* pin_gate;          // fanin slot -> gate
+} FaultLines;
+
+static void enumerate_fault_lines(const Circuit* circuit, FaultLines* lines) {
+    int num_nets = circuit->nets.count;
+    int num_pins = circuit->fanin_start[circuit->num_gates];
+    bool* is_output = (bool*)calloc(num_nets + 1, sizeof(bool));
+    for (int i = 0; i < circuit->num_primary_outputs; i++) is_output[circuit->primary_outputs[i]] = true;
+    lines->stem_line = (int*)malloc((num_nets + 1) * sizeof(int));
+    lines->line_net = (int*)malloc((num_nets + 1) * sizeof(int));
+    int num_lines = 0;
+    for (int n = 0; n < num_nets; n++) {
+        lines->stem_line[n] = -1;
+        if (circuit->net_driver[n] < 0) continue;
+        lines->line_net[num_lines] = n;
+        lines->stem_line[n] = num_lines++;
+    }
+    lines->num_stems = num_lines;
+    lines->pin_line = (int*)malloc((num_pins + 1) * sizeof(int));
+    lines->line_pin = (int*)malloc((num_pins + 1) * sizeof(int));
+    lines->pin_gate = (int*)malloc((num_pins + 1) * sizeof(int));
+    for (int g = 0; g < circuit->num_gates; g++) {
+        for (int e = circuit->fanin_start[g]; e < circuit->fanin_start[g + 1]; e++) {
+            int net = circuit->fanin[e];
+            int fanout = circuit->net_fanout_start[net + 1] - circuit->net_fanout_start[net] + (is_output[net] ? 1 : 0);
+            lines->pin_gate[e] = g;
+            if (lines->stem_line[net] >= 0 && fanout > 1) {
+                lines->line_pin[num_lines - lines->num_stems] = e;
+                lines->pin_line[e] = num_lines++;
+            } else {
+                lines->pin_line[e] = lines->stem_line[net];
+            }
+        }
+    }
+    lines->num_lines = num_lines;
+    free(is_output);
+}
+
+static void free_fault_lines(FaultLines* lines) {
+    free(lines->pin_gate);
+    free(lines->line_pin);
+    free(lines->pin_line);
+    free(lines->line_net);
+    free(lines->stem_line);
+}
+
+// Helper: Equivalence classes over fault IDs 2 * line + value; transition
+// faults only merge through buffers and inverters
+static int* equivalence_classes(const Circuit* circuit, const FaultLines* lines, bool transition) {
+    int num_ids = 2 * lines->num_lines;
+    int* parent = (int*)malloc((num_ids + 1) * sizeof(int));
+    for (int id = 0; id < num_ids; id++) parent[id] = id;
+    for (int g = 0; g < circuit->num_gates; g++) {
+        int out = circuit->gate_output[g];
+        if (circuit->net_driver[out] != g) continue;
+        int o = lines->stem_line[out];
+        int begin = circuit->fanin_start[g], end = circuit->fanin_start[g + 1];
+        int type = circuit->gate_type[g];
+        if (transition && type != BUF && type != NOT) continue;
+        for (int e = begin; e < end; e++) {
+            int l = lines->pin_line[e];
+            if (l < 0) continue;
+            switch (type) {
+                case AND:  unite(parent, 2 * l, 2 * o); break;
+                case NAND: unite(parent, 2 * l, 2 * o + 1); break;
+                case OR:   unite(parent, 2 * l + 1, 2 * o + 1); break;
+                case NOR:  unite(parent, 2 * l + 1, 2 * o); break;
+                case BUF:
+                    if (end - begin != 1) break;
+                    unite(parent, 2 * l, 2 * o);
+                    unite(parent, 2 * l + 1, 2 * o + 1);
+                    break;
+                case NOT:
+                    if (end - begin != 1) break;
+                    unite(parent, 2 * l, 2 * o + 1);
+                    unite(parent, 2 * l + 1, 2 * o);
+                    break;
+                default: break;
+            }
+        }
+    }
+    for (int id = 0; id < num_ids; id++) find_root(parent, id);
+    return parent;
+}
+
+// Helper: Lay out one fault per class in 'target', allocating from 'arena':
+// classes that survived dominance first (the main simulation run), then the
+// dropped ones (credit[root] >= 0), each in fault ID order
+static void layout_fault_classes(Circuit* target, Arena* arena, const FaultLines* lines, const int* parent,
+                                 const int* credit) {
+    int num_ids = 2 * lines->num_lines;
+    int* collapsed = (int*)malloc((num_ids + 1) * sizeof(int));
+    int num_faults = 0, num_classes = 0;
+    for (int id = 0; id < num_ids; id++) {
+        if (parent[id] == id && credit[id] < 0) collapsed[id] = num_faults++;
+    }
+    num_classes = num_faults;
+    for (int id = 0; id < num_ids; id++) {
+        if (parent[id] == id && credit[id] >= 0) collapsed[id] = num_classes++;
+    }
+    target->num_faults = num_faults;
+    target->num_dominated_faults = num_classes - num_faults;
+    target->faults = (Fault*)arena_alloc(arena, (num_classes + 1) * sizeof(Fault));
+    target->implied_by = (int*)arena_alloc(arena, (num_classes - num_faults + 1) * sizeof(int));
+    target->num_uncollapsed_faults = num_ids;
+    target->fault_classes = (FaultClassMember*)arena_alloc(arena, (num_ids + 1) * sizeof(FaultClassMember));
+    target->class_start = (int*)arena_calloc(arena, num_classes + 2, sizeof(int));
+    for (int id = 0; id < num_ids; id++) target->class_start[collapsed[parent[id]] + 1]++;
+    for (int f = 0; f < num_classes; f++) target->class_start[f + 1] += target->class_start[f];
+    int* fill = (int*)malloc((num_classes + 1) * sizeof(int));
+    memcpy(fill, target->class_start, (num_classes + 1) * sizeof(int));
+    for (int id = 0; id < num_ids; id++) {
+        int line = id / 2;
+        int root = parent[id];
+        FaultClassMember member;
+        member.stuck_at_value = id & 1;
+        if (line < lines->num_stems) {
+            member.net = lines->line_net[line];
+            member.gate = -1;
+            member.pin = -1;
+        } else {
+            int e = lines->line_pin[line - lines->num_stems];
+            member.net = target->fanin[e];
+            member.gate = lines->pin_gate[e];
+            member.pin = e - target->fanin_start[lines->pin_gate[e]];
+        }
+        member.collapsed = collapsed[root];
+        member.dominated = credit[root] >= 0;
+        target->fault_classes[fill[member.collapsed]++] = member;
+        if (root == id) {
+            Fault* fault = &target->faults[collapsed[id]];
+            fault->net = member.net;
+            fault->stuck_at_value = member.stuck_at_value;
+            fault->gate = member.gate;
+            fault->pin = member.pin;
+            fault->detected = false;
+            fault->first_detected_vector = -1;
+            fault->redundant = false;
+            fault->potential = false;
+            if (member.dominated) target->implied_by[collapsed[id] - num_faults] = collapsed[credit[id]];
+        }
+    }
+    free(fill);
+    free(collapsed);
+}
+
+void create_collapsed_fault_list(Circuit* circuit, bool dominance) {
+    const EvalProgram* prog = &circuit->program;
+
+    // 1. Fault lines
+    FaultLines lines;
+    enumerate_fault_lines(circuit, &lines);
+    const int* stem_line = lines.stem_line;
+    const int* pin_line = lines.pin_line;
+    int num_ids = 2 * lines.num_lines; // fault ID = 2 * line + stuck-at value
+
+    // 2. Equivalence classes
+    int* parent = equivalence_classes(circuit, &lines, false);
+
+    // 3. Dominance, in topological order so a class is never credited to
+    //    one that is dropped later: an AND output SA1 is detected by any
+    //    test for an input SA1 (NAND: output SA0; OR: output SA0 by input
+    //    SA0; NOR: output SA1 by input SA0)
+    int* credit = (int*)malloc((num_ids + 1) * sizeof(int));
+    for (int id = 0; id < num_ids; id++) credit[id] = -1;
+    for (int k = 0; dominance && k < prog->num_ops; k++) {
+        uint8_t op = prog->op[k];
+        if (op != AND && op != NAND && op != OR && op != NOR) continue;
+        if (prog->in_start[k + 1] - prog->in_start[k] < 2) continue;
+        int out = prog->out[k];
+        int g = circuit->net_driver[out];
+        if (prog->gate_op[g] != k) continue;
+        int out_value = (op == AND || op == NOR) ? 1 : 0;
+        int in_value = (op == AND || op == NAND) ? 1 : 0;
+        int dominating = find_root(parent, 2 * stem_line[out] + out_value);
+        if (credit[dominating] >= 0) continue;
+        for (int e = circuit->fanin_start[g]; e < circuit->fanin_start[g + 1]; e++) {
+            if (pin_line[e] < 0) continue;
+            int dominated = find_root(parent, 2 * pin_line[e] + in_value);
+            if (dominated != dominating && credit[dominated] < 0) {
+                credit[dominating] = dominated;
+                break;
+            }
+        }
+    }
+
+    // 4. One fault per class
+    layout_fault_classes(circuit, &circuit->arena, &lines, parent, credit);
+    free(credit);
+    free(parent);
+    free_fault_lines(&lines);
+}
+
+// Transition fault list of a collapsed circuit: 'transition' becomes a view
+// of the circuit whose fault fields describe the transition universe. The
+// arrays live in the circuit's arena.
+void create_transition_fault_list(Circuit* circuit, Circuit* transition) {
+    FaultLines lines;
+    enumerate_fault_lines(circuit, &lines);
+    int* parent = equivalence_classes(circuit, &lines, true);
+    int* credit = (int*)malloc((2 * lines.num_lines + 1) * sizeof(int));
+    for (int id = 0; id < 2 * lines.num_lines; id++) credit[id] = -1;
+    *transition = *circuit;
+    layout_fault_classes(transition, &circuit->arena, &lines, parent, credit);
+    free(credit);
+    free(parent);
+    free_fault_lines(&lines);
+}
@@ -0,0 +1,773 @@
+#include "fault_simulator.h"
+
+// Fault dictionary for failure diagnosis. Building one simulates every
+// collapsed fault over every vector without dropping and keeps its
+// response: the vectors it fails on and, unless the dictionary is pass/fail
+// only, a 32-bit syndrome per failing vector (the xor of a fixed code per
+// failing output). The file holds the responses inverted: for each vector,
+// the distinct syndromes seen on it, sorted, each with the list of
+// collapsed faults that show it (CSR form, one row per vector). A list is
+// delta/varint coded, or a bitmap over its range of fault IDs when that is
+// smaller, as it is for the dense lists of pass/fail dictionaries.
+//
+// Like the circuit cache, the file is a header followed by 64-byte aligned
+// sections of IDs and offsets, used in place from a read-only mapping.
+// Diagnosis codes each failing vector of a tester log the same way, finds
+// its key by binary search in the row of that vector, and reads only the
+// lists of those keys, so its cost follows the log and the faults that
+// explain part of it, not the size of the dictionary.
+
+static const char DICT_MAGIC[8] = { 'T', 'V', 'C', 'D', 'I', 'C', 'T', '\0' };
+#define DICT_VERSION 2
+#define DICT_ENDIAN_MARK 0x01020304u
+#define DICT_ALIGN 64
+#define DICT_MAX_MEMBERS 8       // equivalent faults listed per candidate
+#define DICT_BUILD_ENTRIES (1 << 24) // failing (vector, fault) pairs inverted at a time
+
+// Encodings of a postings list, its first byte
+enum { POSTINGS_DELTAS, POSTINGS_BITMAP };
+
+// Sections of the file, in file order
+enum {
+    SEC_OUTPUT_NAME, SEC_OUTPUT_NAMES, SEC_CLASS_START, SEC_FAULT_NAME, SEC_FAULT_NAMES,
+    SEC_CLASS_FAILS, SEC_VECTOR_KEYS, SEC_KEY_SYNDROMES, SEC_KEY_POSTINGS, SEC_POSTINGS,
+    NUM_SECTIONS
+};
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_mark;
+    uint32_t pass_fail;
+    int32_t num_vectors;
+    int32_t num_outputs;
+    int32_t num_classes;          // collapsed faults, dominated ones included
+    int32_t num_faults;           // uncollapsed universe
+    int32_t num_responses;        // distinct responses over the classes
+    uint64_t num_keys;            // distinct (vector, syndrome) pairs
+    uint64_t output_names_size;
+    uint64_t fault_names_size;
+    uint64_t postings_size;
+    uint64_t section_offset[NUM_SECTIONS];
+    uint64_t section_bytes[NUM_SECTIONS];
+} DictionaryHeader;
+
+// Growable byte buffer
+typedef struct {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+} ByteBuffer;
+
+// Response of one collapsed fault while the dictionary is built
+typedef struct {
+    ByteBuffer bytes;
+    int last_vector;
+    int num_fails;
+} Response;
+
+typedef struct {
+    Response* responses;
+    bool pass_fail;
+} DictionaryBuilder;
+
+// Keys of the dictionary under construction, in (vector, syndrome) order
+typedef struct {
+    uint64_t* vector_keys;        // row of each vector: keys [vector_keys[v], vector_keys[v + 1])
+    uint32_t* syndromes;
+    uint64_t* postings;           // list of key k: [postings[k], postings[k + 1])
+    uint64_t num_keys;
+    uint64_t capacity;
+    ByteBuffer lists;
+} DictionaryIndex;
+
+// Helper: Code of primary output i in a syndrome
+static uint32_t output_code(int output) {
+    return (uint32_t)(splitmix64((uint64_t)output + 1) >> 32);
+}
+
+static void buffer_reserve(ByteBuffer* b, size_t extra) {
+    if (b->size + extra <= b->capacity) return;
+    b->capacity = 2 * b->capacity + extra + 16;
+    b->data = (uint8_t*)realloc(b->data, b->capacity);
+}
+
+static void buffer_put_varint(ByteBuffer* b, uint64_t value) {
+    buffer_reserve(b, 10);
+    while (value >= 0x80) {
+        b->data[b->size++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    b->data[b->size++] = (uint8_t)value;
+}
+
+static void buffer_put_bytes(ByteBuffer* b, const void* data, size_t size) {
+    buffer_reserve(b, size);
+    memcpy(b->data + b->size, data, size);
+    b->size += size;
+}
+
+static int varint_size(uint64_t value) {
+    int size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+// Helper: Decode a varint; false at the end of the data or on a malformed one
+static bool get_varint(const uint8_t** p, const uint8_t* end, uint64_t* value) {
+    uint64_t result = 0;
+    for (int shift = 0; *p < end && shift < 64; shift += 7) {
+        uint8_t byte = *(*p)++;
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Helper: Next (vector, syndrome) of a captured response, given the previous vector
+static bool next_captured(const uint8_t** p, const uint8_t* end, bool pass_fail, int* vector, uint32_t* syndrome) {
+    uint64_t delta;
+    if (!get_varint(p, end, &delta)) return false;
+    *vector += (int)delta + 1;
+    *syndrome = 0;
+    if (!pass_fail) {
+        if (end - *p < 4) return false;
+        memcpy(syndrome, *p, 4);
+        *p += 4;
+    }
+    return true;
+}
+
+static void dictionary_sink(void* ctx, int fault, int vector, uint32_t syndrome) {
+    DictionaryBuilder* builder = (DictionaryBuilder*)ctx;
+    Response* r = &builder->responses[fault];
+    buffer_put_varint(&r->bytes, (uint64_t)(vector - r->last_vector - 1));
+    if (!builder->pass_fail) buffer_put_bytes(&r->bytes, &syndrome, 4);
+    r->last_vector = vector;
+    r->num_fails++;
+}
+
+// Helper: Fault line text, as in the statistics file
+static void put_fault_name(ByteBuffer* names, const Circuit* circuit, const FaultClassMember* member) {
+    char text[64];
+    const char* net = symtab_name(&circuit->nets, member->net);
+    buffer_put_bytes(names, net, strlen(net));
+    if (member->gate >= 0) {
+        const char* gate = gate_name(circuit, member->gate);
+        buffer_put_bytes(names, " -> ", 4);
+        buffer_put_bytes(names, gate, strlen(gate));
+    }
+    snprintf(text, sizeof(text), ", Stuck-at-%d", member->stuck_at_value);
+    buffer_put_bytes(names, text, strlen(text) + 1);
+}
+
+static int compare_hashes(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Helper: Count the distinct responses, the classes a dictionary can tell apart
+static int count_distinct_responses(const Response* responses, int num_classes) {
+    uint64_t* hashes = (uint64_t*)malloc((num_classes + 1) * sizeof(uint64_t));
+    for (int c = 0; c < num_classes; c++) {
+        hashes[c] = fnv1a64(FNV1A64_INIT, responses[c].bytes.data, responses[c].bytes.size);
+    }
+    qsort(hashes, num_classes, sizeof(uint64_t), compare_hashes);
+    int distinct = 0;
+    for (int c = 0; c < num_classes; c++) {
+        if (c == 0 || hashes[c] != hashes[c - 1]) distinct++;
+    }
+    free(hashes);
+    return distinct;
+}
+
+// Helper: Append the list of one key: ascending fault IDs, as deltas or as
+// a bitmap from the first ID, whichever is shorter
+static void index_add_key(DictionaryIndex* index, uint32_t syndrome, const uint64_t* entries, int count) {
+    if (index->num_keys + 1 >= index->capacity) {
+        index->capacity = 2 * index->capacity + 1024;
+        index->syndromes = (uint32_t*)realloc(index->syndromes, index->capacity * sizeof(uint32_t));
+        index->postings = (uint64_t*)realloc(index->postings, (index->capacity + 1) * sizeof(uint64_t));
+    }
+    index->syndromes[index->num_keys] = syndrome;
+    index->postings[index->num_keys++] = index->lists.size;
+    uint32_t first = (uint32_t)entries[0], last = (uint32_t)entries[count - 1];
+    uint64_t delta_size = 0;
+    for (int i = 0; i < count; i++) {
+        delta_size += varint_size(i == 0 ? first : (uint32_t)entries[i] - (uint32_t)entries[i - 1] - 1);
+    }
+    uint64_t bitmap_size = varint_size(first) + (last - first) / 8 + 1;
+    ByteBuffer* b = &index->lists;
+    if (delta_size <= bitmap_size) {
+        buffer_put_varint(b, POSTINGS_DELTAS);
+        for (int i = 0; i < count; i++) {
+            buffer_put_varint(b, i == 0 ? first : (uint32_t)entries[i] - (uint32_t)entries[i - 1] - 1);
+        }
+        return;
+    }
+    buffer_put_varint(b, POSTINGS_BITMAP);
+    buffer_put_varint(b, first);
+    size_t bits = b->size;
+    buffer_reserve(b, (last - first) / 8 + 1);
+    memset(b->data + bits, 0, (last - first) / 8 + 1);
+    b->size += (last - first) / 8 + 1;
+    for (int i = 0; i < count; i++) {
+        uint32_t offset = (uint32_t)entries[i] - first;
+        b->data[bits + offset / 8] |= (uint8_t)(1u << (offset % 8));
+    }
+}
+
+// Helper: Invert the responses into the per-vector index. Vectors are taken
+// in ranges of about DICT_BUILD_ENTRIES failing (vector, fault) pairs; each
+// range collects the pairs of every fault (faults in increasing order, each
+// resuming where the last range stopped), sorts each vector's pairs by
+// syndrome and writes one key per syndrome.
+static void build_index(DictionaryIndex* index, const Response* responses, int num_classes, int num_vectors,
+                        bool pass_fail) {
+    int* vector_fails = (int*)calloc(num_vectors + 1, sizeof(int));
+    for (int c = 0; c < num_classes; c++) {
+        const uint8_t* p = responses[c].bytes.data;
+        const uint8_t* end = p + responses[c].bytes.size;
+        int vector = -1;
+        uint32_t syndrome;
+        while (p < end && next_captured(&p, end, pass_fail, &vector, &syndrome)) vector_fails[vector]++;
+    }
+    const uint8_t** cursor = (const uint8_t**)malloc((num_classes + 1) * sizeof(uint8_t*));
+    int* cursor_vector = (int*)malloc((num_classes + 1) * sizeof(int));
+    for (int c = 0; c < num_classes; c++) {
+        cursor[c] = responses[c].bytes.data;
+        cursor_vector[c] = -1;
+    }
+    uint64_t* fill = (uint64_t*)malloc((num_vectors + 1) * sizeof(uint64_t));
+    uint64_t* entries = NULL;
+    uint64_t entries_capacity = 0;
+    index->vector_keys = (uint64_t*)malloc((num_vectors + 1) * sizeof(uint64_t));
+    for (int begin = 0, end_vector; begin < num_vectors; begin = end_vector) {
+        // At least one vector per range, however many faults fail on it
+        uint64_t range_entries = vector_fails[begin];
+        for (end_vector = begin + 1; end_vector < num_vectors; end_vector++) {
+            if (range_entries + vector_fails[end_vector] > DICT_BUILD_ENTRIES) break;
+            range_entries += vector_fails[end_vector];
+        }
+        if (range_entries > entries_capacity) {
+            entries_capacity = range_entries;
+            free(entries);
+            entries = (uint64_t*)malloc((entries_capacity + 1) * sizeof(uint64_t));
+        }
+        for (int v = begin, at = 0; v < end_vector; at += vector_fails[v++]) fill[v] = (uint64_t)at;
+        for (int c = 0; c < num_classes; c++) {
+            const uint8_t* end = responses[c].bytes.data + responses[c].bytes.size;
+            while (cursor[c] < end) {
+                const uint8_t* p = cursor[c];
+                int vector = cursor_vector[c];
+                uint32_t syndrome;
+                if (!next_captured(&p, end, pass_fail, &vector, &syndrome) || vector >= end_vector) break;
+                entries[fill[vector]++] = ((uint64_t)syndrome << 32) | (uint32_t)c;
+                cursor[c] = p;
+                cursor_vector[c] = vector;
+            }
+        }
+        // Faults arrive in increasing order, so sorting a vector's pairs keeps
+        // each syndrome's faults ascending
+        for (int v = begin, at = 0; v < end_vector; at += vector_fails[v++]) {
+            index->vector_keys[v] = index->num_keys;
+            uint64_t* list = entries + at;
+            qsort(list, vector_fails[v], sizeof(uint64_t), compare_hashes);
+            for (int i = 0, j; i < vector_fails[v]; i = j) {
+                for (j = i + 1; j < vector_fails[v] && list[j] >> 32 == list[i] >> 32; j++) {
+                }
+                index_add_key(index, (uint32_t)(list[i] >> 32), list + i, j - i);
+            }
+        }
+    }
+    index->vector_keys[num_vectors] = index->num_keys;
+    if (!index->postings) index->postings = (uint64_t*)malloc(sizeof(uint64_t));
+    index->postings[index->num_keys] = index->lists.size;
+    free(entries);
+    free(fill);
+    free(cursor_vector);
+    free(cursor);
+    free(vector_fails);
+}
+
+// Helper: Write the header and sections next to the target and rename
+static bool write_dictionary(const char* filename, DictionaryHeader* header, const void* data[NUM_SECTIONS],
+                             const size_t bytes[NUM_SECTIONS]) {
+    uint64_t offset = (sizeof(DictionaryHeader) + DICT_ALIGN - 1) & ~(uint64_t)(DICT_ALIGN - 1);
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        header->section_offset[s] = offset;
+        header->section_bytes[s] = bytes[s];
+        offset = (offset + bytes[s] + DICT_ALIGN - 1) & ~(uint64_t)(DICT_ALIGN - 1);
+    }
+    size_t name_len = strlen(filename);
+    char* temp_filename = (char*)malloc(name_len + 5);
+    memcpy(temp_filename, filename, name_len);
+    memcpy(temp_filename + name_len, ".tmp", 5);
+    FILE* file = fopen(temp_filename, "wb");
+    if (!file) {
+        perror("Error opening fault dictionary file");
+        free(temp_filename);
+        return false;
+    }
+    static const char padding[DICT_ALIGN] = { 0 };
+    uint64_t written = sizeof(DictionaryHeader);
+    fwrite(header, sizeof(*header), 1, file);
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        fwrite(padding, 1, header->section_offset[s] - written, file);
+        if (bytes[s] > 0) fwrite(data[s], 1, bytes[s], file);
+        written = header->section_offset[s] + bytes[s];
+    }
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) ok = false;
+    if (!ok) perror("Error writing fault dictionary file");
+    if (ok && rename(temp_filename, filename) != 0) {
+        perror("Error renaming fault dictionary file");
+        ok = false;
+    }
+    if (!ok) remove(temp_filename);
+    free(temp_filename);
+    return ok;
+}
+
+int build_fault_dictionary(const char* filename, Circuit* circuit, const TestVectors* tv, const SimOptions* options,
+                           const DictionaryOptions* dictionary) {
+    int num_classes = circuit->num_faults + circuit->num_dominated_faults;
+    int num_outputs = circuit->num_primary_outputs;
+    if (!options->quiet) {
+        printf("\nBuilding fault dictionary (%s, %d collapsed faults, no dropping)...\n",
+               dictionary->pass_fail ? "pass/fail" : "output syndromes", num_classes);
+    }
+    uint32_t* codes = (uint32_t*)calloc(num_outputs + 1, sizeof(uint32_t));
+    for (int i = 0; i < num_outputs && !dictionary->pass_fail; i++) codes[i] = output_code(i);
+    DictionaryBuilder builder;
+    builder.pass_fail = dictionary->pass_fail;
+    builder.responses = (Response*)calloc(num_classes + 1, sizeof(Response));
+    for (int c = 0; c < num_classes; c++) builder.responses[c].last_vector = -1;
+    capture_ppsfp_responses(circuit, tv, options, codes, dictionary_sink, &builder);
+    free(codes);
+
+    int32_t* class_fails = (int32_t*)malloc((num_classes + 1) * sizeof(int32_t));
+    uint64_t num_failures = 0;
+    for (int c = 0; c < num_classes; c++) {
+        class_fails[c] = builder.responses[c].num_fails;
+        num_failures += builder.responses[c].num_fails;
+    }
+    DictionaryIndex index;
+    memset(&index, 0, sizeof(index));
+    build_index(&index, builder.responses, num_classes, tv->num_vectors, builder.pass_fail);
+    int num_responses = count_distinct_responses(builder.responses, num_classes);
+    for (int c = 0; c < num_classes; c++) free(builder.responses[c].bytes.data);
+
+    // Names, so a log can be diagnosed without the netlist
+    ByteBuffer output_names = { NULL, 0, 0 }, fault_names = { NULL, 0, 0 };
+    uint32_t* output_name = (uint32_t*)malloc((num_outputs + 1) * sizeof(uint32_t));
+    for (int i = 0; i < num_outputs; i++) {
+        const char* name = symtab_name(&circuit->nets, circuit->primary_outputs[i]);
+        output_name[i] = (uint32_t)output_names.size;
+        buffer_put_bytes(&output_names, name, strlen(name) + 1);
+    }
+    uint32_t* fault_name = (uint32_t*)malloc((circuit->num_uncollapsed_faults + 1) * sizeof(uint32_t));
+    bool names_fit = true;
+    for (int u = 0; u < circuit->num_uncollapsed_faults; u++) {
+        if (fault_names.size > UINT32_MAX) names_fit = false;
+        fault_name[u] = (uint32_t)fault_names.size;
+        put_fault_name(&fault_names, circuit, &circuit->fault_classes[u]);
+    }
+
+    DictionaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DICT_MAGIC, sizeof(DICT_MAGIC));
+    header.version = DICT_VERSION;
+    header.endian_mark = DICT_ENDIAN_MARK;
+    header.pass_fail = dictionary->pass_fail;
+    header.num_vectors = tv->num_vectors;
+    header.num_outputs = num_outputs;
+    header.num_classes = num_classes;
+    header.num_faults = circuit->num_uncollapsed_faults;
+    header.num_responses = num_responses;
+    header.num_keys = index.num_keys;
+    header.output_names_size = output_names.size;
+    header.fault_names_size = fault_names.size;
+    header.postings_size = index.lists.size;
+    const void* data[NUM_SECTIONS] = {
+        output_name, output_names.data, circuit->class_start, fault_name, fault_names.data,
+        class_fails, index.vector_keys, index.syndromes, index.postings, index.lists.data
+    };
+    size_t bytes[NUM_SECTIONS] = {
+        num_outputs * sizeof(uint32_t), output_names.size, (num_classes + 1) * sizeof(int32_t),
+        circuit->num_uncollapsed_faults * sizeof(uint32_t), fault_names.size, num_classes * sizeof(int32_t),
+        ((size_t)tv->num_vectors + 1) * sizeof(uint64_t), index.num_keys * sizeof(uint32_t),
+        (index.num_keys + 1) * sizeof(uint64_t), index.lists.size
+    };
+    bool ok = names_fit;
+    if (!names_fit) fprintf(stderr, "Error: fault names exceed the 4 GB a dictionary can hold\n");
+    if (ok) ok = write_dictionary(filename, &header, data, bytes);
+    if (ok && !options->quiet) {
+        printf("Fault dictionary %s: %d collapsed faults, %d distinct responses, %llu failing vectors in %.1f MB.\n",
+               filename, num_classes, header.num_responses, (unsigned long long)num_failures,
+               (header.section_offset[NUM_SECTIONS - 1] + index.lists.size) / 1048576.0);
+    }
+
+    free(builder.responses);
+    free(fault_name);
+    free(output_name);
+    free(fault_names.data);
+    free(output_names.data);
+    free(index.lists.data);
+    free(index.postings);
+    free(index.syndromes);
+    free(index.vector_keys);
+    free(class_fails);
+    return ok ? 0 : -1;
+}
+
+// Dictionary mapped for diagnosis
+typedef struct {
+    MappedFile file;
+    const DictionaryHeader* header;
+    const uint8_t* section[NUM_SECTIONS];
+} Dictionary;
+
+// Helper: Map a dictionary and check its header and section table
+static bool open_dictionary(const char* filename, Dictionary* d) {
+    if (!map_file(filename, &d->file)) {
+        perror("Error opening fault dictionary");
+        return false;
+    }
+    const DictionaryHeader* h = (const DictionaryHeader*)d->file.data;
+    d->header = h;
+    if (d->file.size < sizeof(DictionaryHeader) || memcmp(h->magic, DICT_MAGIC, sizeof(DICT_MAGIC)) != 0 ||
+        h->version != DICT_VERSION || h->endian_mark != DICT_ENDIAN_MARK) {
+        fprintf(stderr, "Error: %s is not a fault dictionary for this build\n", filename);
+        unmap_file(&d->file);
+        return false;
+    }
+    size_t bytes[NUM_SECTIONS] = {
+        (size_t)h->num_outputs * sizeof(uint32_t), h->output_names_size, ((size_t)h->num_classes + 1) * sizeof(int32_t),
+        (size_t)h->num_faults * sizeof(uint32_t), h->fault_names_size,
+        (size_t)h->num_classes * sizeof(int32_t), ((size_t)h->num_vectors + 1) * sizeof(uint64_t),
+        h->num_keys * sizeof(uint32_t), (h->num_keys + 1) * sizeof(uint64_t), h->postings_size
+    };
+    bool ok = h->num_vectors >= 0 && h->num_outputs >= 0 && h->num_classes >= 0 && h->num_faults >= 0 &&
+              h->num_keys < ((uint64_t)1 << 60);
+    for (int s = 0; ok && s < NUM_SECTIONS; s++) {
+        uint64_t offset = h->section_offset[s];
+        ok = h->section_bytes[s] == bytes[s] && offset % DICT_ALIGN == 0 && offset <= d->file.size &&
+             bytes[s] <= d->file.size - offset;
+        d->section[s] = (const uint8_t*)d->file.data + offset;
+    }
+    // Names and classes are read without further checks
+    const uint32_t* output_name = (const uint32_t*)d->section[SEC_OUTPUT_NAME];
+    const char* output_names = (const char*)d->section[SEC_OUTPUT_NAMES];
+    const char* fault_names = (const char*)d->section[SEC_FAULT_NAMES];
+    const int32_t* class_start = (const int32_t*)d->section[SEC_CLASS_START];
+    if (ok) {
+        ok = (h->output_names_size == 0 || output_names[h->output_names_size - 1] == '\0') &&
+             (h->fault_names_size == 0 || fault_names[h->fault_names_size - 1] == '\0') &&
+             class_start[0] == 0 && class_start[h->num_classes] == h->num_faults;
+    }
+    for (int i = 0; ok && i < h->num_outputs; i++) ok = output_name[i] < h->output_names_size;
+    for (int c = 0; ok && c < h->num_classes; c++) ok = class_start[c] <= class_start[c + 1];
+    if (!ok) {
+        fprintf(stderr, "Error: fault dictionary %s is truncated or corrupt\n", filename);
+        unmap_file(&d->file);
+        return false;
+    }
+    return true;
+}
+
+// Helper: Find key (vector, syndrome) by binary search in the row of the
+// vector and return its list in [*list, *end). Returns false if the key is
+// absent; a row or list outside its section also clears *ok.
+static bool find_key(const Dictionary* d, int vector, uint32_t syndrome, const uint8_t** list, const uint8_t** end,
+                     bool* ok) {
+    const DictionaryHeader* h = d->header;
+    const uint64_t* vector_keys = (const uint64_t*)d->section[SEC_VECTOR_KEYS];
+    const uint32_t* syndromes = (const uint32_t*)d->section[SEC_KEY_SYNDROMES];
+    const uint64_t* postings = (const uint64_t*)d->section[SEC_KEY_POSTINGS];
+    uint64_t low = vector_keys[vector], high = vector_keys[vector + 1];
+    if (low > high || high > h->num_keys) {
+        *ok = false;
+        return false;
+    }
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        if (syndromes[mid] < syndrome) low = mid + 1;
+        else high = mid;
+    }
+    if (low == vector_keys[vector + 1] || syndromes[low] != syndrome) return false;
+    if (postings[low] > postings[low + 1] || postings[low + 1] > h->postings_size) {
+        *ok = false;
+        return false;
+    }
+    *list = d->section[SEC_POSTINGS] + postings[low];
+    *end = d->section[SEC_POSTINGS] + postings[low + 1];
+    return true;
+}
+
+// Helper: Decode a list into ascending fault IDs; false if it is malformed
+static bool decode_postings(const uint8_t* p, const uint8_t* end, int num_classes, int** faults, int* count,
+                            int* capacity) {
+    uint64_t encoding, first;
+    *count = 0;
+    if (!get_varint(&p, end, &encoding)) return false;
+    if (encoding == POSTINGS_DELTAS) {
+        for (int fault = -1; p < end;) {
+            uint64_t delta;
+            if (!get_varint(&p, end, &delta) || delta >= (uint64_t)(num_classes - fault - 1)) return false;
+            fault += (int)delta + 1;
+            if (*count == *capacity) {
+                *capacity *= 2;
+                *faults = (int*)realloc(*faults, *capacity * sizeof(int));
+            }
+            (*faults)[(*count)++] = fault;
+        }
+        return true;
+    }
+    if (encoding != POSTINGS_BITMAP || !get_varint(&p, end, &first) || first >= (uint64_t)num_classes ||
+        (uint64_t)(end - p) > ((uint64_t)num_classes - first + 7) / 8) {
+        return false;
+    }
+    for (uint64_t bit = 0; bit < 8 * (uint64_t)(end - p); bit++) {
+        if (!(p[bit / 8] & (1u << (bit % 8)))) continue;
+        if (first + bit >= (uint64_t)num_classes) return false;
+        if (*count == *capacity) {
+            *capacity *= 2;
+            *faults = (int*)realloc(*faults, *capacity * sizeof(int));
+        }
+        (*faults)[(*count)++] = (int)(first + bit);
+    }
+    return true;
+}
+
+// One failing output of the tester log
+typedef struct {
+    int vector;
+    int output;
+} ObservedFailure;
+
+static int compare_failures(const void* a, const void* b) {
+    const ObservedFailure* x = (const ObservedFailure*)a;
+    const ObservedFailure* y = (const ObservedFailure*)b;
+    if (x->vector != y->vector) return x->vector < y->vector ? -1 : 1;
+    return (x->output > y->output) - (x->output < y->output);
+}
+
+// Helper: Read "<vector> <output>..." lines (vectors numbered from 0) into
+// failing outputs, sorted and without repeats. Pass/fail dictionaries take
+// lines without outputs as well, recorded with output -1.
+static ObservedFailure* read_failure_log(const char* filename, const Dictionary* d, int* count) {
+    MappedFile log;
+    if (!map_file(filename, &log)) {
+        perror("Error opening failure log");
+        return NULL;
+    }
+    const DictionaryHeader* h = d->header;
+    const uint32_t* output_name = (const uint32_t*)d->section[SEC_OUTPUT_NAME];
+    const char* output_names = (const char*)d->section[SEC_OUTPUT_NAMES];
+    SymbolTable outputs;
+    symtab_init(&outputs);
+    int* first_output = (int*)malloc((h->num_outputs + 1) * sizeof(int));
+    for (int i = 0; i < h->num_outputs; i++) {
+        int known = outputs.count;
+        int id = symtab_intern(&outputs, output_names + output_name[i]);
+        if (outputs.count > known) first_output[id] = i;
+    }
+    int capacity = 64, num_failures = 0, line_num = 0;
+    ObservedFailure* failures = (ObservedFailure*)malloc(capacity * sizeof(ObservedFailure));
+    size_t name_capacity = 256;
+    char* name = (char*)malloc(name_capacity);
+    const char* p = log.data;
+    const char* end = log.data + log.size;
+    bool ok = true;
+    while (ok && p < end) {
+        const char* line_end = (const char*)memchr(p, '\n', end - p);
+        if (!line_end) line_end = end;
+        line_num++;
+        int vector = -1, num_outputs = 0;
+        while (ok) {
+            while (p < line_end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == ',')) p++;
+            if (p == line_end || *p == '#') break;
+            const char* token = p;
+            while (p < line_end && *p != ' ' && *p != '\t' && *p != '\r' && *p != ',') p++;
+            size_t len = (size_t)(p - token);
+            if (len + 1 > name_capacity) {
+                name_capacity = 2 * len + 1;
+                name = (char*)realloc(name, name_capacity);
+            }
+            memcpy(name, token, len);
+            name[len] = '\0';
+            if (vector < 0) {
+                char* number_end;
+                long value = strtol(name, &number_end, 10);
+                if (*number_end != '\0' || value < 0 || value >= h->num_vectors) {
+                    fprintf(stderr, "Error: %s line %d: expected a vector number from 0 to %d\n", filename, line_num,
+                            h->num_vectors - 1);
+                    ok = false;
+                }
+                vector = (int)value;
+                continue;
+            }
+            int id = symtab_lookup(&outputs, name);
+            if (id < 0) {
+                fprintf(stderr, "Error: %s line %d: '%s' is not a primary output\n", filename, line_num, name);
+                ok = false;
+                break;
+            }
+            if (num_failures == capacity) {
+                capacity *= 2;
+                failures = (ObservedFailure*)realloc(failures, capacity * sizeof(ObservedFailure));
+            }
+            failures[num_failures].vector = vector;
+            failures[num_failures++].output = first_output[id];
+            num_outputs++;
+        }
+        if (ok && vector >= 0 && num_outputs == 0) {
+            if (!h->pass_fail) {
+                fprintf(stderr, "Error: %s line %d: vector %d lists no failing output\n", filename, line_num, vector);
+                ok = false;
+            } else {
+                if (num_failures == capacity) {
+                    capacity *= 2;
+                    failures = (ObservedFailure*)realloc(failures, capacity * sizeof(ObservedFailure));
+                }
+                failures[num_failures].vector = vector;
+                failures[num_failures++].output = -1;
+            }
+        }
+        p = line_end + (line_end < end);
+    }
+    free(name);
+    free(first_output);
+    symtab_free(&outputs);
+    unmap_file(&log);
+    if (!ok) {
+        free(failures);
+        return NULL;
+    }
+    qsort(failures, num_failures, sizeof(ObservedFailure), compare_failures);
+    int unique = 0;
+    for (int i = 0; i < num_failures; i++) {
+        if (unique == 0 || compare_failures(&failures[i], &failures[unique - 1]) != 0) failures[unique++] = failures[i];
+    }
+    *count = unique;
+    return failures;
+}
+
+// Candidate fault: tester-fail/sim-fail matches, tester-fail/sim-pass and
+// tester-pass/sim-fail mismatches
+typedef struct {
+    int fault;
+    int matched;
+    int mismatched;
+} Candidate;
+
+// Helper: Ranking order: most matches, then fewest mismatches, then fault ID
+static bool candidate_before(const Candidate* a, const Candidate* b) {
+    if (a->matched != b->matched) return a->matched > b->matched;
+    if (a->mismatched != b->mismatched) return a->mismatched < b->mismatched;
+    return a->fault < b->fault;
+}
+
+int diagnose_failures(const char* dictionary_filename, const char* log_filename, int max_candidates) {
+    double start = wall_seconds();
+    Dictionary d;
+    if (!open_dictionary(dictionary_filename, &d)) return -1;
+    const DictionaryHeader* h = d.header;
+    int num_failures = 0;
+    ObservedFailure* failures = read_failure_log(log_filename, &d, &num_failures);
+    if (!failures) {
+        unmap_file(&d.file);
+        return -1;
+    }
+
+    // Syndrome of every failing vector of the log, in place of its outputs
+    int num_vectors = 0, num_outputs = 0;
+    for (int i = 0; i < num_failures; i++) {
+        int output = failures[i].output;
+        if (i == 0 || failures[i].vector != failures[i - 1].vector) {
+            failures[num_vectors].vector = failures[i].vector;
+            failures[num_vectors++].output = 0;
+        }
+        if (output < 0) continue;
+        num_outputs++;
+        if (!h->pass_fail) failures[num_vectors - 1].output ^= (int)output_code(output);
+    }
+
+    // Count, per fault, the failing vectors its response reproduces exactly
+    int* score = (int*)calloc(h->num_classes + 1, sizeof(int));
+    int capacity = 1024, num_candidates = 0;
+    int* candidates = (int*)malloc(capacity * sizeof(int));
+    int list_size = 0, list_capacity = 1024;
+    int* list = (int*)malloc(list_capacity * sizeof(int));
+    bool ok = true;
+    for (int i = 0; ok && i < num_vectors; i++) {
+        const uint8_t* p;
+        const uint8_t* end;
+        if (!find_key(&d, failures[i].vector, (uint32_t)failures[i].output, &p, &end, &ok)) list_size = 0;
+        else ok = decode_postings(p, end, h->num_classes, &list, &list_size, &list_capacity);
+        for (int k = 0; ok && k < list_size; k++) {
+            int fault = list[k];
+            if (score[fault]++ > 0) continue;
+            if (num_candidates == capacity) {
+                capacity *= 2;
+                candidates = (int*)realloc(candidates, capacity * sizeof(int));
+            }
+            candidates[num_candidates++] = fault;
+        }
+        if (!ok) fprintf(stderr, "Error: fault dictionary %s is corrupt\n", dictionary_filename);
+    }
+
+    // Keep the best max_candidates by insertion; most faults fall off at once
+    const int32_t* class_fails = (const int32_t*)d.section[SEC_CLASS_FAILS];
+    Candidate* best = (Candidate*)malloc((max_candidates + 1) * sizeof(Candidate));
+    int num_best = 0;
+    for (int i = 0; ok && i < num_candidates; i++) {
+        Candidate c;
+        c.fault = candidates[i];
+        c.matched = score[c.fault];
+        c.mismatched = (num_vectors - c.matched) + (class_fails[c.fault] - c.matched);
+        if (num_best == max_candidates && !candidate_before(&c, &best[num_best - 1])) continue;
+        int j = num_best < max_candidates ? num_best++ : num_best - 1;
+        for (; j > 0 && candidate_before(&c, &best[j - 1]); j--) best[j] = best[j - 1];
+        best[j] = c;
+    }
+    double elapsed = wall_seconds() - start;
+
+    if (ok) {
+        printf("Fault dictionary %s: %d vectors, %d outputs, %d faults in %d collapsed classes (%s).\n",
+               dictionary_filename, h->num_vectors, h->num_outputs, h->num_faults, h->num_classes,
+               h->pass_fail ? "pass/fail" : "output syndromes");
+        printf("Failure log %s: %d failing vectors, %d failing outputs.\n", log_filename, num_vectors, num_outputs);
+        printf("%d collapsed faults explain part of the log; best %d (failing vectors matched, mismatched):\n",
+               num_candidates, num_best);
+        const int32_t* class_start = (const int32_t*)d.section[SEC_CLASS_START];
+        const uint32_t* fault_name = (const uint32_t*)d.section[SEC_FAULT_NAME];
+        const char* fault_names = (const char*)d.section[SEC_FAULT_NAMES];
+        for (int i = 0; i < num_best; i++) {
+            const Candidate* c = &best[i];
+            printf("%3d. %d matched, %d mismatched%s\n", i + 1, c->matched, c->mismatched,
+                   c->mismatched == 0 ? " (exact match)" : "");
+            int members = class_start[c->fault + 1] - class_start[c->fault];
+            for (int m = 0; m < members && m < DICT_MAX_MEMBERS; m++) {
+                uint32_t offset = fault_name[class_start[c->fault] + m];
+                printf("     - Node: %s\n", offset < h->fault_names_size ? fault_names + offset : "?");
+            }
+            if (members > DICT_MAX_MEMBERS) printf("     ... and %d more equivalent faults\n", members - DICT_MAX_MEMBERS);
+        }
+        printf("Diagnosis took %.3f ms.\n", elapsed * 1e3);
+    }
+    free(best);
+    free(list);
+    free(candidates);
+    free(score);
+    free(failures);
+    unmap_file(&d.file);
+    return ok ? 0 : -1;
+}
@@ -1,215 +1,198 @@
 #include "fault_simulator.h"
+#include <time.h>
 
-// Helper: Find gate by name
-Gate* find_gate(Circuit* circuit, const char* name) {
-    for (int i = 0; i < circuit->num_gates; i++) {
-        if (strcmp(circuit->gates[i].name, name) == 0 || strcmp(circuit->gates[i].output, name) == 0) {
-            return &circuit->gates[i];
-        }
+const char* gate_name(const Circuit* circuit, int gate) {
+    return circuit->gate_names + circuit->gate_name[gate];
+}
+
+uint64_t fnv1a64(uint64_t h, const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 1099511628211ull;
     }
-    return NULL;
+    return h;
 }
 
-// Helper: Gate type string to enum
-GateType get_gate_type(const char* type_str) {
-    if (strcmp(type_str, "and") == 0) return AND;
-    if (strcmp(type_str, "or") == 0) return OR;
-    if (strcmp(type_str, "not") == 0) return NOT;
-    if (strcmp(type_str, "nand") == 0) return NAND;
-    if (strcmp(type_str, "nor") == 0) return NOR;
-    if (strcmp(type_str, "xor") == 0) return XOR;
-    if (strcmp(type_str, "xnor") == 0) return XNOR;
-    if (strcmp(type_str, "buf") == 0) return BUF;
-    return -1;
+uint64_t splitmix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
 }
 
+double wall_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
 
-// Parse Verilog (copied from v1)
-Circuit* parse_verilog(const char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        perror("Error opening Verilog file");
+void record_detection(Fault* fault, int vector) {
+    if (!fault->detected || vector < fault->first_detected_vector) fault->first_detected_vector = vector;
+    fault->detected = true;
+}
+
+Circuit* build_circuit(const char* netlist_filename, bool full_scan, bool dominance, bool quiet) {
+    if (!quiet) printf("Parsing netlist file: %s\n", netlist_filename);
+    INSTR(instrument_phase_begin(PHASE_PARSE));
+    Circuit* circuit = parse_netlist(netlist_filename);
+    INSTR(instrument_phase_end(PHASE_PARSE));
+    if (!circuit) {
+        fprintf(stderr, "Failed to parse netlist file.\n");
         return NULL;
     }
-    Circuit* circuit = (Circuit*)malloc(sizeof(Circuit));
-    circuit->gates = NULL;
-    circuit->num_gates = 0;
-    circuit->primary_inputs = NULL;
-    circuit->num_primary_inputs = 0;
-    circuit->primary_outputs = NULL;
-    circuit->num_primary_outputs = 0;
-    char line[1024];
-    int line_num = 0;
-    while (fgets(line, sizeof(line), file)) {
-        line_num++;
-        char* token = strtok(line, " \t\n\r(),;");
-        if (token == NULL || strcmp(token, "//") == 0) continue;
-        if (strcmp(token, "module") == 0) {
-            strtok(NULL, " \t\n\r(),;");
-        } else if (strcmp(token, "input") == 0) {
-            while ((token = strtok(NULL, " \t\n\r(),;")) != NULL) {
-                circuit->num_primary_inputs++;
-                circuit->primary_inputs = (char**)realloc(circuit->primary_inputs, circuit->num_primary_inputs * sizeof(char*));
-                circuit->primary_inputs[circuit->num_primary_inputs - 1] = strdup(token);
-                circuit->num_gates++;
-                circuit->gates = (Gate*)realloc(circuit->gates, circuit->num_gates * sizeof(Gate));
-                Gate* new_gate = &circuit->gates[circuit->num_gates-1];
-                strcpy(new_gate->name, token);
-                strcpy(new_gate->output, token);
-                new_gate->type = INPUT;
-                new_gate->num_inputs = 0;
-                new_gate->fanout_count = 0;
-                new_gate->fanouts = NULL;
-            }
-        } else if (strcmp(token, "output") == 0) {
-            while ((token = strtok(NULL, " \t\n\r(),;")) != NULL) {
-                circuit->num_primary_outputs++;
-                circuit->primary_outputs = (char**)realloc(circuit->primary_outputs, circuit->num_primary_outputs * sizeof(char*));
-                circuit->primary_outputs[circuit->num_primary_outputs - 1] = strdup(token);
-            }
-        } else if (strcmp(token, "wire") == 0) {
-            continue;
-        } else if (strcmp(token, "endmodule") == 0) {
-            continue;
-        } else { // Gate instantiation
-            GateType type = get_gate_type(token);
-            char* gate_name = strtok(NULL, " \t\n\r(),;");
-            circuit->num_gates++;
-            circuit->gates = (Gate*)realloc(circuit->gates, circuit->num_gates * sizeof(Gate));
-            Gate* new_gate = &circuit->gates[circuit->num_gates - 1];
-            strcpy(new_gate->name, gate_name);
-            new_gate->type = type;
-            char* output = strtok(NULL, " \t\n\r(),;");
-            strcpy(new_gate->output, output);
-            new_gate->num_inputs = 0;
-            while ((token = strtok(NULL, " \t\n\r(),;")) != NULL) {
-                strcpy(new_gate->inputs[new_gate->num_inputs], token);
-                new_gate->num_inputs++;
-            }
-            new_gate->fanout_count = 0;
-            new_gate->fanouts = NULL;
-        }
+    if (!quiet) printf("Parsing complete. Found %d gates, %d inputs, %d outputs.\n", circuit->num_gates, circuit->num_primary_inputs, circuit->num_primary_outputs);
+
+    int num_flip_flops = count_flip_flops(circuit);
+    if (num_flip_flops > 0 && full_scan) {
+        Circuit* scanned = full_scan_circuit(circuit);
+        free_circuit(circuit);
+        circuit = scanned;
+        if (!quiet) printf("Full scan: %d flip-flops became pseudo inputs and outputs (%d inputs, %d outputs).\n",
+                           num_flip_flops, circuit->num_primary_inputs, circuit->num_primary_outputs);
+    } else if (num_flip_flops > 0) {
+        // Dominance does not carry over to sequential circuits
+        dominance = false;
     }
-    fclose(file);
-    for (int i = 0; i < circuit->num_gates; i++) {
-        for (int j = 0; j < circuit->gates[i].num_inputs; j++) {
-            Gate* fanin_gate = find_gate(circuit, circuit->gates[i].inputs[j]);
-            if(fanin_gate){
-                circuit->gates[i].fanins[j] = fanin_gate;
-                fanin_gate->fanout_count++;
-                fanin_gate->fanouts = (Gate**)realloc(fanin_gate->fanouts, fanin_gate->fanout_count * sizeof(Gate*));
-                fanin_gate->fanouts[fanin_gate->fanout_count-1] = &circuit->gates[i];
-            }
-        }
+
+    if (!quiet) printf("Levelizing circuit...\n");
+    INSTR(instrument_phase_begin(PHASE_LEVELIZE));
+    bool levelized = levelize_circuit(circuit);
+    INSTR(instrument_phase_end(PHASE_LEVELIZE));
+    if (!levelized) {
+        fprintf(stderr, "Failed to levelize circuit.\n");
+        free_circuit(circuit);
+        return NULL;
     }
+    if (!quiet) printf("Levelization complete. %d gates in %d levels.\n", circuit->program.num_ops, circuit->program.num_levels);
+
+    if (!quiet) printf("Creating collapsed fault list...\n");
+    INSTR(instrument_phase_begin(PHASE_COLLAPSE));
+    create_collapsed_fault_list(circuit, dominance);
+    INSTR(instrument_phase_end(PHASE_COLLAPSE));
+    if (!quiet) printf("Fault list created with %d collapsed faults out of %d.\n", circuit->num_faults, circuit->num_uncollapsed_faults);
     return circuit;
 }
 
-void create_collapsed_fault_list(Circuit* circuit) {
-    circuit->faults = NULL;
-    circuit->num_faults = 0;
-    for (int i = 0; i < circuit->num_gates; i++) {
-        Gate* gate = &circuit->gates[i];
-        for (int j = 0; j < 2; j++) {
-            circuit->num_faults++;
-            circuit->faults = (Fault*)realloc(circuit->faults, circuit->num_faults * sizeof(Fault));
-            Fault* new_fault = &circuit->faults[circuit->num_faults - 1];
-            strcpy(new_fault->node_name, gate->output);
-            new_fault->stuck_at_value = j;
-            new_fault->detected = false;
-            gate->faults[j] = new_fault;
-        }
+static void run_engine(const char* engine, Circuit* circuit, const TestVectors* tv, const SimOptions* options) {
+    if (strcmp(engine, "ppsfp") == 0) {
+        run_ppsfp_simulation(circuit, tv, options);
+    } else if (strcmp(engine, "sequential") == 0) {
+        run_sequential_simulation(circuit, tv, options);
+    } else {
+        run_deductive_simulation(circuit, tv, options);
     }
 }
 
-int** read_test_vectors(const char* filename, int* num_vectors, int* num_inputs) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        perror("Error opening test vector file");
-        return NULL;
-    }
-    int** vectors = NULL;
-    *num_vectors = 0;
-    *num_inputs = 0;
-    char line[1024];
-    while (fgets(line, sizeof(line), file)) {
-        if (*num_vectors == 0) {
-            int count = 0;
-            char* tmp = strdup(line);
-            char* token = strtok(tmp, " \t\n\r");
-            while (token) {
-                count++;
-                token = strtok(NULL, " \t\n\r");
-            }
-            *num_inputs = count;
-            free(tmp);
-        }
-        (*num_vectors)++;
-        vectors = (int**)realloc(vectors, (*num_vectors) * sizeof(int*));
-        vectors[*num_vectors - 1] = (int*)malloc((*num_inputs) * sizeof(int));
-        int idx = 0;
-        char* token = strtok(line, " \t\n\r");
-        while (token && idx < *num_inputs) {
-            vectors[*num_vectors - 1][idx] = atoi(token);
-            idx++;
-            token = strtok(NULL, " \t\n\r");
-        }
+// Helper: A view of the circuit whose fault list runs on through the classes
+// dropped by dominance. The engines simulate those as ordinary faults in the
+// same pass: crediting them from the faults they dominate gives only an
+// upper bound on the first detecting vector, and simulating the rest in a
+// second pass repeats the good-machine work for every vector.
+static Circuit all_classes_view(const Circuit* circuit) {
+    Circuit view = *circuit;
+    view.num_faults = circuit->num_faults + circuit->num_dominated_faults;
+    view.num_dominated_faults = 0;
+    return view;
+}
+
+// Simulate the collapsed faults, dominated classes included, with one engine
+void run_fault_simulation(const char* engine, Circuit* circuit, const TestVectors* tv, const SimOptions* options) {
+    Circuit view = all_classes_view(circuit);
+    run_engine(engine, &view, tv, options);
+}
+
+// Stuck-at and transition faults in one PPSFP pass over the vectors
+void run_transition_simulation(Circuit* circuit, Circuit* transition, const TestVectors* tv, const SimOptions* options) {
+    Circuit view = all_classes_view(circuit);
+    run_ppsfp_transitions(&view, transition, tv, options);
+}
+
+// Helper: One fault line of the statistics file
+static void write_fault(FILE* file, const Circuit* circuit, const FaultClassMember* member, bool transition) {
+    char model[16];
+    if (transition) snprintf(model, sizeof(model), "%s", member->stuck_at_value ? "Slow-to-Fall" : "Slow-to-Rise");
+    else snprintf(model, sizeof(model), "Stuck-at-%d", member->stuck_at_value);
+    if (member->gate < 0) {
+        fprintf(file, "- Node: %s, %s\n", symtab_name(&circuit->nets, member->net), model);
+    } else {
+        fprintf(file, "- Node: %s -> %s, %s\n", symtab_name(&circuit->nets, member->net),
+                gate_name(circuit, member->gate), model);
     }
-    fclose(file);
-    return vectors;
 }
 
-// Improved deductive simulation logic
-void run_deductive_simulation(Circuit* circuit, int** test_vectors, int num_vectors, int num_inputs) {
-    printf("\nRunning Improved Deductive Fault Simulation...\n");
-    // For each test vector, simulate the circuit and propagate faults
-    for (int v = 0; v < num_vectors; v++) {
-        // 1. Set primary inputs
-        for (int i = 0; i < circuit->num_primary_inputs; i++) {
-            Gate* g = find_gate(circuit, circuit->primary_inputs[i]);
-            if (g) g->value = test_vectors[v][i] ? ONE : ZERO;
-        }
-        // 2. Propagate values through the circuit
-        for (int g = 0; g < circuit->num_gates; g++) {
-            Gate* gate = &circuit->gates[g];
-            if (gate->type == INPUT) continue;
-            LogicValue in0 = (gate->num_inputs > 0 && gate->fanins[0]) ? gate->fanins[0]->value : X;
-            LogicValue in1 = (gate->num_inputs > 1 && gate->fanins[1]) ? gate->fanins[1]->value : X;
-            switch (gate->type) {
-                case AND: gate->value = (in0 == ONE && in1 == ONE) ? ONE : ZERO; break;
-                case OR:  gate->value = (in0 == ONE || in1 == ONE) ? ONE : ZERO; break;
-                case NOT: gate->value = (in0 == ONE) ? ZERO : (in0 == ZERO ? ONE : X); break;
-                case NAND: gate->value = (in0 == ONE && in1 == ONE) ? ZERO : ONE; break;
-                case NOR:  gate->value = (in0 == ONE || in1 == ONE) ? ZERO : ONE; break;
-                case XOR:  gate->value = (in0 != in1) ? ONE : ZERO; break;
-                case XNOR: gate->value = (in0 == in1) ? ONE : ZERO; break;
-                case BUF:  gate->value = in0; break;
-                default: gate->value = X; break;
-            }
+// Helper: Transition fault section, after the stuck-at one. Launch/capture
+// pairs are consecutive vectors; pair p captures on vector p.
+static void write_transition_faults(FILE* file, const Circuit* transition, int num_vectors) {
+    int num_universe = transition->num_uncollapsed_faults;
+    const FaultClassMember* members = transition->fault_classes;
+    int detected_faults = 0, potential_faults = 0;
+    for (int u = 0; u < num_universe; u++) {
+        const Fault* fault = &transition->faults[members[u].collapsed];
+        if (fault->detected) detected_faults++;
+        else if (fault->potential) potential_faults++;
+    }
+    fprintf(file, "\nTransition Faults:\n");
+    fprintf(file, "- Total Faults: %d (slow-to-rise and slow-to-fall)\n", num_universe);
+    fprintf(file, "- Total Collapsed Faults: %d (%.2f%% of total)\n", transition->num_faults,
+            num_universe > 0 ? 100.0 * transition->num_faults / num_universe : 0.0);
+    fprintf(file, "- Launch/Capture Pairs Applied: %d\n", num_vectors > 0 ? num_vectors - 1 : 0);
+    fprintf(file, "- Detected Faults: %d\n", detected_faults);
+    fprintf(file, "- Undetected Faults: %d\n", num_universe - detected_faults);
+    fprintf(file, "- Fault Coverage: %.2f%%\n", num_universe > 0 ? 100.0 * detected_faults / num_universe : 0.0);
+    if (potential_faults > 0) {
+        // Undetected, but a pair detects the fault where the launch vector left its site at X
+        fprintf(file, "- Potentially Detected Faults (X): %d\n", potential_faults);
+    }
+    fprintf(file, "\nTransition Coverage vs. Pairs:\n");
+    int* new_detections = (int*)calloc(num_vectors + 1, sizeof(int));
+    for (int i = 0; i < transition->num_faults; i++) {
+        int v = transition->faults[i].first_detected_vector;
+        if (transition->faults[i].detected && v >= 1 && v < num_vectors) {
+            new_detections[v] += transition->class_start[i + 1] - transition->class_start[i];
         }
-        // 3. Fault deduction: Mark faults as detected if output is controllable
-        for (int f = 0; f < circuit->num_faults; f++) {
-            Fault* fault = &circuit->faults[f];
-            // Find the gate for this fault
-            Gate* g = find_gate(circuit, fault->node_name);
-            if (!g) continue;
-            // If the node can be set to both 0 and 1 by any vector, mark both faults as detected
-            if ((g->value == ZERO && fault->stuck_at_value == 1) ||
-                (g->value == ONE && fault->stuck_at_value == 0)) {
-                fault->detected = true;
-            }
+    }
+    int cumulative = 0;
+    for (int v = 1; v < num_vectors; v++) {
+        if (new_detections[v] == 0) continue;
+        cumulative += new_detections[v];
+        fprintf(file, "- After %d pairs: %d detected (+%d), %.2f%%\n", v, cumulative, new_detections[v],
+                100.0 * cumulative / num_universe);
+    }
+    free(new_detections);
+    fprintf(file, "\nList of Detected Transition Faults:\n");
+    for (int u = 0; u < num_universe; u++) {
+        if (transition->faults[members[u].collapsed].detected) write_fault(file, transition, &members[u], true);
+    }
+    fprintf(file, "\nList of Undetected Transition Faults:\n");
+    for (int u = 0; u < num_universe; u++) {
+        if (!transition->faults[members[u].collapsed].detected) write_fault(file, transition, &members[u], true);
+    }
+    if (potential_faults > 0) {
+        fprintf(file, "\nList of Potentially Detected Transition Faults (X):\n");
+        for (int u = 0; u < num_universe; u++) {
+            const Fault* fault = &transition->faults[members[u].collapsed];
+            if (!fault->detected && fault->potential) write_fault(file, transition, &members[u], true);
         }
     }
-    printf("Improved simulation run complete.\n");
 }
 
-
-void generate_statistics(const char* filename, const Circuit* circuit, int num_vectors) {
+// Coverage is reported against the uncollapsed fault universe: every fault
+// takes the result of the simulated fault that stands for it. 'transition'
+// holds the transition faults of the same run, NULL if they were not simulated.
+void generate_statistics(const char* filename, const Circuit* circuit, const Circuit* transition, int num_vectors) {
     FILE* file = fopen(filename, "w");
     if (!file) {
         perror("Error opening statistics file");
         return;
     }
+    int num_universe = circuit->num_uncollapsed_faults;
+    const FaultClassMember* members = circuit->fault_classes;
+    int num_branch = 0;
+    for (int u = 0; u < num_universe; u++) {
+        if (members[u].gate >= 0) num_branch++;
+    }
     fprintf(file, "Fault Simulation Statistics\n");
     fprintf(file, "=============================\n\n");
     fprintf(file, "Circuit Details:\n");
@@ -217,46 +200,98 @@ void generate_statistics(const char* filename, const Circuit* circuit, int num_v
     fprintf(file, "- Primary Outputs: %d\n", circuit->num_primary_outputs);
     fprintf(file, "- Gates: %d\n\n", circuit->num_gates);
     fprintf(file, "Faults:\n");
-    fprintf(file, "- Total Collapsed Faults: %d\n\n", circuit->num_faults);
+    fprintf(file, "- Total Faults: %d (%d stem, %d branch)\n", num_universe, num_universe - num_branch, num_branch);
+    fprintf(file, "- Total Collapsed Faults: %d (%.2f%% of total)\n", circuit->num_faults,
+            num_universe > 0 ? 100.0 * circuit->num_faults / num_universe : 0.0);
+    fprintf(file, "- Classes Dropped by Dominance: %d\n\n", circuit->num_dominated_faults);
     fprintf(file, "Simulation Results:\n");
     fprintf(file, "- Test Vectors Applied: %d\n", num_vectors);
     int detected_faults = 0;
+    for (int u = 0; u < num_universe; u++) {
+        if (circuit->faults[members[u].collapsed].detected) detected_faults++;
+    }
+    int detected_collapsed = 0;
     for (int i = 0; i < circuit->num_faults; i++) {
-        if (circuit->faults[i].detected) detected_faults++;
+        if (circuit->faults[i].detected) detected_collapsed++;
     }
     double fault_coverage = 0.0;
-    if (circuit->num_faults > 0) {
-        fault_coverage = ((double)detected_faults / circuit->num_faults) * 100.0;
+    if (num_universe > 0) {
+        fault_coverage = ((double)detected_faults / num_universe) * 100.0;
     }
     fprintf(file, "- Detected Faults: %d\n", detected_faults);
-    fprintf(file, "- Undetected Faults: %d\n", circuit->num_faults - detected_faults);
-    fprintf(file, "- Fault Coverage: %.2f%%\n\n", fault_coverage);
-    fprintf(file, "List of Detected Faults:\n");
-    for (int i = 0; i < circuit->num_faults; i++) {
-        if (circuit->faults[i].detected) {
-            fprintf(file, "- Node: %s, Stuck-at-%d\n", circuit->faults[i].node_name, circuit->faults[i].stuck_at_value);
+    fprintf(file, "- Undetected Faults: %d\n", num_universe - detected_faults);
+    fprintf(file, "- Fault Coverage: %.2f%%\n", fault_coverage);
+    fprintf(file, "- Detected Collapsed Faults: %d of %d\n", detected_collapsed, circuit->num_faults);
+    int redundant_faults = 0;
+    for (int u = 0; u < num_universe; u++) {
+        const Fault* fault = &circuit->faults[members[u].collapsed];
+        if (!fault->detected && fault->redundant) redundant_faults++;
+    }
+    if (redundant_faults > 0) {
+        // Proven untestable by test generation; efficiency counts them as resolved
+        fprintf(file, "- Redundant Faults: %d\n", redundant_faults);
+        fprintf(file, "- Fault Efficiency: %.2f%%\n", 100.0 * (detected_faults + redundant_faults) / num_universe);
+    }
+    int potential_faults = 0;
+    for (int u = 0; u < num_universe; u++) {
+        const Fault* fault = &circuit->faults[members[u].collapsed];
+        if (!fault->detected && fault->potential) potential_faults++;
+    }
+    if (potential_faults > 0) {
+        // Undetected, but some output was known in the good machine and X in the faulty one
+        fprintf(file, "- Potentially Detected Faults (X): %d\n", potential_faults);
+    }
+    fprintf(file, "\n");
+    // Cumulative coverage after each vector that detected something new
+    fprintf(file, "Coverage vs. Vectors:\n");
+    int* new_detections = (int*)calloc(num_vectors + 1, sizeof(int));
+    for (int i = 0; i < circuit->num_faults + circuit->num_dominated_faults; i++) {
+        int v = circuit->faults[i].first_detected_vector;
+        if (circuit->faults[i].detected && v >= 0 && v < num_vectors) {
+            new_detections[v] += circuit->class_start[i + 1] - circuit->class_start[i];
         }
     }
+    int cumulative = 0;
+    for (int v = 0; v < num_vectors; v++) {
+        if (new_detections[v] == 0) continue;
+        cumulative += new_detections[v];
+        fprintf(file, "- After %d vectors: %d detected (+%d), %.2f%%\n", v + 1, cumulative, new_detections[v],
+                100.0 * cumulative / num_universe);
+    }
+    free(new_detections);
+    fprintf(file, "\n");
+    fprintf(file, "List of Detected Faults:\n");
+    for (int u = 0; u < num_universe; u++) {
+        if (circuit->faults[members[u].collapsed].detected) write_fault(file, circuit, &members[u], false);
+    }
     fprintf(file, "\nList of Undetected Faults:\n");
-    for (int i = 0; i < circuit->num_faults; i++) {
-        if (!circuit->faults[i].detected) {
-            fprintf(file, "- Node: %s, Stuck-at-%d\n", circuit->faults[i].node_name, circuit->faults[i].stuck_at_value);
+    for (int u = 0; u < num_universe; u++) {
+        if (!circuit->faults[members[u].collapsed].detected) write_fault(file, circuit, &members[u], false);
+    }
+    if (redundant_faults > 0) {
+        fprintf(file, "\nList of Redundant Faults:\n");
+        for (int u = 0; u < num_universe; u++) {
+            const Fault* fault = &circuit->faults[members[u].collapsed];
+            if (!fault->detected && fault->redundant) write_fault(file, circuit, &members[u], false);
         }
     }
+    if (potential_faults > 0) {
+        fprintf(file, "\nList of Potentially Detected Faults (X):\n");
+        for (int u = 0; u < num_universe; u++) {
+            const Fault* fault = &circuit->faults[members[u].collapsed];
+            if (!fault->detected && fault->potential) write_fault(file, circuit, &members[u], false);
+        }
+    }
+    if (transition) write_transition_faults(file, transition, num_vectors);
     fclose(file);
     printf("Statistics file '%s' generated successfully.\n", filename);
 }
 
 void free_circuit(Circuit* circuit) {
     if (!circuit) return;
-    for (int i = 0; i < circuit->num_gates; i++) {
-        if (circuit->gates[i].fanouts) free(circuit->gates[i].fanouts);
-    }
-    for (int i = 0; i < circuit->num_primary_inputs; i++) free(circuit->primary_inputs[i]);
-    for (int i = 0; i < circuit->num_primary_outputs; i++) free(circuit->primary_outputs[i]);
-    free(circuit->primary_inputs);
-    free(circuit->primary_outputs);
-    free(circuit->gates);
-    free(circuit->faults);
+    // A circuit loaded from a cache keeps its name table in the mapping
+    if (circuit->image.data) unmap_file(&circuit->image);
+    else symtab_free(&circuit->nets);
+    arena_free(&circuit->arena);
     free(circuit);
 }
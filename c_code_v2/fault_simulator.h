@@ -5,55 +5,350 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 // Gate types
 typedef enum {
-    INPUT, OUTPUT, AND, OR, NOT, NAND, NOR, XOR, XNOR, BUF
+    INPUT, OUTPUT, AND, OR, NOT, NAND, NOR, XOR, XNOR, BUF,
+    DFF     // flip-flop: output Q, single input D; clock pins are not modeled
 } GateType;
 
-// Logic values
+// Logic values. The evaluators use the first three; test generation adds
+// D (1 in the good machine, 0 in the faulty one) and D_BAR (0 and 1).
 typedef enum {
-    ZERO, ONE, X
+    ZERO, ONE, X, D, D_BAR
 } LogicValue;
 
-// Fault structure
+// Bump allocator for data that lives as long as the circuit
+typedef struct ArenaChunk ArenaChunk;
 typedef struct {
-    char node_name[256];
+    ArenaChunk* head;
+    size_t bytes;      // total chunk bytes reserved
+} Arena;
+
+// Symbol table: interns net names and hands out dense integer IDs
+typedef struct {
+    char* pool;        // NUL-terminated names back to back
+    size_t pool_size;
+    size_t pool_capacity;
+    uint32_t* offsets; // offsets[id] into pool
+    uint32_t* hashes;  // hashes[id]
+    int count;
+    int capacity;
+    int* slots;        // open-addressing hash slots holding IDs, -1 if empty
+    int num_slots;     // always a power of two
+} SymbolTable;
+
+// Fault structure: a stem fault on a net, or a branch fault on one input
+// pin of a gate reading a net with fanout
+typedef struct {
+    int net;            // net ID of the fault site
     int stuck_at_value; // 0 or 1
+    int gate;           // branch faults: gate whose input pin is faulty, -1 for stem faults
+    int pin;            // branch faults: input index on that gate
     bool detected;
+    int first_detected_vector; // index of the first detecting vector, -1 if none
+    bool redundant;     // proven untestable by test generation
+    bool potential;     // some vector left an output X in the faulty machine only
 } Fault;
 
-// Gate structure
-typedef struct Gate {
-    char name[256];
-    GateType type;
-    char inputs[2][256];
-    char output[256];
+// One fault of the uncollapsed universe and the collapsed fault that
+// represents its class
+typedef struct {
+    int net;
+    int stuck_at_value;
+    int gate;           // -1 for stem faults
+    int pin;
+    int collapsed;      // index into Circuit.faults
+    bool dominated;     // its class was dropped by dominance
+} FaultClassMember;
+
+// Opcodes of the evaluation program are the GateType values AND..BUF, plus
+// one catch-all for gate types the evaluator does not model (always X).
+// Flip-flops are never ops: like primary inputs they are level-0 sources.
+#define OP_UNSUPPORTED (DFF + 1)
+#define NUM_OPCODES (DFF + 2)
+
+// Levelized evaluation program: non-input gates in topological order,
+// grouped by level, with their opcode and fanin net IDs in flat arrays
+typedef struct {
+    int num_ops;
+    uint8_t* op;                      // opcode of each op
+    int* out;                         // output net ID
+    int* gate_op;                     // op index of each gate, -1 for inputs
+    int* in_start;                    // fanin CSR: op k reads nets
+    int* in;                          // in[in_start[k] .. in_start[k+1]), at least one
+    int num_levels;
+    int* level_start;                 // level L holds ops [level_start[L], level_start[L+1])
+    int* net_level;                   // level of each net's driver, 0 for PIs
+    int* fanout_start;                // fanout CSR: ops reading net n are
+    int* fanout;                      // fanout[fanout_start[n] .. fanout_start[n+1])
+    uint8_t lut[NUM_OPCODES][3][3];   // lut[op][acc][in] -> LogicValue, folded over the inputs
+    uint8_t lut_final[NUM_OPCODES][3]; // lut_final[op][acc] -> output LogicValue
+} EvalProgram;
+
+// Memory-mapped file (read into memory where mmap is unavailable)
+typedef struct {
+    const char* data;
+    size_t size;
+} MappedFile;
+
+// Test vectors, delivered to the engines in packed blocks of 64 vectors
+typedef struct {
     int num_inputs;
-    LogicValue value;
-    struct Gate* fanins[2];
-    struct Gate** fanouts;
-    int fanout_count;
-    Fault* faults[2];
-} Gate;
+    int num_vectors;
+    int num_blocks;           // ceil(num_vectors / 64)
+    MappedFile file;
+    const uint64_t* packed;   // packed file or in-memory set: words used in place, NULL for text
+    size_t* block_offsets;    // text file: byte offset of each block's first vector
+    uint64_t* words;          // selected in memory: packed words owned by the set
+    bool has_x;               // some input value is X
+    const uint64_t* packed_x; // X inputs, laid out like 'packed'; NULL if 'packed' has none
+} TestVectors;
+
+// Native kernel compiled from a circuit's program, see compiled_sim.c; the
+// one the circuit's engine does not use is NULL
+typedef struct {
+    void* handle;           // dlopen() handle of the shared object
+    void (*good)(void* values); // ppsfp: two-valued evaluation of every op over PatternWords
+    void (*step)(uint64_t* values, const uint64_t (*net_force)[2], const uint64_t (*slot_force)[2]);
+                            // sequential: every op over 64 machines, stem and branch faults forced
+    bool cached;            // found in the cache directory rather than built by this load
+} CompiledKernel;
+
+// Simulation options shared by the engines
+typedef struct {
+    bool fault_dropping;    // stop simulating a fault once it is detected
+    int num_threads;        // worker threads, 1 for a serial run
+    bool event_driven;      // re-evaluate only the fanout of changed inputs
+    bool quiet;             // no progress lines, for runs repeated many times
+    bool unknown_state;     // sequential engine: flip-flops power up at X, not 0
+    const CompiledKernel* kernel; // native kernels of the circuit, NULL to interpret
+} SimOptions;
 
-// Circuit structure
+// Circuit structure: struct-of-arrays indexed by gate ID, every array
+// allocated from the circuit's arena. Primary inputs are gates of type INPUT.
 typedef struct {
-    Gate* gates;
+    Arena arena;
     int num_gates;
-    char** primary_inputs;
+    uint8_t* gate_type;     // GateType, 0xff for cells the parser does not know
+    int* gate_output;       // output net ID
+    int* fanin_start;       // fanin CSR: input nets of gate g are
+    int* fanin;             // fanin[fanin_start[g] .. fanin_start[g+1])
+    uint32_t* gate_name;    // instance name offsets into gate_names
+    char* gate_names;       // NUL-terminated instance names, reporting only
+    size_t gate_names_size;
+    SymbolTable nets;       // net names, reporting only
+    int* net_driver;        // net ID -> driving gate, -1 if undriven
+    int* net_fanout_start;  // fanout CSR: gates reading net n (one entry per pin) are
+    int* net_fanout;        // net_fanout[net_fanout_start[n] .. net_fanout_start[n+1])
+    int* primary_inputs;    // net IDs
     int num_primary_inputs;
-    char** primary_outputs;
+    int* primary_outputs;   // net IDs
     int num_primary_outputs;
-    Fault* faults;
-    int num_faults;
+    Fault* faults;          // collapsed faults: num_faults equivalence classes,
+    int num_faults;         // followed by the classes dropped by dominance (simulated too)
+    int num_dominated_faults;
+    int* implied_by;        // dropped fault num_faults + d is detected by any test for faults[implied_by[d]]
+    FaultClassMember* fault_classes; // uncollapsed universe grouped by collapsed fault:
+    int* class_start;       // fault f stands for fault_classes[class_start[f] .. class_start[f+1])
+    int num_uncollapsed_faults;
+    EvalProgram program;
+    MappedFile image;       // circuit cache the arrays point into, if loaded from one
 } Circuit;
 
+#define GATE_UNKNOWN 0xff
+
+// Collects gates while a netlist is read; builder_finish() lays the result
+// out as a Circuit in its arena
+typedef struct {
+    Circuit* circuit;       // nets are interned straight into circuit->nets
+    int num_gates;
+    int gate_capacity;
+    uint8_t* type;
+    int* output;
+    uint32_t* name;
+    int* fanin_start;
+    int* fanin;
+    int num_fanins;
+    int fanin_capacity;
+    char* names;
+    size_t names_size;
+    size_t names_capacity;
+    int* inputs;
+    int num_inputs;
+    int input_capacity;
+    int* outputs;
+    int num_outputs;
+    int output_capacity;
+} CircuitBuilder;
+
+void arena_init(Arena* arena);
+void* arena_alloc(Arena* arena, size_t size);
+void* arena_calloc(Arena* arena, size_t count, size_t size);
+void arena_free(Arena* arena);
+
+void symtab_init(SymbolTable* table);
+int symtab_intern(SymbolTable* table, const char* name);
+int symtab_intern_n(SymbolTable* table, const char* name, size_t len);
+int symtab_lookup(const SymbolTable* table, const char* name);
+const char* symtab_name(const SymbolTable* table, int id);
+void symtab_free(SymbolTable* table);
+
+void builder_init(CircuitBuilder* b);
+int builder_add_gate(CircuitBuilder* b, int type, const char* name, size_t name_len, int output, const int* inputs, int num_inputs);
+int builder_add_input(CircuitBuilder* b, const char* name, size_t name_len);
+int builder_add_output(CircuitBuilder* b, const char* name, size_t name_len);
+Circuit* builder_finish(CircuitBuilder* b);
+void builder_abort(CircuitBuilder* b);
+
+Circuit* parse_netlist(const char* filename);
 Circuit* parse_verilog(const char* filename);
-void create_collapsed_fault_list(Circuit* circuit);
-int** read_test_vectors(const char* filename, int* num_vectors, int* num_inputs);
-void run_deductive_simulation(Circuit* circuit, int** test_vectors, int num_vectors, int num_inputs);
-void generate_statistics(const char* filename, const Circuit* circuit, int num_vectors);
+Circuit* parse_bench(const char* filename);
+// Parse, levelize and collapse a netlist into a circuit ready to simulate;
+// quiet leaves out the progress messages, not the errors
+Circuit* build_circuit(const char* netlist_filename, bool full_scan, bool dominance, bool quiet);
+const char* gate_name(const Circuit* circuit, int gate);
+// Shared helpers (fault_simulator.c): FNV-1a 64 over a byte range, continuing
+// from h (FNV1A64_INIT to start), the splitmix64 finalizer and wall-clock seconds
+#define FNV1A64_INIT 14695981039346656037ull
+uint64_t fnv1a64(uint64_t h, const void* data, size_t size);
+uint64_t splitmix64(uint64_t x);
+double wall_seconds(void);
+bool levelize_circuit(Circuit* circuit);
+bool program_has_unknowns(const Circuit* circuit);
+void evaluate_program(const EvalProgram* prog, uint8_t* values);
+void create_collapsed_fault_list(Circuit* circuit, bool dominance);
+// Transition faults of a circuit: a view of it whose fault list holds
+// slow-to-rise (stuck_at_value 0) and slow-to-fall (1) faults on the same lines
+void create_transition_fault_list(Circuit* circuit, Circuit* transition);
+bool map_file(const char* filename, MappedFile* file);
+void unmap_file(MappedFile* file);
+TestVectors* read_test_vectors(const char* filename);
+void load_vector_block(const TestVectors* tv, int block, uint64_t* words);
+void load_vector_x(const TestVectors* tv, int block, uint64_t* words);
+int write_packed_vectors(const TestVectors* tv, const char* filename);
+int write_text_vectors(const TestVectors* tv, const char* filename);
+int write_test_vectors(const TestVectors* tv, const char* filename);
+TestVectors* select_test_vectors(const TestVectors* tv, const int* vectors, int count);
+void free_test_vectors(TestVectors* tv);
+void run_deductive_simulation(Circuit* circuit, const TestVectors* tv, const SimOptions* options);
+void run_ppsfp_simulation(Circuit* circuit, const TestVectors* tv, const SimOptions* options);
+void run_ppsfp_transitions(Circuit* circuit, Circuit* transition, const TestVectors* tv, const SimOptions* options);
+// Fault dictionary capture (ppsfp.c): every collapsed fault, dominated ones
+// included, over every vector without dropping. sink() gets each vector a
+// fault fails on, with the xor of output_code[i] over the primary outputs i
+// it fails at; the calls for one fault come from one thread, in vector
+// order. Detections are recorded in the faults as by a simulation run.
+typedef void (*ResponseSink)(void* ctx, int fault, int vector, uint32_t syndrome);
+void capture_ppsfp_responses(Circuit* circuit, const TestVectors* tv, const SimOptions* options,
+                             const uint32_t* output_code, ResponseSink sink, void* ctx);
+int count_flip_flops(const Circuit* circuit);
+Circuit* full_scan_circuit(const Circuit* circuit);
+void run_sequential_simulation(Circuit* circuit, const TestVectors* tv, const SimOptions* options);
+void record_detection(Fault* fault, int vector);
+CompiledKernel* load_compiled_kernel(const Circuit* circuit, const char* cache_dir);
+bool compiled_kernel_pays_off(const Circuit* circuit, long long num_vectors);
+void free_compiled_kernel(CompiledKernel* kernel);
+void run_fault_simulation(const char* engine, Circuit* circuit, const TestVectors* tv, const SimOptions* options);
+void run_transition_simulation(Circuit* circuit, Circuit* transition, const TestVectors* tv, const SimOptions* options);
+TestVectors* compact_test_vectors(const char* engine, Circuit* circuit, const TestVectors* tv, const SimOptions* options);
+
+// Random-pattern mode: vectors generated in memory until coverage saturates
+typedef struct {
+    int max_vectors;            // hard limit on vectors applied
+    uint64_t seed;
+    const char* weights_filename; // "input probability" lines, NULL for 0.5 everywhere
+    int stop_window;            // K: blocks of 64 vectors looked back over
+    double stop_gain;           // stop when coverage grew less than this (percent) over K blocks
+} RandomPatternOptions;
+int run_random_patterns(const char* engine, Circuit* circuit, const SimOptions* options,
+                        const RandomPatternOptions* random, const char* vectors_filename);
+
+// Test generation for the faults left undetected
+typedef struct {
+    int backtrack_limit;    // per fault; a search that hits it is aborted
+    uint64_t seed;          // fill of the inputs a test leaves at X
+} AtpgOptions;
+int run_atpg(const char* engine, Circuit* circuit, const SimOptions* options, const AtpgOptions* atpg,
+             int first_vector, const char* vectors_filename);
+
+// ECO mode: results saved by one run, reused where a netlist edit cannot
+// change them
+typedef struct {
+    const char* vectors_filename; // the vector set, identified by its hash
+    bool full_scan;
+} EcoOptions;
+int save_eco_session(const char* filename, const char* engine, const Circuit* circuit, const TestVectors* tv,
+                     const SimOptions* options, const EcoOptions* eco);
+int run_eco_simulation(const char* filename, const char* engine, Circuit* circuit, const TestVectors* tv,
+                       const SimOptions* options, const EcoOptions* eco);
+
+// Fault dictionary: per-fault responses for failure diagnosis
+typedef struct {
+    bool pass_fail;         // record failing vectors only, not which outputs fail
+} DictionaryOptions;
+int build_fault_dictionary(const char* filename, Circuit* circuit, const TestVectors* tv, const SimOptions* options,
+                           const DictionaryOptions* dictionary);
+int diagnose_failures(const char* dictionary_filename, const char* log_filename, int max_candidates);
+
+// Circuit cache flags: options that change the cached circuit
+#define CACHE_FLAG_DOMINANCE 1u
+#define CACHE_FLAG_FULL_SCAN 2u
+bool hash_file(const char* filename, uint64_t* hash);
+Circuit* load_circuit_cache(const char* filename, uint64_t source_hash, uint32_t flags);
+bool save_circuit_cache(const char* filename, const Circuit* circuit, uint64_t source_hash, uint32_t flags);
+
+// Work-stealing parallel loop: runs task(ctx, thread_id, item) for every item
+typedef void (*ParallelTask)(void* ctx, int thread_id, int item);
+void parallel_for(int num_items, int num_threads, ParallelTask task, void* ctx);
+
+// Per-thread detection results, merged into the circuit after the threads join
+typedef struct {
+    uint64_t* bits;         // bit f set if fault f was detected
+    int* first_vector;      // first detecting vector, valid where the bit is set
+    uint64_t* potential;    // bit f set if fault f was potentially detected
+    int num_faults;
+} DetectionMap;
+
+void detection_map_init(DetectionMap* map, int num_faults);
+void detection_map_set(DetectionMap* map, int fault, int vector);
+void detection_map_set_potential(DetectionMap* map, int fault);
+void detection_map_merge(Circuit* circuit, const DetectionMap* maps, int count);
+void detection_map_free(DetectionMap* map);
+
+// Earliest known detecting vector per fault, shared lock-free between threads
+typedef struct DropHint DropHint;
+DropHint* drop_hint_create(const Circuit* circuit);
+bool drop_hint_dropped(const DropHint* hint, int fault, int vector);
+void drop_hint_update(DropHint* hint, int fault, int vector);
+void drop_hint_free(DropHint* hint);
+// Instrumentation (-DTVC_INSTRUMENT): phase times, hot-path counters and
+// peak memory, written as JSON next to the statistics file. Disabled builds
+// compile every INSTR* use away. The totals are process-wide, so they are
+// not reentrant across concurrent tvc sessions.
+enum { PHASE_PARSE, PHASE_LEVELIZE, PHASE_COLLAPSE, PHASE_CACHE_LOAD, PHASE_VECTOR_LOAD, PHASE_SIMULATE, PHASE_REPORT, NUM_PHASES };
+enum { COUNTER_GATE_EVALS, COUNTER_EVENTS, COUNTER_FAULT_LISTS, COUNTER_FAULT_LIST_ENTRIES, NUM_COUNTERS };
+#ifdef TVC_INSTRUMENT
+extern _Thread_local long long instrument_counters[NUM_COUNTERS];
+extern _Thread_local long long instrument_fault_list_max;
+void instrument_phase_begin(int phase);
+void instrument_phase_end(int phase);
+void instrument_flush_thread(void);
+void instrument_write_json(const char* stats_filename, const Circuit* circuit, const char* engine,
+                           const SimOptions* options, int num_vectors);
+#define INSTR(stmt) stmt
+#define INSTR_COUNT(counter, n) (instrument_counters[counter] += (n))
+#define INSTR_FAULT_LIST(len) do { long long len_ = (len); instrument_counters[COUNTER_FAULT_LISTS]++; \
+        instrument_counters[COUNTER_FAULT_LIST_ENTRIES] += len_; \
+        if (len_ > instrument_fault_list_max) instrument_fault_list_max = len_; } while (0)
+#else
+#define INSTR(stmt) ((void)0)
+#define INSTR_COUNT(counter, n) ((void)0)
+#define INSTR_FAULT_LIST(len) ((void)0)
+#endif
+
+void generate_statistics(const char* filename, const Circuit* circuit, const Circuit* transition, int num_vectors);
 void free_circuit(Circuit* circuit);
 
 #endif // FAULT_SIMULATOR_H
@@ -0,0 +1,138 @@
+#include "fault_simulator.h"
+
+// Instrumentation, compiled in only with -DTVC_INSTRUMENT. Without it the
+// INSTR* macros in fault_simulator.h expand to nothing and this file is empty.
+//
+// Phases record wall and CPU time. Hot-path counters are thread-local, so
+// counting costs one add with no sharing between threads; each thread folds
+// its counters into the process totals when its parallel_for share ends,
+// and the main thread's when the report is written. The report is a JSON
+// file next to the statistics file.
+//
+// The phase times and totals are process-wide, not per run: an instrumented
+// build reports one simulation per process. tvc sessions open in the same
+// process add their parse, levelize and collapse times and their counters to
+// the same totals, and sessions on several threads race on the phase timers.
+
+#ifdef TVC_INSTRUMENT
+
+#include <stdatomic.h>
+#include <time.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+static const char* const PHASE_NAMES[NUM_PHASES] = {
+    "parse", "levelize", "collapse", "cache_load", "vector_load", "simulate", "report"
+};
+static const char* const COUNTER_NAMES[NUM_COUNTERS] = {
+    "gate_evaluations", "events_processed", "fault_lists_computed", "fault_list_entries"
+};
+
+_Thread_local long long instrument_counters[NUM_COUNTERS];
+_Thread_local long long instrument_fault_list_max;
+
+static atomic_llong total_counters[NUM_COUNTERS];
+static atomic_llong total_fault_list_max;
+static double phase_wall[NUM_PHASES];
+static double phase_cpu[NUM_PHASES];
+static double phase_wall_start[NUM_PHASES];
+static double phase_cpu_start[NUM_PHASES];
+
+void instrument_phase_begin(int phase) {
+    phase_wall_start[phase] = wall_seconds();
+    phase_cpu_start[phase] = (double)clock() / CLOCKS_PER_SEC;
+}
+
+void instrument_phase_end(int phase) {
+    phase_wall[phase] += wall_seconds() - phase_wall_start[phase];
+    phase_cpu[phase] += (double)clock() / CLOCKS_PER_SEC - phase_cpu_start[phase];
+}
+
+void instrument_flush_thread(void) {
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        atomic_fetch_add_explicit(&total_counters[c], instrument_counters[c], memory_order_relaxed);
+        instrument_counters[c] = 0;
+    }
+    long long seen = atomic_load_explicit(&total_fault_list_max, memory_order_relaxed);
+    while (instrument_fault_list_max > seen &&
+           !atomic_compare_exchange_weak_explicit(&total_fault_list_max, &seen, instrument_fault_list_max,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+    instrument_fault_list_max = 0;
+}
+
+// Helper: Peak resident set size of the process in KiB, -1 if unknown
+static long peak_rss_kb(void) {
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss;
+#endif
+    return -1;
+}
+
+void instrument_write_json(const char* stats_filename, const Circuit* circuit, const char* engine,
+                           const SimOptions* options, int num_vectors) {
+    instrument_flush_thread();
+    // stats.txt -> stats.json
+    size_t len = strlen(stats_filename);
+    const char* dot = strrchr(stats_filename, '.');
+    const char* slash = strrchr(stats_filename, '/');
+    if (dot && (!slash || dot > slash)) len = (size_t)(dot - stats_filename);
+    char* filename = (char*)malloc(len + 6);
+    memcpy(filename, stats_filename, len);
+    memcpy(filename + len, ".json", 6);
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        perror("Error opening instrumentation file");
+        free(filename);
+        return;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"circuit\": {\"gates\": %d, \"inputs\": %d, \"outputs\": %d, \"levels\": %d, "
+                  "\"faults\": %d, \"collapsed_faults\": %d},\n",
+            circuit->num_gates, circuit->num_primary_inputs, circuit->num_primary_outputs,
+            circuit->program.num_levels, circuit->num_uncollapsed_faults, circuit->num_faults);
+    fprintf(file, "  \"run\": {\"engine\": \"%s\", \"threads\": %d, \"vectors\": %d, \"fault_dropping\": %s, "
+                  "\"event_driven\": %s},\n",
+            engine, options->num_threads, num_vectors, options->fault_dropping ? "true" : "false",
+            options->event_driven ? "true" : "false");
+    fprintf(file, "  \"phases\": {\n");
+    for (int p = 0; p < NUM_PHASES; p++) {
+        fprintf(file, "    \"%s\": {\"wall_s\": %.6f, \"cpu_s\": %.6f}%s\n", PHASE_NAMES[p], phase_wall[p], phase_cpu[p],
+                p + 1 < NUM_PHASES ? "," : "");
+    }
+    fprintf(file, "  },\n");
+    fprintf(file, "  \"counters\": {\n");
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        fprintf(file, "    \"%s\": %lld,\n", COUNTER_NAMES[c], (long long)atomic_load(&total_counters[c]));
+    }
+    long long lists = atomic_load(&total_counters[COUNTER_FAULT_LISTS]);
+    long long entries = atomic_load(&total_counters[COUNTER_FAULT_LIST_ENTRIES]);
+    fprintf(file, "    \"fault_list_avg\": %.3f,\n", lists > 0 ? (double)entries / lists : 0.0);
+    fprintf(file, "    \"fault_list_max\": %lld\n", (long long)atomic_load(&total_fault_list_max));
+    fprintf(file, "  },\n");
+    // A fault leaves the active set after the block of its first detection,
+    // so first detections per 64-vector block are the faults dropped there
+    // (classes dropped by dominance included: they are simulated alongside)
+    int num_blocks = (num_vectors + 63) / 64;
+    int* dropped = (int*)calloc(num_blocks + 1, sizeof(int));
+    for (int f = 0; f < circuit->num_faults + circuit->num_dominated_faults; f++) {
+        const Fault* fault = &circuit->faults[f];
+        if (fault->detected && fault->first_detected_vector >= 0 && fault->first_detected_vector < num_vectors) {
+            dropped[fault->first_detected_vector / 64]++;
+        }
+    }
+    fprintf(file, "  \"%s\": [", options->fault_dropping ? "faults_dropped_per_block" : "first_detections_per_block");
+    for (int b = 0; b < num_blocks; b++) fprintf(file, "%s%d", b > 0 ? ", " : "", dropped[b]);
+    fprintf(file, "],\n");
+    free(dropped);
+    fprintf(file, "  \"peak_rss_kb\": %ld\n", peak_rss_kb());
+    fprintf(file, "}\n");
+    fclose(file);
+    printf("Instrumentation file '%s' generated successfully.\n", filename);
+    free(filename);
+}
+
+#endif // TVC_INSTRUMENT
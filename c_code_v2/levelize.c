@@ -0,0 +1,197 @@
+#include "fault_simulator.h"
+
+// Levelization: orders the gates topologically, groups them by level and
+// flattens them into an EvalProgram that the simulators run as a tight loop.
+
+// Helper: Two-input evaluation rule for one gate type (reference semantics).
+// X is a true unknown: a controlling value decides the output on its own,
+// anything else that reads an X yields X.
+static LogicValue eval_gate_rule(int type, LogicValue in0, LogicValue in1) {
+    switch (type) {
+        case AND: return (in0 == ZERO || in1 == ZERO) ? ZERO : (in0 == ONE && in1 == ONE ? ONE : X);
+        case OR:  return (in0 == ONE || in1 == ONE) ? ONE : (in0 == ZERO && in1 == ZERO ? ZERO : X);
+        case NOT: return (in0 == ONE) ? ZERO : (in0 == ZERO ? ONE : X);
+        case NAND: return eval_gate_rule(NOT, eval_gate_rule(AND, in0, in1), X);
+        case NOR:  return eval_gate_rule(NOT, eval_gate_rule(OR, in0, in1), X);
+        case XOR:  return (in0 == X || in1 == X) ? X : (in0 != in1 ? ONE : ZERO);
+        case XNOR: return eval_gate_rule(NOT, eval_gate_rule(XOR, in0, in1), X);
+        case BUF:  return in0;
+        default: return X;
+    }
+}
+
+// Helper: Gates that start a level-0 net: primary inputs and flip-flops
+static inline bool is_source(int type) {
+    return type == INPUT || type == DFF;
+}
+
+bool levelize_circuit(Circuit* circuit) {
+    EvalProgram* prog = &circuit->program;
+    int num_nets = circuit->nets.count;
+    int num_gates = circuit->num_gates;
+
+    // Kahn's algorithm over gates; PIs and undriven nets sit at level 0
+    int* pending = (int*)calloc(num_gates, sizeof(int));
+    int* gate_level = (int*)calloc(num_gates, sizeof(int));
+    int* queue = (int*)malloc(num_gates * sizeof(int));
+    int head = 0, tail = 0, num_ops = 0;
+    const int* driver = circuit->net_driver;
+    for (int i = 0; i < num_gates; i++) {
+        if (is_source(circuit->gate_type[i])) continue;
+        num_ops++;
+        for (int e = circuit->fanin_start[i]; e < circuit->fanin_start[i + 1]; e++) {
+            int d = driver[circuit->fanin[e]];
+            if (d >= 0 && !is_source(circuit->gate_type[d])) pending[i]++;
+        }
+        if (pending[i] == 0) queue[tail++] = i;
+    }
+    int num_levels = 1;
+    while (head < tail) {
+        int g = queue[head++];
+        int level = 1;
+        for (int e = circuit->fanin_start[g]; e < circuit->fanin_start[g + 1]; e++) {
+            int d = driver[circuit->fanin[e]];
+            if (d >= 0 && !is_source(circuit->gate_type[d]) && gate_level[d] + 1 > level) level = gate_level[d] + 1;
+        }
+        gate_level[g] = level;
+        if (level + 1 > num_levels) num_levels = level + 1;
+        int net = circuit->gate_output[g];
+        for (int k = circuit->net_fanout_start[net]; k < circuit->net_fanout_start[net + 1]; k++) {
+            int succ = circuit->net_fanout[k];
+            if (is_source(circuit->gate_type[succ])) continue; // a flip-flop's D pin
+            // A gate can list the same fanin twice; it is released once per edge
+            if (--pending[succ] == 0) queue[tail++] = succ;
+        }
+    }
+    if (tail != num_ops) {
+        for (int i = 0; i < num_gates; i++) {
+            if (!is_source(circuit->gate_type[i]) && pending[i] > 0) {
+                fprintf(stderr, "Error: combinational loop detected through gate %s\n", gate_name(circuit, i));
+                break;
+            }
+        }
+        free(pending);
+        free(gate_level);
+        free(queue);
+        return false;
+    }
+
+    // Counting sort of the ops by level
+    prog->num_ops = num_ops;
+    prog->num_levels = num_levels;
+    Arena* arena = &circuit->arena;
+    prog->level_start = (int*)arena_calloc(arena, num_levels + 1, sizeof(int));
+    for (int i = 0; i < num_gates; i++) {
+        if (!is_source(circuit->gate_type[i])) prog->level_start[gate_level[i] + 1]++;
+    }
+    for (int l = 0; l < num_levels; l++) prog->level_start[l + 1] += prog->level_start[l];
+    prog->op = (uint8_t*)arena_alloc(arena, num_ops);
+    prog->out = (int*)arena_alloc(arena, num_ops * sizeof(int));
+    prog->in_start = (int*)arena_alloc(arena, (num_ops + 1) * sizeof(int));
+    prog->net_level = (int*)arena_calloc(arena, num_nets + 1, sizeof(int));
+    prog->gate_op = (int*)arena_alloc(arena, (num_gates + 1) * sizeof(int));
+    int* op_gate = queue; // reuse: gate behind each op
+    int* cursor = pending; // reuse: next free slot per level
+    memcpy(cursor, prog->level_start, num_levels * sizeof(int));
+    for (int i = 0; i < num_gates; i++) {
+        int type = circuit->gate_type[i];
+        prog->gate_op[i] = -1;
+        if (is_source(type)) continue;
+        int k = cursor[gate_level[i]]++;
+        op_gate[k] = i;
+        prog->gate_op[i] = k;
+        prog->op[k] = (type >= AND && type <= BUF) ? (uint8_t)type : OP_UNSUPPORTED;
+        prog->out[k] = circuit->gate_output[i];
+        prog->net_level[prog->out[k]] = gate_level[i];
+    }
+    // Fanin CSR in evaluation order; a gate without pins reads the
+    // constant-X slot just past the last net
+    prog->in_start[0] = 0;
+    for (int k = 0; k < num_ops; k++) {
+        int g = op_gate[k];
+        int num_inputs = circuit->fanin_start[g + 1] - circuit->fanin_start[g];
+        prog->in_start[k + 1] = prog->in_start[k] + (num_inputs > 0 ? num_inputs : 1);
+    }
+    prog->in = (int*)arena_alloc(arena, prog->in_start[num_ops] * sizeof(int));
+    for (int k = 0; k < num_ops; k++) {
+        int g = op_gate[k];
+        int num_inputs = circuit->fanin_start[g + 1] - circuit->fanin_start[g];
+        if (num_inputs > 0) memcpy(prog->in + prog->in_start[k], circuit->fanin + circuit->fanin_start[g], num_inputs * sizeof(int));
+        else prog->in[prog->in_start[k]] = num_nets;
+    }
+    // Fanout CSR over nets: the ops that read each net, in evaluation order,
+    // listed once even if the op reads the net on several pins
+    int* last_op = (int*)malloc((num_nets + 1) * sizeof(int));
+    for (int n = 0; n <= num_nets; n++) last_op[n] = -1;
+    prog->fanout_start = (int*)arena_calloc(arena, num_nets + 2, sizeof(int));
+    for (int k = 0; k < num_ops; k++) {
+        for (int j = prog->in_start[k]; j < prog->in_start[k + 1]; j++) {
+            if (last_op[prog->in[j]] == k) continue;
+            last_op[prog->in[j]] = k;
+            prog->fanout_start[prog->in[j] + 1]++;
+        }
+    }
+    for (int n = 0; n <= num_nets; n++) prog->fanout_start[n + 1] += prog->fanout_start[n];
+    prog->fanout = (int*)arena_alloc(arena, prog->fanout_start[num_nets + 1] * sizeof(int));
+    int* fill = (int*)malloc((num_nets + 1) * sizeof(int));
+    memcpy(fill, prog->fanout_start, (num_nets + 1) * sizeof(int));
+    for (int n = 0; n <= num_nets; n++) last_op[n] = -1;
+    for (int k = 0; k < num_ops; k++) {
+        for (int j = prog->in_start[k]; j < prog->in_start[k + 1]; j++) {
+            if (last_op[prog->in[j]] == k) continue;
+            last_op[prog->in[j]] = k;
+            prog->fanout[fill[prog->in[j]]++] = k;
+        }
+    }
+    free(fill);
+    free(last_op);
+    // N-input gates fold their inputs with the two-input rule of the base
+    // function, then the inverting types complement the result
+    for (int t = 0; t < NUM_OPCODES; t++) {
+        int base = t;
+        if (t == NAND) base = AND;
+        else if (t == NOR) base = OR;
+        else if (t == XNOR) base = XOR;
+        else if (t == NOT) base = BUF;
+        for (int a = 0; a < 3; a++) {
+            for (int b = 0; b < 3; b++) {
+                prog->lut[t][a][b] = (uint8_t)eval_gate_rule(t == OP_UNSUPPORTED ? -1 : base, (LogicValue)a, (LogicValue)b);
+            }
+            bool invert = t == NAND || t == NOR || t == XNOR || t == NOT;
+            LogicValue result = invert ? eval_gate_rule(NOT, (LogicValue)a, X) : (LogicValue)a;
+            prog->lut_final[t][a] = (uint8_t)(t == OP_UNSUPPORTED ? X : result);
+        }
+    }
+    free(pending);
+    free(gate_level);
+    free(queue);
+    return true;
+}
+
+// Whether simulation can see an X without any X in the vectors: an op
+// reads an unmodeled cell, a missing pin (the constant-X slot) or a net
+// nothing drives
+bool program_has_unknowns(const Circuit* circuit) {
+    const EvalProgram* prog = &circuit->program;
+    for (int k = 0; k < prog->num_ops; k++) {
+        if (prog->op[k] == OP_UNSUPPORTED) return true;
+        for (int j = prog->in_start[k]; j < prog->in_start[k + 1]; j++) {
+            int net = prog->in[j];
+            if (net == circuit->nets.count || circuit->net_driver[net] < 0) return true;
+        }
+    }
+    return false;
+}
+
+void evaluate_program(const EvalProgram* prog, uint8_t* values) {
+    const uint8_t* op = prog->op;
+    const int* out = prog->out;
+    const int* in_start = prog->in_start;
+    const int* in = prog->in;
+    for (int k = 0; k < prog->num_ops; k++) {
+        const uint8_t (*rule)[3] = prog->lut[op[k]];
+        uint8_t value = values[in[in_start[k]]];
+        for (int j = in_start[k] + 1; j < in_start[k + 1]; j++) value = rule[value][values[in[j]]];
+        values[out[k]] = prog->lut_final[op[k]][value];
+    }
+}
@@ -1,54 +1,404 @@
 #include "fault_simulator.h"
-#include <time.h>
 
-int main(int argc, char *argv[]) {
-    if (argc != 4) {
-        fprintf(stderr, "Usage: %s <verilog_file> <vectors_file> <output_file>\n", argv[0]);
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [options] <netlist_file> <vectors_file> <output_file>\n", program);
+    fprintf(stderr, "       %s --pack-vectors <text_vectors> <packed_vectors>\n", program);
+    fprintf(stderr, "       %s --diagnose <dictionary> <failure_log> [<candidates>]\n", program);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  -e <engine>   Simulation engine: deductive (default) or ppsfp\n");
+    fprintf(stderr, "  --no-drop     Keep simulating faults after they are detected\n");
+    fprintf(stderr, "  -j <threads>  Number of worker threads (default 1)\n");
+    fprintf(stderr, "  --event       Event-driven deductive simulation between consecutive vectors\n");
+    fprintf(stderr, "  --no-dominance Collapse faults by equivalence only\n");
+    fprintf(stderr, "  --cache <file> Load the processed circuit from a cache image, rebuilding it if stale\n");
+    fprintf(stderr, "  --full-scan   Treat flip-flops as scan cells (vectors hold inputs, then flip-flop states)\n");
+    fprintf(stderr, "  --no-reset    Sequential circuits: flip-flops power up at X instead of 0\n");
+    fprintf(stderr, "  --compiled <dir> Compile the circuit to native code for the ppsfp and sequential engines,\n");
+    fprintf(stderr, "                caching the shared objects in dir (combinational runs: only long ones)\n");
+    fprintf(stderr, "  --save-session <file> Save the circuit and fault results for later --eco runs\n");
+    fprintf(stderr, "  --eco <file>  Re-simulate only the faults an edit of the netlist since the saved session can affect\n");
+    fprintf(stderr, "  --dictionary <file> Record every fault's failing vectors and outputs in a fault dictionary\n");
+    fprintf(stderr, "  --pass-fail   Fault dictionary of failing vectors only, without the failing outputs\n");
+    fprintf(stderr, "  --transition  Also simulate slow-to-rise/fall transition faults over consecutive vector pairs\n");
+    fprintf(stderr, "                (ppsfp engine, in the same pass)\n");
+    fprintf(stderr, "  --random <n>  Simulate up to n random vectors instead of reading vectors_file;\n");
+    fprintf(stderr, "                the vectors that detected faults are written to vectors_file\n");
+    fprintf(stderr, "  --compact <file> Write the smallest subset found of vectors_file with the same coverage;\n");
+    fprintf(stderr, "                statistics then cover the compacted set (.tvb: packed format)\n");
+    fprintf(stderr, "  --atpg <file> Generate tests (PODEM) for the faults left undetected and write them to file\n");
+    fprintf(stderr, "  --backtracks <n> PODEM backtrack limit per fault (default 100)\n");
+    fprintf(stderr, "  --seed <n>    Random seed for --random and the X fill of --atpg tests (default 1)\n");
+    fprintf(stderr, "  --weights <file> Per-input probability of a 1, lines of '<input> <probability>'\n");
+    fprintf(stderr, "  --stop-window <k> Blocks of 64 vectors to measure coverage gain over (default 16)\n");
+    fprintf(stderr, "  --stop-gain <pct> Stop when coverage grew less than pct over the window (default 0.1)\n");
+}
+
+// Convert a text vector file to the packed binary format
+static int pack_vectors(const char* text_filename, const char* packed_filename) {
+    TestVectors* tv = read_test_vectors(text_filename);
+    if (!tv) {
+        fprintf(stderr, "Failed to read test vectors.\n");
         return 1;
     }
+    int status = write_packed_vectors(tv, packed_filename);
+    if (status == 0) printf("Packed %d vectors with %d inputs each into %s\n", tv->num_vectors, tv->num_inputs, packed_filename);
+    free_test_vectors(tv);
+    return status == 0 ? 0 : 1;
+}
 
-    srand(time(NULL));
-    const char* verilog_filename = argv[1];
-    const char* vectors_filename = argv[2];
-    const char* output_filename = argv[3];
+// Load or build the compiled kernel for a run over num_vectors, unless
+// building it would cost more than it saves
+static CompiledKernel* prepare_kernel(const Circuit* circuit, const char* kernel_dir, long long num_vectors) {
+    if (!compiled_kernel_pays_off(circuit, num_vectors)) {
+        printf("Not compiling the circuit: over %lld vectors its good machine would save less than the build costs.\n",
+               num_vectors);
+        return NULL;
+    }
+    CompiledKernel* kernel = load_compiled_kernel(circuit, kernel_dir);
+    if (!kernel) fprintf(stderr, "Warning: running without a compiled kernel.\n");
+    else printf("%s compiled kernel in %s (%d ops).\n", kernel->cached ? "Loaded" : "Built", kernel_dir,
+                circuit->program.num_ops);
+    return kernel;
+}
 
-    printf("Parsing Verilog file: %s\n", verilog_filename);
-    Circuit* circuit = parse_verilog(verilog_filename);
-    if (!circuit) {
-        fprintf(stderr, "Failed to parse Verilog file.\n");
-        return 1;
+int main(int argc, char *argv[]) {
+    if (argc == 4 && strcmp(argv[1], "--pack-vectors") == 0) return pack_vectors(argv[2], argv[3]);
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "--diagnose") == 0) {
+        int max_candidates = argc == 5 ? atoi(argv[4]) : 10;
+        if (max_candidates <= 0) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        return diagnose_failures(argv[2], argv[3], max_candidates) == 0 ? 0 : 1;
     }
-    printf("Parsing complete. Found %d gates, %d inputs, %d outputs.\n", circuit->num_gates, circuit->num_primary_inputs, circuit->num_primary_outputs);
 
-    printf("Creating collapsed fault list...\n");
-    create_collapsed_fault_list(circuit);
-    printf("Fault list created with %d faults.\n", circuit->num_faults);
+    const char* engine = NULL;
+    bool dominance = true;
+    bool full_scan = false;
+    const char* cache_filename = NULL;
+    const char* compact_filename = NULL;
+    const char* atpg_filename = NULL;
+    const char* kernel_dir = NULL;
+    const char* save_session_filename = NULL;
+    const char* eco_filename = NULL;
+    const char* dictionary_filename = NULL;
+    bool transitions = false;
+    DictionaryOptions dictionary;
+    dictionary.pass_fail = false;
+    SimOptions options;
+    options.fault_dropping = true;
+    options.num_threads = 1;
+    options.event_driven = false;
+    options.quiet = false;
+    options.unknown_state = false;
+    options.kernel = NULL;
+    RandomPatternOptions random;
+    random.max_vectors = 0;
+    random.seed = 1;
+    random.weights_filename = NULL;
+    random.stop_window = 16;
+    random.stop_gain = 0.1;
+    AtpgOptions atpg;
+    atpg.backtrack_limit = 100;
+    int argi = 1;
+    while (argi < argc && argv[argi][0] == '-') {
+        if (strcmp(argv[argi], "-e") == 0 && argi + 1 < argc) {
+            engine = argv[argi + 1];
+            argi += 2;
+        } else if (strcmp(argv[argi], "-j") == 0 && argi + 1 < argc && atoi(argv[argi + 1]) > 0) {
+            options.num_threads = atoi(argv[argi + 1]);
+            argi += 2;
+        } else if (strcmp(argv[argi], "--event") == 0) {
+            options.event_driven = true;
+            argi++;
+        } else if (strcmp(argv[argi], "--no-dominance") == 0) {
+            dominance = false;
+            argi++;
+        } else if (strcmp(argv[argi], "--cache") == 0 && argi + 1 < argc) {
+            cache_filename = argv[argi + 1];
+            argi += 2;
+        } else if (strcmp(argv[argi], "--full-scan") == 0) {
+            full_scan = true;
+            argi++;
+        } else if (strcmp(argv[argi], "--no-reset") == 0) {
+            options.unknown_state = true;
+            argi++;
+        } else if (strcmp(argv[argi], "--compiled") == 0 && argi + 1 < argc) {
+            kernel_dir = argv[argi + 1];
+            argi += 2;
+        } else if (strcmp(argv[argi], "--save-session") == 0 && argi + 1 < argc) {
+            save_session_filename = argv[argi + 1];
+            argi += 2;
+        } else if (strcmp(argv[argi], "--eco") == 0 && argi + 1 < argc) {
+            eco_filename = argv[argi + 1];
+            argi += 2;
+        } else if (strcmp(argv[argi], "--dictionary") == 0 && argi + 1 < argc) {
+            dictionary_filename = argv[argi + 1];
+            argi += 2;
+        } else if (strcmp(argv[argi], "--pass-fail") == 0) {
+            dictionary.pass_fail = true;
+            argi++;
+        } else if (strcmp(argv[argi], "--transition") == 0) {
+            transitions = true;
+            argi++;
+        } else if (strcmp(argv[argi], "--random") == 0 && argi + 1 < argc && atoi(argv[argi + 1]) > 0) {
+            random.max_vectors = atoi(argv[argi + 1]);
+            argi += 2;
+        } else if (strcmp(argv[argi], "--compact") == 0 && argi + 1 < argc) {
+            compact_filename = argv[argi + 1];
+            argi += 2;
+        } else if (strcmp(argv[argi], "--atpg") == 0 && argi + 1 < argc) {
+            atpg_filename = argv[argi + 1];
+            argi += 2;
+        } else if (strcmp(argv[argi], "--backtracks") == 0 && argi + 1 < argc && atoi(argv[argi + 1]) >= 0) {
+            atpg.backtrack_limit = atoi(argv[argi + 1]);
+            argi += 2;
+        } else if (strcmp(argv[argi], "--seed") == 0 && argi + 1 < argc) {
+            random.seed = strtoull(argv[argi + 1], NULL, 10);
+            argi += 2;
+        } else if (strcmp(argv[argi], "--weights") == 0 && argi + 1 < argc) {
+            random.weights_filename = argv[argi + 1];
+            argi += 2;
+        } else if (strcmp(argv[argi], "--stop-window") == 0 && argi + 1 < argc && atoi(argv[argi + 1]) > 0) {
+            random.stop_window = atoi(argv[argi + 1]);
+            argi += 2;
+        } else if (strcmp(argv[argi], "--stop-gain") == 0 && argi + 1 < argc) {
+            random.stop_gain = atof(argv[argi + 1]);
+            argi += 2;
+        } else if (strcmp(argv[argi], "--no-drop") == 0) {
+            options.fault_dropping = false;
+            argi++;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (argc - argi != 3 || (engine && strcmp(engine, "deductive") != 0 && strcmp(engine, "ppsfp") != 0)) {
+        print_usage(argv[0]);
+        return 1;
+    }
 
-    int num_vectors, num_inputs;
-    printf("Reading test vectors from: %s\n", vectors_filename);
-    int** test_vectors = read_test_vectors(vectors_filename, &num_vectors, &num_inputs);
-    if (!test_vectors) {
-        fprintf(stderr, "Failed to read test vectors.\n");
-        free_circuit(circuit);
+    if (options.event_driven && engine && strcmp(engine, "deductive") != 0) {
+        fprintf(stderr, "Error: --event is only supported by the deductive engine.\n");
+        return 1;
+    }
+    if ((random.max_vectors > 0 || compact_filename || atpg_filename) && !options.fault_dropping) {
+        fprintf(stderr, "Error: --random, --compact and --atpg need fault dropping; only first detections are kept.\n");
+        return 1;
+    }
+    if (random.max_vectors > 0 && compact_filename) {
+        fprintf(stderr, "Error: --random already writes only the detecting vectors; drop --compact.\n");
+        return 1;
+    }
+    if ((save_session_filename || eco_filename) && (random.max_vectors > 0 || compact_filename || atpg_filename)) {
+        fprintf(stderr, "Error: --save-session and --eco cover plain runs over a vector file; drop --random, --compact and --atpg.\n");
+        return 1;
+    }
+    if (dictionary_filename && (random.max_vectors > 0 || compact_filename || atpg_filename || save_session_filename || eco_filename)) {
+        fprintf(stderr, "Error: --dictionary covers plain runs over a vector file; drop --random, --compact, --atpg, --save-session and --eco.\n");
         return 1;
     }
-    printf("Read %d test vectors with %d inputs each.\n", num_vectors, num_inputs);
+    if (dictionary.pass_fail && !dictionary_filename) {
+        fprintf(stderr, "Error: --pass-fail sets the kind of fault dictionary; add --dictionary.\n");
+        return 1;
+    }
+    if (transitions && (random.max_vectors > 0 || compact_filename || atpg_filename || save_session_filename || eco_filename || dictionary_filename)) {
+        fprintf(stderr, "Error: --transition covers plain runs over a vector file; drop --random, --compact, --atpg, --save-session, --eco and --dictionary.\n");
+        return 1;
+    }
+    if (transitions && (options.event_driven || (engine && strcmp(engine, "ppsfp") != 0))) {
+        fprintf(stderr, "Error: --transition runs on the ppsfp engine.\n");
+        return 1;
+    }
+    if (transitions) engine = "ppsfp";
+    atpg.seed = random.seed;
+
+    const char* netlist_filename = argv[argi];
+    const char* vectors_filename = argv[argi + 1];
+    const char* output_filename = argv[argi + 2];
+    EcoOptions eco;
+    eco.vectors_filename = vectors_filename;
+    eco.full_scan = full_scan;
+
+    double phase_start = wall_seconds();
+    uint32_t cache_flags = (dominance ? CACHE_FLAG_DOMINANCE : 0) | (full_scan ? CACHE_FLAG_FULL_SCAN : 0);
+    uint64_t netlist_hash = 0;
+    Circuit* circuit = NULL;
+    if (cache_filename) {
+        if (!hash_file(netlist_filename, &netlist_hash)) {
+            perror("Error reading netlist file");
+            return 1;
+        }
+        INSTR(instrument_phase_begin(PHASE_CACHE_LOAD));
+        circuit = load_circuit_cache(cache_filename, netlist_hash, cache_flags);
+        INSTR(instrument_phase_end(PHASE_CACHE_LOAD));
+        if (circuit) {
+            printf("Loaded circuit cache %s: %d gates in %d levels, %d collapsed faults out of %d.\n", cache_filename,
+                   circuit->num_gates, circuit->program.num_levels, circuit->num_faults, circuit->num_uncollapsed_faults);
+        }
+    }
+    if (!circuit) {
+        circuit = build_circuit(netlist_filename, full_scan, dominance, false);
+        if (!circuit) return 1;
+        if (cache_filename && save_circuit_cache(cache_filename, circuit, netlist_hash, cache_flags)) {
+            printf("Saved circuit cache %s.\n", cache_filename);
+        }
+    }
 
-    if (num_inputs != circuit->num_primary_inputs) {
-        fprintf(stderr, "Error: Number of inputs in vector file (%d) does not match circuit primary inputs (%d).\n", num_inputs, circuit->num_primary_inputs);
+    int num_flip_flops = count_flip_flops(circuit);
+    if (num_flip_flops > 0) {
+        // Clocked simulation: only the sequential engine keeps state between vectors
+        if (engine || options.event_driven || random.max_vectors > 0 || compact_filename || atpg_filename || dictionary_filename) {
+            fprintf(stderr, "Error: %d flip-flops found; sequential circuits run on their own engine (use --full-scan for -e/--event/--random/--compact/--atpg/--dictionary/--transition).\n", num_flip_flops);
+            free_circuit(circuit);
+            return 1;
+        }
+        engine = "sequential";
+        printf("Sequential circuit: %d flip-flops, one vector per clock cycle from %s.\n", num_flip_flops,
+               options.unknown_state ? "an unknown state" : "reset");
+    }
+    if (!engine) engine = "deductive";
+    Circuit transition;
+    if (transitions) {
+        create_transition_fault_list(circuit, &transition);
+        printf("Transition fault list created with %d collapsed faults out of %d.\n", transition.num_faults,
+               transition.num_uncollapsed_faults);
+    }
+    CompiledKernel* kernel = NULL;
+    if (kernel_dir && strcmp(engine, "deductive") == 0) {
+        fprintf(stderr, "Error: --compiled needs the ppsfp or sequential engine.\n");
         free_circuit(circuit);
-        for(int i = 0; i < num_vectors; i++) free(test_vectors[i]);
-        free(test_vectors);
         return 1;
     }
 
-    run_deductive_simulation(circuit, test_vectors, num_vectors, num_inputs);
+    double setup_time = wall_seconds() - phase_start;
+
+    TestVectors* test_vectors = NULL;
+    int num_vectors;
+    double vectors_time = 0.0;
+    double simulate_time;
+    if (random.max_vectors > 0) {
+        if (kernel_dir) {
+            phase_start = wall_seconds();
+            options.kernel = kernel = prepare_kernel(circuit, kernel_dir, random.max_vectors);
+            setup_time += wall_seconds() - phase_start;
+        }
+        // Vectors are generated inside the simulation phase
+        phase_start = wall_seconds();
+        INSTR(instrument_phase_begin(PHASE_SIMULATE));
+        num_vectors = run_random_patterns(engine, circuit, &options, &random, vectors_filename);
+        INSTR(instrument_phase_end(PHASE_SIMULATE));
+        simulate_time = wall_seconds() - phase_start;
+        if (num_vectors < 0) {
+            free_circuit(circuit);
+            free_compiled_kernel(kernel);
+            return 1;
+        }
+    } else {
+        phase_start = wall_seconds();
+        printf("Reading test vectors from: %s\n", vectors_filename);
+        INSTR(instrument_phase_begin(PHASE_VECTOR_LOAD));
+        test_vectors = read_test_vectors(vectors_filename);
+        INSTR(instrument_phase_end(PHASE_VECTOR_LOAD));
+        if (!test_vectors) {
+            fprintf(stderr, "Failed to read test vectors.\n");
+            free_circuit(circuit);
+            free_compiled_kernel(kernel);
+            return 1;
+        }
+        printf("Read %d test vectors with %d inputs each.\n", test_vectors->num_vectors, test_vectors->num_inputs);
+
+        // An empty set is fine: --atpg can start from nothing
+        if (test_vectors->num_vectors > 0 && test_vectors->num_inputs != circuit->num_primary_inputs) {
+            fprintf(stderr, "Error: Number of inputs in vector file (%d) does not match circuit primary inputs (%d).\n", test_vectors->num_inputs, circuit->num_primary_inputs);
+            free_circuit(circuit);
+            free_compiled_kernel(kernel);
+            free_test_vectors(test_vectors);
+            return 1;
+        }
+        vectors_time = wall_seconds() - phase_start;
+        if (kernel_dir) {
+            phase_start = wall_seconds();
+            options.kernel = kernel = prepare_kernel(circuit, kernel_dir, test_vectors->num_vectors);
+            setup_time += wall_seconds() - phase_start;
+        }
+
+        phase_start = wall_seconds();
+        INSTR(instrument_phase_begin(PHASE_SIMULATE));
+        if (compact_filename) {
+            TestVectors* compacted = compact_test_vectors(engine, circuit, test_vectors, &options);
+            if (!compacted || write_test_vectors(compacted, compact_filename) != 0) {
+                if (compacted) fprintf(stderr, "Failed to write compacted vectors.\n");
+                free_circuit(circuit);
+                free_compiled_kernel(kernel);
+                free_test_vectors(test_vectors);
+                free_test_vectors(compacted);
+                return 1;
+            }
+            printf("Compacted %d vectors to %d (%.1f%%) with the same coverage; written to %s\n",
+                   test_vectors->num_vectors, compacted->num_vectors,
+                   test_vectors->num_vectors > 0 ? 100.0 * compacted->num_vectors / test_vectors->num_vectors : 0.0,
+                   compact_filename);
+            free_test_vectors(test_vectors);
+            test_vectors = compacted;
+        } else if (dictionary_filename) {
+            // Simulates every fault on every vector, which also gives the statistics
+            if (build_fault_dictionary(dictionary_filename, circuit, test_vectors, &options, &dictionary) < 0) {
+                free_circuit(circuit);
+                free_compiled_kernel(kernel);
+                free_test_vectors(test_vectors);
+                return 1;
+            }
+        } else if (eco_filename) {
+            if (run_eco_simulation(eco_filename, engine, circuit, test_vectors, &options, &eco) < 0) {
+                free_circuit(circuit);
+                free_compiled_kernel(kernel);
+                free_test_vectors(test_vectors);
+                return 1;
+            }
+        } else if (transitions) {
+            run_transition_simulation(circuit, &transition, test_vectors, &options);
+        } else {
+            run_fault_simulation(engine, circuit, test_vectors, &options);
+        }
+        INSTR(instrument_phase_end(PHASE_SIMULATE));
+        simulate_time = wall_seconds() - phase_start;
+        num_vectors = test_vectors->num_vectors;
+    }
+
+    if (atpg_filename) {
+        phase_start = wall_seconds();
+        INSTR(instrument_phase_begin(PHASE_SIMULATE));
+        int num_tests = run_atpg(engine, circuit, &options, &atpg, num_vectors, atpg_filename);
+        INSTR(instrument_phase_end(PHASE_SIMULATE));
+        simulate_time += wall_seconds() - phase_start;
+        if (num_tests < 0) {
+            free_circuit(circuit);
+            free_compiled_kernel(kernel);
+            free_test_vectors(test_vectors);
+            return 1;
+        }
+        // The statistics cover the vectors followed by the generated tests
+        num_vectors += num_tests;
+    }
+
+    if (save_session_filename && save_eco_session(save_session_filename, engine, circuit, test_vectors, &options, &eco) == 0) {
+        printf("Saved session %s.\n", save_session_filename);
+    }
+
+    phase_start = wall_seconds();
     printf("Generating statistics file: %s\n", output_filename);
-    generate_statistics(output_filename, circuit, num_vectors);
+    INSTR(instrument_phase_begin(PHASE_REPORT));
+    generate_statistics(output_filename, circuit, transitions ? &transition : NULL, num_vectors);
+    INSTR(instrument_phase_end(PHASE_REPORT));
+    double report_time = wall_seconds() - phase_start;
+    printf("Phase times: setup %.3f s, vectors %.3f s, simulate %.3f s, report %.3f s\n",
+           setup_time, vectors_time, simulate_time, report_time);
+    INSTR(instrument_write_json(output_filename, circuit, engine, &options, num_vectors));
 
     free_circuit(circuit);
-    for (int i = 0; i < num_vectors; i++) free(test_vectors[i]);
-    free(test_vectors);
+    free_compiled_kernel(kernel);
+    free_test_vectors(test_vectors);
     printf("\nFault simulation finished.\n");
     return 0;
 }
@@ -0,0 +1,64 @@
+#include "fault_simulator.h"
+
+// Read-only file mapping. POSIX systems mmap the file; elsewhere the file is
+// read into a heap buffer so callers see the same interface.
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool map_file(const char* filename, MappedFile* file) {
+    file->data = NULL;
+    file->size = 0;
+#ifndef _WIN32
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    file->size = (size_t)st.st_size;
+    if (file->size > 0) {
+        void* data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        madvise(data, file->size, MADV_SEQUENTIAL);
+        file->data = (const char*)data;
+    }
+    close(fd);
+    return true;
+#else
+    FILE* fp = fopen(filename, "rb");
+    if (!fp) return false;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char* data = (char*)malloc(size > 0 ? size : 1);
+    if (size > 0 && fread(data, 1, size, fp) != (size_t)size) {
+        free(data);
+        fclose(fp);
+        return false;
+    }
+    fclose(fp);
+    file->data = data;
+    file->size = (size_t)size;
+    return true;
+#endif
+}
+
+void unmap_file(MappedFile* file) {
+    if (!file->data) return;
+#ifndef _WIN32
+    munmap((void*)file->data, file->size);
+#else
+    free((void*)file->data);
+#endif
+    file->data = NULL;
+    file->size = 0;
+}
@@ -0,0 +1,654 @@
+#include "fault_simulator.h"
+
+// Netlist front end: builds a Circuit from structural Verilog or an ISCAS
+// .bench file. The file is memory-mapped and tokenized in place; statements
+// may span lines and several may share one line.
+
+// Circuit builder: growable arrays filled while a netlist is read, then
+// compacted into the circuit's arena by builder_finish()
+void builder_init(CircuitBuilder* b) {
+    memset(b, 0, sizeof(CircuitBuilder));
+    b->circuit = (Circuit*)calloc(1, sizeof(Circuit));
+    arena_init(&b->circuit->arena);
+    symtab_init(&b->circuit->nets);
+}
+
+// Helper: Grow an array so it can hold at least 'needed' elements
+static void* grow(void* array, int* capacity, int needed, size_t elem_size) {
+    if (needed <= *capacity) return array;
+    *capacity = *capacity ? *capacity * 2 : 64;
+    if (*capacity < needed) *capacity = needed;
+    return realloc(array, (size_t)*capacity * elem_size);
+}
+
+int builder_add_gate(CircuitBuilder* b, int type, const char* name, size_t name_len, int output, const int* inputs, int num_inputs) {
+    int g = b->num_gates++;
+    if (b->num_gates >= b->gate_capacity) {
+        b->gate_capacity = b->gate_capacity ? 2 * b->gate_capacity : 64;
+        b->type = (uint8_t*)realloc(b->type, b->gate_capacity * sizeof(uint8_t));
+        b->output = (int*)realloc(b->output, b->gate_capacity * sizeof(int));
+        b->name = (uint32_t*)realloc(b->name, b->gate_capacity * sizeof(uint32_t));
+        b->fanin_start = (int*)realloc(b->fanin_start, (b->gate_capacity + 1) * sizeof(int));
+    }
+    b->type[g] = (uint8_t)type;
+    b->output[g] = output;
+    b->fanin_start[g] = b->num_fanins;
+    if (num_inputs > 0) {
+        b->fanin = (int*)grow(b->fanin, &b->fanin_capacity, b->num_fanins + num_inputs, sizeof(int));
+        memcpy(b->fanin + b->num_fanins, inputs, num_inputs * sizeof(int));
+        b->num_fanins += num_inputs;
+    }
+    b->fanin_start[g + 1] = b->num_fanins;
+    size_t len = name_len + 1;
+    if (b->names_size + len > b->names_capacity) {
+        b->names_capacity = b->names_capacity ? 2 * b->names_capacity : 4096;
+        if (b->names_capacity < b->names_size + len) b->names_capacity = b->names_size + len;
+        b->names = (char*)realloc(b->names, b->names_capacity);
+    }
+    memcpy(b->names + b->names_size, name, name_len);
+    b->names[b->names_size + name_len] = '\0';
+    b->name[g] = (uint32_t)b->names_size;
+    b->names_size += len;
+    return g;
+}
+
+int builder_add_input(CircuitBuilder* b, const char* name, size_t name_len) {
+    int net = symtab_intern_n(&b->circuit->nets, name, name_len);
+    b->inputs = (int*)grow(b->inputs, &b->input_capacity, b->num_inputs + 1, sizeof(int));
+    b->inputs[b->num_inputs++] = net;
+    builder_add_gate(b, INPUT, name, name_len, net, NULL, 0);
+    return net;
+}
+
+int builder_add_output(CircuitBuilder* b, const char* name, size_t name_len) {
+    int net = symtab_intern_n(&b->circuit->nets, name, name_len);
+    b->outputs = (int*)grow(b->outputs, &b->output_capacity, b->num_outputs + 1, sizeof(int));
+    b->outputs[b->num_outputs++] = net;
+    return net;
+}
+
+// Helper: Release the growable arrays once the circuit no longer needs them
+static void builder_free_scratch(CircuitBuilder* b) {
+    free(b->type);
+    free(b->output);
+    free(b->name);
+    free(b->fanin_start);
+    free(b->fanin);
+    free(b->names);
+    free(b->inputs);
+    free(b->outputs);
+    memset(b, 0, sizeof(CircuitBuilder));
+}
+
+Circuit* builder_finish(CircuitBuilder* b) {
+    Circuit* circuit = b->circuit;
+    Arena* arena = &circuit->arena;
+    int num_gates = b->num_gates;
+    int num_nets = circuit->nets.count;
+    circuit->num_gates = num_gates;
+    circuit->gate_type = (uint8_t*)arena_alloc(arena, num_gates);
+    circuit->gate_output = (int*)arena_alloc(arena, num_gates * sizeof(int));
+    circuit->fanin_start = (int*)arena_alloc(arena, (num_gates + 1) * sizeof(int));
+    circuit->fanin = (int*)arena_alloc(arena, b->num_fanins * sizeof(int));
+    circuit->gate_name = (uint32_t*)arena_alloc(arena, num_gates * sizeof(uint32_t));
+    circuit->gate_names = (char*)arena_alloc(arena, b->names_size);
+    circuit->gate_names_size = b->names_size;
+    if (num_gates > 0) {
+        memcpy(circuit->gate_type, b->type, num_gates);
+        memcpy(circuit->gate_output, b->output, num_gates * sizeof(int));
+        memcpy(circuit->gate_name, b->name, num_gates * sizeof(uint32_t));
+        memcpy(circuit->fanin_start, b->fanin_start, (num_gates + 1) * sizeof(int));
+    } else {
+        circuit->fanin_start[0] = 0;
+    }
+    memcpy(circuit->fanin, b->fanin, b->num_fanins * sizeof(int));
+    memcpy(circuit->gate_names, b->names, b->names_size);
+    circuit->num_primary_inputs = b->num_inputs;
+    circuit->primary_inputs = (int*)arena_alloc(arena, b->num_inputs * sizeof(int));
+    memcpy(circuit->primary_inputs, b->inputs, b->num_inputs * sizeof(int));
+    circuit->num_primary_outputs = b->num_outputs;
+    circuit->primary_outputs = (int*)arena_alloc(arena, b->num_outputs * sizeof(int));
+    memcpy(circuit->primary_outputs, b->outputs, b->num_outputs * sizeof(int));
+
+    // Map every net ID to the gate that drives it
+    circuit->net_driver = (int*)arena_alloc(arena, (num_nets + 1) * sizeof(int));
+    for (int n = 0; n <= num_nets; n++) circuit->net_driver[n] = -1;
+    for (int g = 0; g < num_gates; g++) circuit->net_driver[circuit->gate_output[g]] = g;
+    // Fanout CSR, one entry per input pin
+    circuit->net_fanout_start = (int*)arena_calloc(arena, num_nets + 2, sizeof(int));
+    for (int e = 0; e < b->num_fanins; e++) circuit->net_fanout_start[circuit->fanin[e] + 1]++;
+    for (int n = 0; n <= num_nets; n++) circuit->net_fanout_start[n + 1] += circuit->net_fanout_start[n];
+    circuit->net_fanout = (int*)arena_alloc(arena, b->num_fanins * sizeof(int));
+    int* fill = (int*)malloc((num_nets + 1) * sizeof(int));
+    memcpy(fill, circuit->net_fanout_start, (num_nets + 1) * sizeof(int));
+    for (int g = 0; g < num_gates; g++) {
+        for (int e = circuit->fanin_start[g]; e < circuit->fanin_start[g + 1]; e++) {
+            circuit->net_fanout[fill[circuit->fanin[e]]++] = g;
+        }
+    }
+    free(fill);
+
+    builder_free_scratch(b);
+    return circuit;
+}
+
+void builder_abort(CircuitBuilder* b) {
+    Circuit* circuit = b->circuit;
+    builder_free_scratch(b);
+    free_circuit(circuit);
+}
+
+// ---------------------------------------------------------------------------
+// Tokenizer over the mapped file. Tokens point into the mapping (zero-copy);
+// only bit-select names such as a[3] are assembled in a scratch buffer.
+
+typedef enum {
+    TOK_EOF, TOK_IDENT, TOK_PUNCT
+} TokenKind;
+
+typedef struct {
+    TokenKind kind;
+    const char* text;
+    size_t len;
+    int line;
+} Token;
+
+typedef struct {
+    const char* p;
+    const char* end;
+    const char* filename;
+    int line;
+    bool hash_comments;     // .bench: '#' starts a comment
+    Token tok;              // current token
+    bool failed;
+    CircuitBuilder builder;
+    int* pins;              // connection scratch, grown on demand
+    int pin_capacity;
+    int* gate_line;         // source line of each gate, for driver conflicts
+    int gate_line_capacity;
+    char name_buf[512];     // scratch for bit-select names
+} Parser;
+
+// Helper: Characters that may appear in a simple identifier or a number
+static inline bool is_word_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '_' || c == '$' || c == '\'';
+}
+
+static void advance(Parser* ps) {
+    const char* p = ps->p;
+    const char* end = ps->end;
+    for (;;) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+            if (*p == '\n') ps->line++;
+            p++;
+        }
+        if (p + 1 < end && p[0] == '/' && p[1] == '/') {
+            while (p < end && *p != '\n') p++;
+        } else if (p + 1 < end && p[0] == '/' && p[1] == '*') {
+            p += 2;
+            while (p + 1 < end && !(p[0] == '*' && p[1] == '/')) {
+                if (*p == '\n') ps->line++;
+                p++;
+            }
+            p = p + 1 < end ? p + 2 : end;
+        } else if (p < end && (*p == '`' || (ps->hash_comments && *p == '#'))) {
+            // Compiler directives are skipped like comments
+            while (p < end && *p != '\n') p++;
+        } else {
+            break;
+        }
+    }
+    Token* tok = &ps->tok;
+    tok->line = ps->line;
+    tok->text = p;
+    if (p == end) {
+        tok->kind = TOK_EOF;
+        tok->len = 0;
+    } else if (*p == '\\') {
+        // Escaped identifier: everything up to the next whitespace
+        tok->text = ++p;
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+        tok->kind = TOK_IDENT;
+        tok->len = p - tok->text;
+    } else if (is_word_char(*p)) {
+        while (p < end && is_word_char(*p)) p++;
+        tok->kind = TOK_IDENT;
+        tok->len = p - tok->text;
+    } else {
+        tok->kind = TOK_PUNCT;
+        tok->len = 1;
+        p++;
+    }
+    ps->p = p;
+}
+
+// Helper: Report a syntax error at the current token (first error only)
+static void parse_error(Parser* ps, const char* message) {
+    if (ps->failed) return;
+    ps->failed = true;
+    if (ps->tok.kind == TOK_EOF) {
+        fprintf(stderr, "%s:%d: error: %s at end of file\n", ps->filename, ps->tok.line, message);
+    } else {
+        fprintf(stderr, "%s:%d: error: %s near '%.*s'\n", ps->filename, ps->tok.line, message,
+                (int)(ps->tok.len > 40 ? 40 : ps->tok.len), ps->tok.text);
+    }
+}
+
+// Helper: Remember the line of the gate just added
+static void note_gate_line(Parser* ps, int line) {
+    int g = ps->builder.num_gates - 1;
+    ps->gate_line = (int*)grow(ps->gate_line, &ps->gate_line_capacity, g + 1, sizeof(int));
+    ps->gate_line[g] = line;
+}
+
+static inline bool is_punct(const Parser* ps, char c) {
+    return ps->tok.kind == TOK_PUNCT && ps->tok.text[0] == c;
+}
+
+static inline bool is_keyword(const Parser* ps, const char* word) {
+    size_t len = strlen(word);
+    return ps->tok.kind == TOK_IDENT && ps->tok.len == len && memcmp(ps->tok.text, word, len) == 0;
+}
+
+// Helper: Consume punctuation 'c' or fail
+static bool expect(Parser* ps, char c, const char* message) {
+    if (!is_punct(ps, c)) {
+        parse_error(ps, message);
+        return false;
+    }
+    advance(ps);
+    return true;
+}
+
+// Helper: Parse the current token as a non-negative decimal integer
+static bool token_int(Parser* ps, int* value) {
+    if (ps->tok.kind != TOK_IDENT || ps->tok.len == 0 || ps->tok.len > 9) return false;
+    int v = 0;
+    for (size_t i = 0; i < ps->tok.len; i++) {
+        char c = ps->tok.text[i];
+        if (c < '0' || c > '9') return false;
+        v = v * 10 + (c - '0');
+    }
+    *value = v;
+    return true;
+}
+
+// Helper: Add a connection to the scratch pin list
+static void push_pin(Parser* ps, int* count, int net) {
+    if (*count == ps->pin_capacity) {
+        ps->pin_capacity = ps->pin_capacity ? 2 * ps->pin_capacity : 16;
+        ps->pins = (int*)realloc(ps->pins, ps->pin_capacity * sizeof(int));
+    }
+    ps->pins[(*count)++] = net;
+}
+
+// Helper: Case-insensitive match of a length-delimited word against a lowercase one
+static bool word_equals(const char* text, size_t len, const char* lower) {
+    for (size_t i = 0; i < len; i++) {
+        char c = (text[i] >= 'A' && text[i] <= 'Z') ? (char)(text[i] - 'A' + 'a') : text[i];
+        if (c != lower[i]) return false;
+    }
+    return lower[len] == '\0';
+}
+
+// Helper: Gate type from a cell name, case-insensitive; -1 if the evaluator
+// does not model the cell
+static int cell_type(const char* name, size_t len) {
+    static const struct { const char* name; int type; } cells[] = {
+        { "and", AND }, { "or", OR }, { "not", NOT }, { "nand", NAND }, { "nor", NOR },
+        { "xor", XOR }, { "xnor", XNOR }, { "buf", BUF }, { "buff", BUF }, { "dff", DFF }
+    };
+    for (size_t c = 0; c < sizeof(cells) / sizeof(cells[0]); c++) {
+        if (word_equals(name, len, cells[c].name)) return cells[c].type;
+    }
+    return -1;
+}
+
+// ---------------------------------------------------------------------------
+// Structural Verilog: module header (plain or ANSI port lists),
+// input/output/wire declarations with optional ranges, primitive and cell
+// instances with positional connections, and simple continuous assignments.
+
+// Helper: Optional [msb:lsb] range; returns false if absent
+static bool parse_range(Parser* ps, int* msb, int* lsb) {
+    if (!is_punct(ps, '[')) return false;
+    advance(ps);
+    if (!token_int(ps, msb)) {
+        parse_error(ps, "expected constant range bound");
+        return false;
+    }
+    advance(ps);
+    if (!expect(ps, ':', "expected ':' in range")) return false;
+    if (!token_int(ps, lsb)) {
+        parse_error(ps, "expected constant range bound");
+        return false;
+    }
+    advance(ps);
+    return expect(ps, ']', "expected ']' after range");
+}
+
+// Helper: Declaration keyword at the current token: 'i'nput, 'o'utput,
+// 'w'ire (also reg), 'x' for unsupported inout, 0 if none
+static char declaration_kind(const Parser* ps) {
+    if (is_keyword(ps, "input")) return 'i';
+    if (is_keyword(ps, "output")) return 'o';
+    if (is_keyword(ps, "wire") || is_keyword(ps, "reg")) return 'w';
+    if (is_keyword(ps, "inout")) return 'x';
+    return 0;
+}
+
+// Helper: Declare one port bit of the given direction
+static void declare(Parser* ps, char direction, const char* name, size_t len) {
+    if (direction == 'i') {
+        builder_add_input(&ps->builder, name, len);
+        note_gate_line(ps, ps->tok.line);
+    } else if (direction == 'o') builder_add_output(&ps->builder, name, len);
+}
+
+// Helper: Names of one declaration. Ends before ';', ')' or the next
+// direction keyword, so it also serves ANSI port lists without separators.
+static void parse_declaration(Parser* ps) {
+    char direction = declaration_kind(ps);
+    if (direction == 'x') {
+        parse_error(ps, "inout ports are not supported");
+        return;
+    }
+    advance(ps);
+    if (direction != 'w' && declaration_kind(ps) == 'w') advance(ps);
+    int msb = 0, lsb = 0;
+    bool ranged = parse_range(ps, &msb, &lsb);
+    while (!ps->failed && ps->tok.kind == TOK_IDENT && !declaration_kind(ps)) {
+        if (!ranged) {
+            declare(ps, direction, ps->tok.text, ps->tok.len);
+        } else {
+            int step = msb >= lsb ? -1 : 1;
+            for (int bit = msb;; bit += step) {
+                int len = snprintf(ps->name_buf, sizeof(ps->name_buf), "%.*s[%d]", (int)ps->tok.len, ps->tok.text, bit);
+                declare(ps, direction, ps->name_buf, (size_t)len);
+                if (bit == lsb) break;
+            }
+        }
+        advance(ps);
+        if (is_punct(ps, ',')) advance(ps);
+    }
+}
+
+// Helper: Module header; plain port names are declared by the body later
+static void parse_module_header(Parser* ps) {
+    advance(ps);
+    if (ps->tok.kind != TOK_IDENT) {
+        parse_error(ps, "expected module name");
+        return;
+    }
+    advance(ps);
+    if (is_punct(ps, '(')) {
+        advance(ps);
+        while (!ps->failed && !is_punct(ps, ')')) {
+            if (declaration_kind(ps)) parse_declaration(ps);
+            else if (ps->tok.kind == TOK_IDENT || is_punct(ps, ',')) advance(ps);
+            else parse_error(ps, "unexpected token in port list");
+        }
+        advance(ps);
+    }
+    expect(ps, ';', "expected ';' after module header");
+}
+
+// Helper: One net reference, optionally with a constant bit-select; -1 on error
+static int parse_net(Parser* ps) {
+    if (ps->tok.kind != TOK_IDENT) {
+        parse_error(ps, is_punct(ps, '.') ? "named port connections are not supported" : "expected net name");
+        return -1;
+    }
+    const char* name = ps->tok.text;
+    size_t len = ps->tok.len;
+    advance(ps);
+    if (!is_punct(ps, '[')) return symtab_intern_n(&ps->builder.circuit->nets, name, len);
+    advance(ps);
+    int bit;
+    if (!token_int(ps, &bit)) {
+        parse_error(ps, "expected constant bit-select");
+        return -1;
+    }
+    advance(ps);
+    if (!expect(ps, ']', "expected ']' after bit-select")) return -1;
+    int n = snprintf(ps->name_buf, sizeof(ps->name_buf), "%.*s[%d]", (int)len, name, bit);
+    return symtab_intern_n(&ps->builder.circuit->nets, ps->name_buf, (size_t)n);
+}
+
+// Helper: Skip a balanced parenthesized group, e.g. a #(...) parameter list
+static void skip_group(Parser* ps) {
+    int depth = 0;
+    do {
+        if (ps->tok.kind == TOK_EOF) {
+            parse_error(ps, "unbalanced parentheses");
+            return;
+        }
+        if (is_punct(ps, '(')) depth++;
+        else if (is_punct(ps, ')')) depth--;
+        advance(ps);
+    } while (depth > 0);
+}
+
+// Helper: Cell instances: type [#(...)] [name] (out, in, ...) {, [name] (...)} ;
+static void parse_instances(Parser* ps) {
+    int type = cell_type(ps->tok.text, ps->tok.len);
+    advance(ps);
+    if (is_punct(ps, '#')) {
+        advance(ps);
+        skip_group(ps);
+    }
+    while (!ps->failed) {
+        const char* name = NULL;
+        size_t name_len = 0;
+        if (ps->tok.kind == TOK_IDENT) {
+            name = ps->tok.text;
+            name_len = ps->tok.len;
+            advance(ps);
+        }
+        if (!expect(ps, '(', "expected '(' before connections")) return;
+        int num_pins = 0;
+        while (!ps->failed && !is_punct(ps, ')')) {
+            int net = parse_net(ps);
+            if (net < 0) return;
+            push_pin(ps, &num_pins, net);
+            if (is_punct(ps, ',')) advance(ps);
+            else if (!is_punct(ps, ')')) parse_error(ps, "expected ',' or ')' in connections");
+        }
+        advance(ps);
+        if (num_pins == 0) {
+            parse_error(ps, "instance without connections");
+            return;
+        }
+        // Unnamed primitive instances are known by their output net
+        if (!name) {
+            name = symtab_name(&ps->builder.circuit->nets, ps->pins[0]);
+            name_len = strlen(name);
+        }
+        // Flip-flops keep Q and D; clock and reset pins are not modeled
+        if (type == DFF && num_pins > 2) num_pins = 2;
+        builder_add_gate(&ps->builder, type < 0 ? GATE_UNKNOWN : type, name, name_len, ps->pins[0], ps->pins + 1, num_pins - 1);
+        note_gate_line(ps, ps->tok.line);
+        if (!is_punct(ps, ',')) break;
+        advance(ps);
+    }
+    expect(ps, ';', "expected ';' after instance");
+}
+
+// Helper: assign lhs = rhs | ~rhs {, ...} ; becomes BUF / NOT gates
+static void parse_assign(Parser* ps) {
+    advance(ps);
+    while (!ps->failed) {
+        const char* name = ps->tok.text;
+        size_t name_len = ps->tok.len;
+        int lhs = parse_net(ps);
+        if (lhs < 0) return;
+        if (!expect(ps, '=', "expected '=' in assignment")) return;
+        int type = BUF;
+        if (is_punct(ps, '~')) {
+            type = NOT;
+            advance(ps);
+        }
+        int rhs = parse_net(ps);
+        if (rhs < 0) return;
+        if (!is_punct(ps, ';') && !is_punct(ps, ',')) {
+            parse_error(ps, "only 'a = b' and 'a = ~b' assignments are supported");
+            return;
+        }
+        builder_add_gate(&ps->builder, type, name, name_len, lhs, &rhs, 1);
+        note_gate_line(ps, ps->tok.line);
+        if (!is_punct(ps, ',')) break;
+        advance(ps);
+    }
+    expect(ps, ';', "expected ';' after assignment");
+}
+
+static void parse_verilog_body(Parser* ps) {
+    while (!ps->failed && ps->tok.kind != TOK_EOF) {
+        if (is_keyword(ps, "module")) {
+            parse_module_header(ps);
+        } else if (declaration_kind(ps)) {
+            parse_declaration(ps);
+            if (!ps->failed) expect(ps, ';', "expected ';' after declaration");
+        } else if (is_keyword(ps, "assign")) {
+            parse_assign(ps);
+        } else if (is_keyword(ps, "endmodule")) {
+            advance(ps);
+        } else if (ps->tok.kind == TOK_IDENT) {
+            parse_instances(ps);
+        } else {
+            parse_error(ps, "unexpected token");
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ISCAS-85/89 .bench: INPUT(a), OUTPUT(z) and z = TYPE(a, b, ...) lines
+
+static void parse_bench_body(Parser* ps) {
+    SymbolTable* nets = &ps->builder.circuit->nets;
+    while (!ps->failed && ps->tok.kind != TOK_EOF) {
+        if (ps->tok.kind != TOK_IDENT) {
+            parse_error(ps, "expected INPUT, OUTPUT or an assignment");
+            return;
+        }
+        const char* word = ps->tok.text;
+        size_t word_len = ps->tok.len;
+        int line = ps->tok.line;
+        advance(ps);
+        if (is_punct(ps, '(')) {
+            // INPUT(name) / OUTPUT(name)
+            bool input = word_equals(word, word_len, "input");
+            bool output = word_equals(word, word_len, "output");
+            if (!input && !output) {
+                parse_error(ps, "expected INPUT or OUTPUT");
+                return;
+            }
+            advance(ps);
+            if (ps->tok.kind != TOK_IDENT) {
+                parse_error(ps, "expected net name");
+                return;
+            }
+            if (input) {
+                builder_add_input(&ps->builder, ps->tok.text, ps->tok.len);
+                note_gate_line(ps, ps->tok.line);
+            } else {
+                builder_add_output(&ps->builder, ps->tok.text, ps->tok.len);
+            }
+            advance(ps);
+            expect(ps, ')', "expected ')'");
+            continue;
+        }
+        if (!expect(ps, '=', "expected '=' after gate output")) return;
+        if (ps->tok.kind != TOK_IDENT) {
+            parse_error(ps, "expected gate type");
+            return;
+        }
+        int type = cell_type(ps->tok.text, ps->tok.len);
+        advance(ps);
+        if (!expect(ps, '(', "expected '(' after gate type")) return;
+        int num_pins = 0;
+        while (!ps->failed && !is_punct(ps, ')')) {
+            if (ps->tok.kind != TOK_IDENT) {
+                parse_error(ps, "expected net name");
+                return;
+            }
+            push_pin(ps, &num_pins, symtab_intern_n(nets, ps->tok.text, ps->tok.len));
+            advance(ps);
+            if (is_punct(ps, ',')) advance(ps);
+            else if (!is_punct(ps, ')')) parse_error(ps, "expected ',' or ')'");
+        }
+        advance(ps);
+        int output = symtab_intern_n(nets, word, word_len);
+        builder_add_gate(&ps->builder, type < 0 ? GATE_UNKNOWN : type, word, word_len, output, ps->pins, num_pins);
+        note_gate_line(ps, line);
+    }
+}
+
+// Helper: Map the file, run one of the front ends and build the circuit
+// Helper: Check that no net has two drivers; the simulator keeps one driver
+// per net, so a second one would silently replace the first
+static bool check_single_drivers(const Parser* ps) {
+    const CircuitBuilder* b = &ps->builder;
+    int num_nets = b->circuit->nets.count;
+    int* driver = (int*)malloc((num_nets + 1) * sizeof(int));
+    for (int n = 0; n <= num_nets; n++) driver[n] = -1;
+    bool ok = true;
+    for (int g = 0; g < b->num_gates && ok; g++) {
+        int net = b->output[g];
+        int first = driver[net];
+        if (first >= 0) {
+            fprintf(stderr, "%s:%d: error: net '%s' is driven by both %s '%s' (line %d) and %s '%s'\n",
+                    ps->filename, ps->gate_line[g], symtab_name(&b->circuit->nets, net),
+                    b->type[first] == INPUT ? "input" : "gate", b->names + b->name[first], ps->gate_line[first],
+                    b->type[g] == INPUT ? "input" : "gate", b->names + b->name[g]);
+            ok = false;
+        }
+        driver[net] = g;
+    }
+    free(driver);
+    return ok;
+}
+
+static Circuit* parse_file(const char* filename, bool bench) {
+    MappedFile file;
+    if (!map_file(filename, &file)) {
+        perror("Error opening netlist file");
+        return NULL;
+    }
+    Parser ps;
+    memset(&ps, 0, sizeof(Parser));
+    ps.p = file.data;
+    ps.end = file.data + file.size;
+    ps.filename = filename;
+    ps.line = 1;
+    ps.hash_comments = bench;
+    builder_init(&ps.builder);
+    advance(&ps);
+    if (bench) parse_bench_body(&ps);
+    else parse_verilog_body(&ps);
+    free(ps.pins);
+    bool ok = !ps.failed && check_single_drivers(&ps);
+    free(ps.gate_line);
+    unmap_file(&file);
+    if (!ok) {
+        builder_abort(&ps.builder);
+        return NULL;
+    }
+    return builder_finish(&ps.builder);
+}
+
+Circuit* parse_verilog(const char* filename) {
+    return parse_file(filename, false);
+}
+
+Circuit* parse_bench(const char* filename) {
+    return parse_file(filename, true);
+}
+
+// Netlist reader chosen by file extension: .bench, anything else is Verilog
+Circuit* parse_netlist(const char* filename) {
+    size_t len = strlen(filename);
+    if (len >= 6 && word_equals(filename + len - 6, 6, ".bench")) return parse_bench(filename);
+    return parse_verilog(filename);
+}
@@ -0,0 +1,151 @@
+#include "fault_simulator.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <limits.h>
+
+// Work-stealing parallel loop and the per-thread detection bookkeeping the
+// multithreaded engines use to stay bit-identical to a serial run.
+
+// Item range owned by one thread, padded to its own cache line.
+// Owners and thieves both claim items with fetch_add on 'next', so every
+// item is handed out exactly once without locks.
+typedef struct {
+    atomic_int next;
+    int end;
+    char pad[64 - sizeof(atomic_int) - sizeof(int)];
+} WorkRange;
+
+typedef struct {
+    WorkRange* ranges;
+    int num_threads;
+    ParallelTask task;
+    void* ctx;
+} WorkPool;
+
+typedef struct {
+    WorkPool* pool;
+    int thread_id;
+} WorkerArg;
+
+// Helper: Claim one item from a range, -1 if it is exhausted
+static int claim_item(WorkRange* range) {
+    if (atomic_load_explicit(&range->next, memory_order_relaxed) >= range->end) return -1;
+    int item = atomic_fetch_add_explicit(&range->next, 1, memory_order_relaxed);
+    return item < range->end ? item : -1;
+}
+
+static void* worker_main(void* arg) {
+    WorkerArg* w = (WorkerArg*)arg;
+    WorkPool* pool = w->pool;
+    int t = w->thread_id;
+    int item;
+    // Drain the own range first, then steal from the others round-robin
+    while ((item = claim_item(&pool->ranges[t])) >= 0) pool->task(pool->ctx, t, item);
+    for (int k = 1; k < pool->num_threads; k++) {
+        WorkRange* victim = &pool->ranges[(t + k) % pool->num_threads];
+        while ((item = claim_item(victim)) >= 0) pool->task(pool->ctx, t, item);
+    }
+    INSTR(instrument_flush_thread());
+    return NULL;
+}
+
+void parallel_for(int num_items, int num_threads, ParallelTask task, void* ctx) {
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > num_items) num_threads = num_items > 0 ? num_items : 1;
+    WorkPool pool;
+    pool.ranges = (WorkRange*)calloc(num_threads, sizeof(WorkRange));
+    pool.num_threads = num_threads;
+    pool.task = task;
+    pool.ctx = ctx;
+    for (int t = 0; t < num_threads; t++) {
+        atomic_init(&pool.ranges[t].next, (int)((long long)num_items * t / num_threads));
+        pool.ranges[t].end = (int)((long long)num_items * (t + 1) / num_threads);
+    }
+    pthread_t* threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+    WorkerArg* args = (WorkerArg*)malloc(num_threads * sizeof(WorkerArg));
+    for (int t = 0; t < num_threads; t++) {
+        args[t].pool = &pool;
+        args[t].thread_id = t;
+    }
+    // The calling thread works as thread 0
+    for (int t = 1; t < num_threads; t++) pthread_create(&threads[t], NULL, worker_main, &args[t]);
+    worker_main(&args[0]);
+    for (int t = 1; t < num_threads; t++) pthread_join(threads[t], NULL);
+    free(args);
+    free(threads);
+    free(pool.ranges);
+}
+
+void detection_map_init(DetectionMap* map, int num_faults) {
+    map->num_faults = num_faults;
+    map->bits = (uint64_t*)calloc((num_faults + 63) / 64, sizeof(uint64_t));
+    map->first_vector = (int*)malloc((num_faults + 1) * sizeof(int));
+    map->potential = (uint64_t*)calloc((num_faults + 63) / 64, sizeof(uint64_t));
+}
+
+void detection_map_set(DetectionMap* map, int fault, int vector) {
+    uint64_t bit = (uint64_t)1 << (fault & 63);
+    if (!(map->bits[fault >> 6] & bit) || vector < map->first_vector[fault]) map->first_vector[fault] = vector;
+    map->bits[fault >> 6] |= bit;
+}
+
+void detection_map_set_potential(DetectionMap* map, int fault) {
+    map->potential[fault >> 6] |= (uint64_t)1 << (fault & 63);
+}
+
+void detection_map_merge(Circuit* circuit, const DetectionMap* maps, int count) {
+    int num_words = (circuit->num_faults + 63) / 64;
+    for (int t = 0; t < count; t++) {
+        for (int w = 0; w < num_words; w++) {
+            uint64_t bits = maps[t].bits[w];
+            while (bits) {
+                int f = w * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                record_detection(&circuit->faults[f], maps[t].first_vector[f]);
+            }
+            for (bits = maps[t].potential[w]; bits; bits &= bits - 1) {
+                circuit->faults[w * 64 + __builtin_ctzll(bits)].potential = true;
+            }
+        }
+    }
+}
+
+void detection_map_free(DetectionMap* map) {
+    free(map->bits);
+    free(map->first_vector);
+    free(map->potential);
+}
+
+// Shared drop hint: earliest vector known (so far) to detect each fault.
+// A thread may skip a fault on vectors after that point without changing
+// the final first-detection result, whatever order the work runs in.
+struct DropHint {
+    atomic_int* first_vector;
+};
+
+DropHint* drop_hint_create(const Circuit* circuit) {
+    DropHint* hint = (DropHint*)malloc(sizeof(DropHint));
+    hint->first_vector = (atomic_int*)malloc((circuit->num_faults + 1) * sizeof(atomic_int));
+    for (int f = 0; f < circuit->num_faults; f++) {
+        const Fault* fault = &circuit->faults[f];
+        atomic_init(&hint->first_vector[f], fault->detected ? INT_MIN : INT_MAX);
+    }
+    return hint;
+}
+
+bool drop_hint_dropped(const DropHint* hint, int fault, int vector) {
+    return atomic_load_explicit(&hint->first_vector[fault], memory_order_relaxed) < vector;
+}
+
+void drop_hint_update(DropHint* hint, int fault, int vector) {
+    int seen = atomic_load_explicit(&hint->first_vector[fault], memory_order_relaxed);
+    while (vector < seen &&
+           !atomic_compare_exchange_weak_explicit(&hint->first_vector[fault], &seen, vector,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void drop_hint_free(DropHint* hint) {
+    free(hint->first_vector);
+    free(hint);
+}
@@ -0,0 +1,740 @@
+#include "fault_simulator.h"
+
+// Parallel-pattern single-fault-propagation (PPSFP) simulation.
+// Every net holds one PatternWord: bit i is the net value under pattern i of
+// the current block. The good machine is simulated once per block, then each
+// live fault is injected and propagated through its fanout cone only.
+//
+// Runs that can see an X (X inputs in the vectors, unmodeled cells, undriven
+// nets) switch to a dual-rail encoding: two planes per net, 'ones' with a
+// bit set where the net is 1 and 'zeros' where it is 0, neither for X. Gates
+// stay word-parallel (AND: ones = a1 & b1, zeros = a0 | b0; NOT swaps the
+// planes), at about twice the cost. A fault counts as detected only where
+// an output is 0 in one machine and 1 in the other; an output that is known
+// in the good machine and X in the faulty one is a potential detection,
+// reported separately.
+//
+// Transition faults ride along in the same run: lane i of a block also gets
+// the good machine under vector i - 1 (the block's inputs shifted by one
+// lane), and a transition fault is the stuck-at fault of its site narrowed
+// to the lanes where that previous vector set the site to the stuck value.
+//
+// The word width follows the target ISA: build with -mavx512f for 512
+// patterns per word, -mavx2 for 256, otherwise a plain uint64_t (64).
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+typedef __m512i PatternWord;
+#define PW_LANES 8
+static inline PatternWord pw_and(PatternWord a, PatternWord b) { return _mm512_and_si512(a, b); }
+static inline PatternWord pw_or(PatternWord a, PatternWord b) { return _mm512_or_si512(a, b); }
+static inline PatternWord pw_xor(PatternWord a, PatternWord b) { return _mm512_xor_si512(a, b); }
+static inline PatternWord pw_zero(void) { return _mm512_setzero_si512(); }
+static inline PatternWord pw_ones(void) { return _mm512_set1_epi64(-1); }
+static inline bool pw_any(PatternWord a) { return _mm512_test_epi64_mask(a, a) != 0; }
+static inline PatternWord pw_load(const uint64_t* w) { return _mm512_loadu_si512((const void*)w); }
+static inline void pw_store(uint64_t* w, PatternWord a) { _mm512_storeu_si512((void*)w, a); }
+#elif defined(__AVX2__)
+#include <immintrin.h>
+typedef __m256i PatternWord;
+#define PW_LANES 4
+static inline PatternWord pw_and(PatternWord a, PatternWord b) { return _mm256_and_si256(a, b); }
+static inline PatternWord pw_or(PatternWord a, PatternWord b) { return _mm256_or_si256(a, b); }
+static inline PatternWord pw_xor(PatternWord a, PatternWord b) { return _mm256_xor_si256(a, b); }
+static inline PatternWord pw_zero(void) { return _mm256_setzero_si256(); }
+static inline PatternWord pw_ones(void) { return _mm256_set1_epi64x(-1); }
+static inline bool pw_any(PatternWord a) { return !_mm256_testz_si256(a, a); }
+static inline PatternWord pw_load(const uint64_t* w) { return _mm256_loadu_si256((const __m256i*)w); }
+static inline void pw_store(uint64_t* w, PatternWord a) { _mm256_storeu_si256((__m256i*)w, a); }
+#else
+typedef uint64_t PatternWord;
+#define PW_LANES 1
+static inline PatternWord pw_and(PatternWord a, PatternWord b) { return a & b; }
+static inline PatternWord pw_or(PatternWord a, PatternWord b) { return a | b; }
+static inline PatternWord pw_xor(PatternWord a, PatternWord b) { return a ^ b; }
+static inline PatternWord pw_zero(void) { return 0; }
+static inline PatternWord pw_ones(void) { return ~(uint64_t)0; }
+static inline bool pw_any(PatternWord a) { return a != 0; }
+static inline PatternWord pw_load(const uint64_t* w) { return *w; }
+static inline void pw_store(uint64_t* w, PatternWord a) { *w = a; }
+#endif
+
+#define PATTERNS_PER_WORD (64 * PW_LANES)
+
+// Helper: Memory aligned for PatternWords (AVX loads/stores need 32/64-byte
+// alignment); also used for arrays of structs that embed one
+static void* pw_alloc(size_t size) {
+#if PW_LANES > 1
+    return _mm_malloc(size, sizeof(PatternWord));
+#else
+    return malloc(size);
+#endif
+}
+
+static void pw_free(void* ptr) {
+#if PW_LANES > 1
+    _mm_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+// Helper: Word-parallel evaluation of op k, reducing over all of its inputs.
+// Input 'pin' reads 'forced' instead of its net (branch faults); -1 for none.
+static inline PatternWord eval_op_pin(const EvalProgram* prog, int k, const PatternWord* values, int pin, PatternWord forced) {
+    const int* in = prog->in + prog->in_start[k];
+    int num_ins = prog->in_start[k + 1] - prog->in_start[k];
+#define PIN_VALUE(j) ((j) == pin ? forced : values[in[j]])
+    PatternWord v = PIN_VALUE(0);
+    switch (prog->op[k]) {
+        case AND:  for (int j = 1; j < num_ins; j++) v = pw_and(v, PIN_VALUE(j)); return v;
+        case OR:   for (int j = 1; j < num_ins; j++) v = pw_or(v, PIN_VALUE(j)); return v;
+        case XOR:  for (int j = 1; j < num_ins; j++) v = pw_xor(v, PIN_VALUE(j)); return v;
+        case NAND: for (int j = 1; j < num_ins; j++) v = pw_and(v, PIN_VALUE(j)); return pw_xor(v, pw_ones());
+        case NOR:  for (int j = 1; j < num_ins; j++) v = pw_or(v, PIN_VALUE(j)); return pw_xor(v, pw_ones());
+        case XNOR: for (int j = 1; j < num_ins; j++) v = pw_xor(v, PIN_VALUE(j)); return pw_xor(v, pw_ones());
+        case NOT:  return pw_xor(v, pw_ones());
+        case BUF:  return v;
+        default:   return pw_zero(); // unsupported cells read as constant 0
+    }
+#undef PIN_VALUE
+}
+
+static inline PatternWord eval_op(const EvalProgram* prog, int k, const PatternWord* values) {
+    return eval_op_pin(prog, k, values, -1, pw_zero());
+}
+
+// Helper: Dual-rail evaluation of op k into (*out1, *out0); input 'pin'
+// reads (forced1, forced0) instead of its net, -1 for none
+static inline void eval_op_pin3(const EvalProgram* prog, int k, const PatternWord* ones, const PatternWord* zeros,
+                                int pin, PatternWord forced1, PatternWord forced0, PatternWord* out1, PatternWord* out0) {
+    const int* in = prog->in + prog->in_start[k];
+    int num_ins = prog->in_start[k + 1] - prog->in_start[k];
+#define PIN_ONES(j) ((j) == pin ? forced1 : ones[in[j]])
+#define PIN_ZEROS(j) ((j) == pin ? forced0 : zeros[in[j]])
+    PatternWord v1 = PIN_ONES(0), v0 = PIN_ZEROS(0);
+    switch (prog->op[k]) {
+        case AND: case NAND:
+            for (int j = 1; j < num_ins; j++) { v1 = pw_and(v1, PIN_ONES(j)); v0 = pw_or(v0, PIN_ZEROS(j)); }
+            break;
+        case OR: case NOR:
+            for (int j = 1; j < num_ins; j++) { v1 = pw_or(v1, PIN_ONES(j)); v0 = pw_and(v0, PIN_ZEROS(j)); }
+            break;
+        case XOR: case XNOR:
+            for (int j = 1; j < num_ins; j++) {
+                PatternWord a1 = PIN_ONES(j), a0 = PIN_ZEROS(j);
+                PatternWord t1 = pw_or(pw_and(v1, a0), pw_and(v0, a1));
+                v0 = pw_or(pw_and(v1, a1), pw_and(v0, a0));
+                v1 = t1;
+            }
+            break;
+        case BUF: case NOT:
+            break;
+        default:
+            // Unsupported cells are X
+            *out1 = pw_zero();
+            *out0 = pw_zero();
+            return;
+    }
+#undef PIN_ONES
+#undef PIN_ZEROS
+    bool invert = prog->op[k] == NAND || prog->op[k] == NOR || prog->op[k] == XNOR || prog->op[k] == NOT;
+    *out1 = invert ? v0 : v1;
+    *out0 = invert ? v1 : v0;
+}
+
+// Helper: Index of the lowest set lane of a non-zero word
+static inline int pw_first_lane(PatternWord a) {
+    uint64_t lanes[PW_LANES];
+    pw_store(lanes, a);
+    for (int i = 0; i < PW_LANES; i++) {
+        if (lanes[i]) return i * 64 + __builtin_ctzll(lanes[i]);
+    }
+    return -1;
+}
+
+// Per-thread simulation state: good and faulty machines plus the event wheel
+typedef struct {
+    const Circuit* circuit;
+    const bool* is_output;
+    PatternWord* good;
+    PatternWord* faulty;          // equals 'good' everywhere between faults
+    PatternWord* good0;           // dual rail: zeros planes ('good' and 'faulty'
+    PatternWord* faulty0;         // hold the ones); NULL when two-valued
+    int* events;                  // level L queues its ops in [level_start[L], ...)
+    int* level_count;
+    bool* scheduled;
+    int* touched;
+    uint64_t* block_words;        // PW_LANES packed 64-vector blocks
+    uint64_t* x_words;            // and their X inputs (dual rail)
+    int block_base;               // first vector held in 'good', -1 if none
+    PatternWord valid;            // lanes that carry a real pattern
+    const CompiledKernel* kernel; // compiled good machine, two-valued runs only
+    int* failing;                 // dictionary capture: outputs the last fault reached,
+    PatternWord* failing_diff;    // with their (definite) difference lanes; NULL otherwise
+    int num_failing;
+    PatternWord* prev;            // transition faults: good machine under each lane's previous
+    PatternWord* prev0;           // vector (dual rail: its zeros plane); NULL otherwise
+    uint64_t* prev_words;         // the previous vectors' inputs, laid out like block_words
+    PatternWord pair_valid;       // lanes that close a launch/capture pair
+} PpsfpWorker;
+
+static void worker_init(PpsfpWorker* w, const Circuit* circuit, const bool* is_output, bool dual_rail,
+                        const CompiledKernel* kernel) {
+    const EvalProgram* prog = &circuit->program;
+    int num_nets = circuit->nets.count;
+    w->circuit = circuit;
+    w->is_output = is_output;
+    w->good = (PatternWord*)pw_alloc((num_nets + 1) * sizeof(PatternWord));
+    w->faulty = (PatternWord*)pw_alloc((num_nets + 1) * sizeof(PatternWord));
+    for (int n = 0; n <= num_nets; n++) w->good[n] = pw_zero();
+    w->kernel = !dual_rail && kernel && kernel->good ? kernel : NULL;
+    w->good0 = NULL;
+    w->faulty0 = NULL;
+    if (dual_rail) {
+        // Nets no vector or op ever sets (undriven, the X slot) stay X
+        w->good0 = (PatternWord*)pw_alloc((num_nets + 1) * sizeof(PatternWord));
+        w->faulty0 = (PatternWord*)pw_alloc((num_nets + 1) * sizeof(PatternWord));
+        for (int n = 0; n <= num_nets; n++) w->good0[n] = pw_zero();
+    }
+    w->events = (int*)malloc((prog->num_ops + 1) * sizeof(int));
+    w->level_count = (int*)calloc(prog->num_levels, sizeof(int));
+    w->scheduled = (bool*)calloc(prog->num_ops + 1, sizeof(bool));
+    w->touched = (int*)malloc((num_nets + 1) * sizeof(int));
+    w->block_words = (uint64_t*)malloc((2 * circuit->num_primary_inputs + 1) * PW_LANES * sizeof(uint64_t));
+    w->x_words = w->block_words + (size_t)circuit->num_primary_inputs * PW_LANES;
+    w->block_base = -1;
+    w->failing = NULL;
+    w->failing_diff = NULL;
+    w->num_failing = 0;
+    w->prev = NULL;
+    w->prev0 = NULL;
+    w->prev_words = NULL;
+}
+
+// Helper: Give a worker the previous-vector machine transition faults need
+static void worker_enable_transitions(PpsfpWorker* w) {
+    int num_nets = w->circuit->nets.count;
+    w->prev = (PatternWord*)pw_alloc((num_nets + 1) * sizeof(PatternWord));
+    for (int n = 0; n <= num_nets; n++) w->prev[n] = pw_zero();
+    if (w->good0) {
+        w->prev0 = (PatternWord*)pw_alloc((num_nets + 1) * sizeof(PatternWord));
+        for (int n = 0; n <= num_nets; n++) w->prev0[n] = pw_zero();
+    }
+    w->prev_words = (uint64_t*)malloc((2 * w->circuit->num_primary_inputs + 1) * (PW_LANES + 1) * sizeof(uint64_t));
+}
+
+static void worker_free(PpsfpWorker* w) {
+    if (w->prev) {
+        free(w->prev_words);
+        if (w->prev0) pw_free(w->prev0);
+        pw_free(w->prev);
+    }
+    if (w->failing) {
+        pw_free(w->failing_diff);
+        free(w->failing);
+    }
+    free(w->block_words);
+    free(w->touched);
+    free(w->scheduled);
+    free(w->level_count);
+    free(w->events);
+    if (w->good0) {
+        pw_free(w->faulty0);
+        pw_free(w->good0);
+    }
+    pw_free(w->faulty);
+    pw_free(w->good);
+}
+
+// Helper: Set the primary inputs from words[k * num_inputs + i] (lane k of
+// input i) and x_words alike, then simulate the good machine into
+// 'ones' (and 'zeros', dual rail)
+static void worker_eval_good(PpsfpWorker* w, const uint64_t* words, const uint64_t* x_words, PatternWord* ones,
+                             PatternWord* zeros) {
+    const Circuit* circuit = w->circuit;
+    const EvalProgram* prog = &circuit->program;
+    int num_inputs = circuit->num_primary_inputs;
+    uint64_t lanes[PW_LANES];
+    for (int i = 0; i < num_inputs; i++) {
+        for (int k = 0; k < PW_LANES; k++) lanes[k] = words[(size_t)k * num_inputs + i];
+        PatternWord value = pw_load(lanes);
+        if (!zeros) {
+            ones[circuit->primary_inputs[i]] = value;
+            continue;
+        }
+        for (int k = 0; k < PW_LANES; k++) lanes[k] = ~x_words[(size_t)k * num_inputs + i];
+        PatternWord known = pw_load(lanes);
+        ones[circuit->primary_inputs[i]] = pw_and(value, known);
+        zeros[circuit->primary_inputs[i]] = pw_and(pw_xor(value, pw_ones()), known);
+    }
+    if (w->kernel) {
+        w->kernel->good(ones);
+    } else {
+        for (int k = 0; k < prog->num_ops; k++) {
+            if (zeros) eval_op_pin3(prog, k, ones, zeros, -1, pw_zero(), pw_zero(), &ones[prog->out[k]], &zeros[prog->out[k]]);
+            else ones[prog->out[k]] = eval_op(prog, k, ones);
+        }
+    }
+    INSTR_COUNT(COUNTER_GATE_EVALS, prog->num_ops);
+}
+
+// Helper: Simulate the good machine under the vector before each lane's:
+// the block's inputs moved up one lane, lane 0 taking the last vector of
+// the previous block. Vector 0 has none and closes no pair.
+static void worker_load_previous(PpsfpWorker* w, const TestVectors* tv, int base) {
+    int num_inputs = tv->num_inputs;
+    uint64_t* words = w->prev_words;
+    uint64_t* x_words = words + (size_t)PW_LANES * num_inputs;
+    uint64_t* carry = x_words + (size_t)PW_LANES * num_inputs;
+    uint64_t* carry_x = carry + num_inputs;
+    memset(carry, 0, 2 * num_inputs * sizeof(uint64_t));
+    if (base > 0) {
+        load_vector_block(tv, base / 64 - 1, carry);
+        if (w->good0) load_vector_x(tv, base / 64 - 1, carry_x);
+    }
+    for (int k = 0; k < PW_LANES; k++) {
+        for (int i = 0; i < num_inputs; i++) {
+            size_t at = (size_t)k * num_inputs + i;
+            uint64_t below = k > 0 ? w->block_words[at - num_inputs] : carry[i];
+            words[at] = (w->block_words[at] << 1) | (below >> 63);
+            if (!w->good0) continue;
+            uint64_t below_x = k > 0 ? w->x_words[at - num_inputs] : carry_x[i];
+            x_words[at] = (w->x_words[at] << 1) | (below_x >> 63);
+        }
+    }
+    worker_eval_good(w, words, x_words, w->prev, w->prev0);
+    w->pair_valid = w->valid;
+    if (base == 0) {
+        uint64_t lanes[PW_LANES];
+        memset(lanes, 0, sizeof(lanes));
+        lanes[0] = 1;
+        w->pair_valid = pw_and(w->valid, pw_xor(pw_load(lanes), pw_ones()));
+    }
+}
+
+// Helper: Load PATTERNS_PER_WORD vectors starting at 'base' and simulate the good machine
+static void worker_load_block(PpsfpWorker* w, const TestVectors* tv, int base, int count) {
+    const Circuit* circuit = w->circuit;
+    int num_inputs = tv->num_inputs;
+    uint64_t lanes[PW_LANES];
+    for (int k = 0; k < PW_LANES; k++) {
+        uint64_t* words = w->block_words + (size_t)k * num_inputs;
+        uint64_t* x_words = w->x_words + (size_t)k * num_inputs;
+        if (base / 64 + k < tv->num_blocks) {
+            load_vector_block(tv, base / 64 + k, words);
+            if (w->good0) load_vector_x(tv, base / 64 + k, x_words);
+        } else {
+            memset(words, 0, num_inputs * sizeof(uint64_t));
+            memset(x_words, 0, num_inputs * sizeof(uint64_t));
+        }
+    }
+    // Mask of the lanes that carry a real pattern in a partial last block
+    memset(lanes, 0, sizeof(lanes));
+    for (int p = 0; p < count; p++) lanes[p >> 6] |= (uint64_t)1 << (p & 63);
+    w->valid = pw_load(lanes);
+    worker_eval_good(w, w->block_words, w->x_words, w->good, w->good0);
+    if (w->prev) worker_load_previous(w, tv, base);
+    memcpy(w->faulty, w->good, (circuit->nets.count + 1) * sizeof(PatternWord));
+    if (w->good0) memcpy(w->faulty0, w->good0, (circuit->nets.count + 1) * sizeof(PatternWord));
+    w->block_base = base;
+}
+
+// Helper: Schedule every op that reads 'net'; returns the number newly queued
+static inline int schedule_fanouts(PpsfpWorker* w, const EvalProgram* prog, int net) {
+    int queued = 0;
+    for (int e = prog->fanout_start[net]; e < prog->fanout_start[net + 1]; e++) {
+        int k = prog->fanout[e];
+        if (w->scheduled[k]) continue;
+        int level = prog->net_level[prog->out[k]];
+        w->scheduled[k] = true;
+        w->events[prog->level_start[level] + w->level_count[level]++] = k;
+        queued++;
+    }
+    return queued;
+}
+
+// Helper: Remember an output the fault reached, for dictionary capture
+static inline void worker_note_failing(PpsfpWorker* w, int net, PatternWord diff) {
+    w->failing[w->num_failing] = net;
+    w->failing_diff[w->num_failing++] = diff;
+}
+
+// Helper: Inject one fault into the loaded block; returns the lanes that detect it
+static PatternWord worker_simulate_fault(PpsfpWorker* w, const Fault* fault) {
+    const EvalProgram* prog = &w->circuit->program;
+    int site = fault->net;
+    PatternWord site_value = fault->stuck_at_value ? pw_ones() : pw_zero();
+    w->num_failing = 0;
+    // Patterns where the site differs from its stuck value activate the fault
+    if (w->circuit->net_driver[site] < 0 || !pw_any(pw_and(pw_xor(w->good[site], site_value), w->valid))) return pw_zero();
+    if (fault->gate >= 0) {
+        // Branch fault: only the faulty pin sees the stuck value, so the
+        // fault effect starts at the output of the gate reading it
+        int k = prog->gate_op[fault->gate];
+        site = prog->out[k];
+        site_value = eval_op_pin(prog, k, w->good, fault->pin, site_value);
+        if (!pw_any(pw_and(pw_xor(w->good[site], site_value), w->valid))) return pw_zero();
+    }
+
+    int num_touched = 0;
+    PatternWord detect = pw_zero();
+    w->faulty[site] = site_value;
+    w->touched[num_touched++] = site;
+    if (w->is_output[site]) {
+        detect = pw_xor(site_value, w->good[site]);
+        if (w->failing) worker_note_failing(w, site, detect);
+    }
+    int pending = schedule_fanouts(w, prog, site);
+    for (int level = prog->net_level[site] + 1; level < prog->num_levels && pending > 0; level++) {
+        for (int q = 0; q < w->level_count[level]; q++) {
+            int k = w->events[prog->level_start[level] + q];
+            w->scheduled[k] = false;
+            pending--;
+            INSTR_COUNT(COUNTER_EVENTS, 1);
+            INSTR_COUNT(COUNTER_GATE_EVALS, 1);
+            int out = prog->out[k];
+            PatternWord value = eval_op(prog, k, w->faulty);
+            PatternWord diff = pw_xor(value, w->good[out]);
+            if (!pw_any(diff)) continue;
+            w->faulty[out] = value;
+            w->touched[num_touched++] = out;
+            if (w->is_output[out]) {
+                detect = pw_or(detect, diff);
+                if (w->failing) worker_note_failing(w, out, diff);
+            }
+            pending += schedule_fanouts(w, prog, out);
+        }
+        w->level_count[level] = 0;
+    }
+    // Restore the faulty machine to the good values for the next fault
+    for (int t = 0; t < num_touched; t++) w->faulty[w->touched[t]] = w->good[w->touched[t]];
+    return pw_and(detect, w->valid);
+}
+
+// Helper: Dual-rail counterpart of worker_simulate_fault(). Returns the lanes
+// that detect the fault for certain; lanes where an output is known in the
+// good machine and X in the faulty one go to *potential.
+static PatternWord worker_simulate_fault3(PpsfpWorker* w, const Fault* fault, PatternWord* potential) {
+    const EvalProgram* prog = &w->circuit->program;
+    int site = fault->net;
+    PatternWord site1 = fault->stuck_at_value ? pw_ones() : pw_zero();
+    PatternWord site0 = fault->stuck_at_value ? pw_zero() : pw_ones();
+    *potential = pw_zero();
+    w->num_failing = 0;
+    // Only a known opposite value activates the fault: where the good site
+    // is X, the faulty machine is just as defined and cannot disagree
+    PatternWord opposite = fault->stuck_at_value ? w->good0[site] : w->good[site];
+    if (w->circuit->net_driver[site] < 0 || !pw_any(pw_and(opposite, w->valid))) return pw_zero();
+    if (fault->gate >= 0) {
+        int k = prog->gate_op[fault->gate];
+        site = prog->out[k];
+        eval_op_pin3(prog, k, w->good, w->good0, fault->pin, site1, site0, &site1, &site0);
+        PatternWord diff = pw_or(pw_xor(w->good[site], site1), pw_xor(w->good0[site], site0));
+        if (!pw_any(pw_and(diff, w->valid))) return pw_zero();
+    }
+
+    int num_touched = 0;
+    PatternWord detect = pw_zero(), unknown = pw_zero();
+    w->faulty[site] = site1;
+    w->faulty0[site] = site0;
+    w->touched[num_touched++] = site;
+    if (w->is_output[site]) {
+        detect = pw_or(pw_and(site1, w->good0[site]), pw_and(site0, w->good[site]));
+        if (w->failing) worker_note_failing(w, site, detect);
+        unknown = pw_and(pw_or(w->good[site], w->good0[site]), pw_xor(pw_or(site1, site0), pw_ones()));
+    }
+    int pending = schedule_fanouts(w, prog, site);
+    for (int level = prog->net_level[site] + 1; level < prog->num_levels && pending > 0; level++) {
+        for (int q = 0; q < w->level_count[level]; q++) {
+            int k = w->events[prog->level_start[level] + q];
+            w->scheduled[k] = false;
+            pending--;
+            INSTR_COUNT(COUNTER_EVENTS, 1);
+            INSTR_COUNT(COUNTER_GATE_EVALS, 1);
+            int out = prog->out[k];
+            PatternWord v1, v0;
+            eval_op_pin3(prog, k, w->faulty, w->faulty0, -1, pw_zero(), pw_zero(), &v1, &v0);
+            PatternWord g1 = w->good[out], g0 = w->good0[out];
+            if (!pw_any(pw_or(pw_xor(v1, g1), pw_xor(v0, g0)))) continue;
+            w->faulty[out] = v1;
+            w->faulty0[out] = v0;
+            w->touched[num_touched++] = out;
+            if (w->is_output[out]) {
+                PatternWord diff = pw_or(pw_and(v1, g0), pw_and(v0, g1));
+                detect = pw_or(detect, diff);
+                if (w->failing) worker_note_failing(w, out, diff);
+                unknown = pw_or(unknown, pw_and(pw_or(g1, g0), pw_xor(pw_or(v1, v0), pw_ones())));
+            }
+            pending += schedule_fanouts(w, prog, out);
+        }
+        w->level_count[level] = 0;
+    }
+    for (int t = 0; t < num_touched; t++) {
+        w->faulty[w->touched[t]] = w->good[w->touched[t]];
+        w->faulty0[w->touched[t]] = w->good0[w->touched[t]];
+    }
+    detect = pw_and(detect, w->valid);
+    if (!pw_any(detect)) *potential = pw_and(unknown, w->valid);
+    return detect;
+}
+
+// Helper: Simulate a stuck-at fault, or the transition fault with the same
+// site and value. A slow-to-rise (-fall) fault is detected by a pair of
+// consecutive vectors where the first sets the site to 0 (1) and the second
+// detects it stuck-at 0 (1): the faulty machine still holds the old value at
+// capture. Lanes where the first vector leaves the site at X detect it at
+// most potentially.
+static PatternWord worker_detect(PpsfpWorker* w, const Fault* fault, bool transition, PatternWord* potential) {
+    *potential = pw_zero();
+    if (!transition) return w->good0 ? worker_simulate_fault3(w, fault, potential) : worker_simulate_fault(w, fault);
+    int site = fault->net;
+    PatternWord init, unknown = pw_zero();
+    if (w->prev0) {
+        init = fault->stuck_at_value ? w->prev[site] : w->prev0[site];
+        unknown = pw_xor(pw_or(w->prev[site], w->prev0[site]), pw_ones());
+    } else {
+        init = fault->stuck_at_value ? w->prev[site] : pw_xor(w->prev[site], pw_ones());
+    }
+    // Narrow the lanes the stuck-at simulation considers to the initialized pairs
+    PatternWord valid = w->valid;
+    PatternWord detect = pw_zero();
+    w->valid = pw_and(w->pair_valid, pw_or(init, unknown));
+    if (pw_any(w->valid)) detect = w->good0 ? worker_simulate_fault3(w, fault, potential) : worker_simulate_fault(w, fault);
+    w->valid = valid;
+    PatternWord uncertain = pw_and(detect, unknown);
+    detect = pw_and(detect, init);
+    *potential = pw_any(detect) ? pw_zero() : pw_or(*potential, uncertain);
+    return detect;
+}
+
+// Work item of the multithreaded run: one pattern block times one fault chunk
+typedef struct {
+    Circuit* circuit;
+    const TestVectors* tv;
+    int num_chunks;
+    int first_transition;         // faults from here on are transition faults
+    bool fault_dropping;
+    PpsfpWorker* workers;
+    DetectionMap* detections;
+    DropHint* hint;
+} PpsfpTask;
+
+static void ppsfp_task(void* ctx, int thread_id, int item) {
+    PpsfpTask* task = (PpsfpTask*)ctx;
+    PpsfpWorker* w = &task->workers[thread_id];
+    int num_faults = task->circuit->num_faults;
+    int base = (item / task->num_chunks) * PATTERNS_PER_WORD;
+    int chunk = item % task->num_chunks;
+    // Items of one block are adjacent, so a thread usually reuses its good machine
+    if (w->block_base != base) {
+        int count = task->tv->num_vectors - base < PATTERNS_PER_WORD ? task->tv->num_vectors - base : PATTERNS_PER_WORD;
+        worker_load_block(w, task->tv, base, count);
+    }
+    int begin = (int)((long long)num_faults * chunk / task->num_chunks);
+    int end = (int)((long long)num_faults * (chunk + 1) / task->num_chunks);
+    for (int f = begin; f < end; f++) {
+        if (task->fault_dropping && drop_hint_dropped(task->hint, f, base)) continue;
+        PatternWord potential;
+        PatternWord detect = worker_detect(w, &task->circuit->faults[f], f >= task->first_transition, &potential);
+        if (pw_any(potential)) detection_map_set_potential(&task->detections[thread_id], f);
+        if (!pw_any(detect)) continue;
+        int vector = base + pw_first_lane(detect);
+        detection_map_set(&task->detections[thread_id], f, vector);
+        if (task->fault_dropping) drop_hint_update(task->hint, f, vector);
+    }
+}
+
+// Helper: Split faults into enough chunks to keep every thread busy
+static int choose_fault_chunks(int num_blocks, int num_faults, int num_threads) {
+    if (num_blocks < 1) num_blocks = 1; // an empty vector set: nothing to split
+    int chunks = (4 * num_threads + num_blocks - 1) / num_blocks;
+    if (chunks > num_faults) chunks = num_faults;
+    return chunks < 1 ? 1 : chunks;
+}
+
+// Helper: The PPSFP run over the circuit's faults, those from
+// 'first_transition' on taken as transition faults
+static void ppsfp_run(Circuit* circuit, const TestVectors* tv, const SimOptions* options, int first_transition) {
+    int num_vectors = tv->num_vectors;
+    int num_threads = options->num_threads > 1 ? options->num_threads : 1;
+    bool dual_rail = tv->has_x || program_has_unknowns(circuit);
+    if (!options->quiet) {
+        printf("\nRunning Parallel-Pattern Single-Fault-Propagation Simulation (%d patterns/word%s%s, %d thread%s)...\n",
+               PATTERNS_PER_WORD, dual_rail ? ", 0/1/X" : "", options->fault_dropping ? ", fault dropping" : "",
+               num_threads, num_threads > 1 ? "s" : "");
+    }
+    int num_nets = circuit->nets.count;
+    bool* is_output = (bool*)calloc(num_nets + 1, sizeof(bool));
+    for (int i = 0; i < circuit->num_primary_outputs; i++) is_output[circuit->primary_outputs[i]] = true;
+
+    if (num_threads > 1) {
+        int num_blocks = (num_vectors + PATTERNS_PER_WORD - 1) / PATTERNS_PER_WORD;
+        PpsfpTask task;
+        task.circuit = circuit;
+        task.tv = tv;
+        task.num_chunks = choose_fault_chunks(num_blocks, circuit->num_faults, num_threads);
+        task.first_transition = first_transition;
+        task.fault_dropping = options->fault_dropping;
+        task.workers = (PpsfpWorker*)pw_alloc(num_threads * sizeof(PpsfpWorker));
+        task.detections = (DetectionMap*)malloc(num_threads * sizeof(DetectionMap));
+        task.hint = drop_hint_create(circuit);
+        for (int t = 0; t < num_threads; t++) {
+            worker_init(&task.workers[t], circuit, is_output, dual_rail, options->kernel);
+            if (first_transition < circuit->num_faults) worker_enable_transitions(&task.workers[t]);
+            detection_map_init(&task.detections[t], circuit->num_faults);
+        }
+        parallel_for(num_blocks * task.num_chunks, num_threads, ppsfp_task, &task);
+        detection_map_merge(circuit, task.detections, num_threads);
+        for (int t = 0; t < num_threads; t++) {
+            worker_free(&task.workers[t]);
+            detection_map_free(&task.detections[t]);
+        }
+        drop_hint_free(task.hint);
+        free(task.detections);
+        pw_free(task.workers);
+        free(is_output);
+        if (!options->quiet) printf("PPSFP simulation run complete.\n");
+        return;
+    }
+
+    PpsfpWorker worker;
+    worker_init(&worker, circuit, is_output, dual_rail, options->kernel);
+    if (first_transition < circuit->num_faults) worker_enable_transitions(&worker);
+    // Active fault set, compacted after every block when dropping
+    int* active = (int*)malloc((circuit->num_faults + 1) * sizeof(int));
+    int num_active = 0;
+    for (int f = 0; f < circuit->num_faults; f++) {
+        if (!(options->fault_dropping && circuit->faults[f].detected)) active[num_active++] = f;
+    }
+    for (int base = 0; base < num_vectors; base += PATTERNS_PER_WORD) {
+        int count = num_vectors - base < PATTERNS_PER_WORD ? num_vectors - base : PATTERNS_PER_WORD;
+        worker_load_block(&worker, tv, base, count);
+        int num_live = 0;
+        for (int a = 0; a < num_active; a++) {
+            Fault* fault = &circuit->faults[active[a]];
+            active[num_live++] = active[a];
+            PatternWord potential;
+            PatternWord detect = worker_detect(&worker, fault, active[a] >= first_transition, &potential);
+            if (pw_any(potential)) fault->potential = true;
+            if (pw_any(detect)) {
+                record_detection(fault, base + pw_first_lane(detect));
+                if (options->fault_dropping) num_live--;
+            }
+        }
+        num_active = num_live;
+    }
+    free(active);
+    worker_free(&worker);
+    free(is_output);
+    if (!options->quiet) printf("PPSFP simulation run complete.\n");
+}
+
+void run_ppsfp_simulation(Circuit* circuit, const TestVectors* tv, const SimOptions* options) {
+    ppsfp_run(circuit, tv, options, circuit->num_faults);
+}
+
+// Stuck-at and transition faults go through one run as a single fault list:
+// every block's good machine (and that of the vectors before it) is
+// simulated once for both models
+void run_ppsfp_transitions(Circuit* circuit, Circuit* transition, const TestVectors* tv, const SimOptions* options) {
+    Circuit combined = *circuit;
+    combined.num_faults = circuit->num_faults + transition->num_faults;
+    combined.num_dominated_faults = 0;
+    combined.faults = (Fault*)malloc((combined.num_faults + 1) * sizeof(Fault));
+    memcpy(combined.faults, circuit->faults, circuit->num_faults * sizeof(Fault));
+    memcpy(combined.faults + circuit->num_faults, transition->faults, transition->num_faults * sizeof(Fault));
+    ppsfp_run(&combined, tv, options, circuit->num_faults);
+    memcpy(circuit->faults, combined.faults, circuit->num_faults * sizeof(Fault));
+    memcpy(transition->faults, combined.faults + circuit->num_faults, transition->num_faults * sizeof(Fault));
+    free(combined.faults);
+}
+
+// Fault dictionary capture: each thread takes a chunk of faults through
+// every pattern block in order, so the responses of one fault reach the
+// sink from one thread, by increasing vector
+typedef struct {
+    Circuit* circuit;
+    const TestVectors* tv;
+    int num_chunks;
+    PpsfpWorker* workers;
+    const int* output_index;      // net -> first primary output it drives
+    const uint32_t* output_code;
+    uint32_t* syndromes;          // PATTERNS_PER_WORD per thread
+    ResponseSink sink;
+    void* ctx;
+} CaptureTask;
+
+static void capture_task(void* ctx, int thread_id, int chunk) {
+    CaptureTask* task = (CaptureTask*)ctx;
+    PpsfpWorker* w = &task->workers[thread_id];
+    uint32_t* syndromes = task->syndromes + (size_t)thread_id * PATTERNS_PER_WORD;
+    int num_classes = task->circuit->num_faults + task->circuit->num_dominated_faults;
+    int begin = (int)((long long)num_classes * chunk / task->num_chunks);
+    int end = (int)((long long)num_classes * (chunk + 1) / task->num_chunks);
+    uint64_t lanes[PW_LANES];
+    for (int base = 0; base < task->tv->num_vectors; base += PATTERNS_PER_WORD) {
+        int count = task->tv->num_vectors - base < PATTERNS_PER_WORD ? task->tv->num_vectors - base : PATTERNS_PER_WORD;
+        worker_load_block(w, task->tv, base, count);
+        for (int f = begin; f < end; f++) {
+            Fault* fault = &task->circuit->faults[f];
+            PatternWord potential = pw_zero();
+            PatternWord detect = w->good0 ? worker_simulate_fault3(w, fault, &potential) : worker_simulate_fault(w, fault);
+            if (pw_any(potential)) fault->potential = true;
+            if (!pw_any(detect)) continue;
+            record_detection(fault, base + pw_first_lane(detect));
+            for (int i = 0; i < w->num_failing; i++) {
+                uint32_t code = task->output_code[task->output_index[w->failing[i]]];
+                pw_store(lanes, pw_and(w->failing_diff[i], w->valid));
+                for (int k = 0; k < PW_LANES; k++) {
+                    for (uint64_t bits = lanes[k]; bits; bits &= bits - 1) syndromes[k * 64 + __builtin_ctzll(bits)] ^= code;
+                }
+            }
+            pw_store(lanes, detect);
+            for (int k = 0; k < PW_LANES; k++) {
+                for (uint64_t bits = lanes[k]; bits; bits &= bits - 1) {
+                    int p = k * 64 + __builtin_ctzll(bits);
+                    task->sink(task->ctx, f, base + p, syndromes[p]);
+                    syndromes[p] = 0;
+                }
+            }
+        }
+    }
+}
+
+void capture_ppsfp_responses(Circuit* circuit, const TestVectors* tv, const SimOptions* options,
+                             const uint32_t* output_code, ResponseSink sink, void* ctx) {
+    int num_threads = options->num_threads > 1 ? options->num_threads : 1;
+    int num_classes = circuit->num_faults + circuit->num_dominated_faults;
+    bool dual_rail = tv->has_x || program_has_unknowns(circuit);
+    int num_nets = circuit->nets.count;
+    bool* is_output = (bool*)calloc(num_nets + 1, sizeof(bool));
+    int* output_index = (int*)malloc((num_nets + 1) * sizeof(int));
+    for (int i = circuit->num_primary_outputs - 1; i >= 0; i--) {
+        is_output[circuit->primary_outputs[i]] = true;
+        output_index[circuit->primary_outputs[i]] = i;
+    }
+    CaptureTask task;
+    task.circuit = circuit;
+    task.tv = tv;
+    task.num_chunks = num_threads > 1 ? choose_fault_chunks(1, num_classes, num_threads) : 1;
+    task.workers = (PpsfpWorker*)pw_alloc(num_threads * sizeof(PpsfpWorker));
+    task.output_index = output_index;
+    task.output_code = output_code;
+    task.syndromes = (uint32_t*)calloc((size_t)num_threads * PATTERNS_PER_WORD, sizeof(uint32_t));
+    task.sink = sink;
+    task.ctx = ctx;
+    for (int t = 0; t < num_threads; t++) {
+        PpsfpWorker* w = &task.workers[t];
+        worker_init(w, circuit, is_output, dual_rail, options->kernel);
+        // A fault reaches each output at most once per block
+        w->failing = (int*)malloc((circuit->num_primary_outputs + 1) * sizeof(int));
+        w->failing_diff = (PatternWord*)pw_alloc((circuit->num_primary_outputs + 1) * sizeof(PatternWord));
+    }
+    parallel_for(task.num_chunks, num_threads, capture_task, &task);
+    for (int t = 0; t < num_threads; t++) worker_free(&task.workers[t]);
+    free(task.syndromes);
+    pw_free(task.workers);
+    free(output_index);
+    free(is_output);
+}
@@ -0,0 +1,201 @@
+#include "fault_simulator.h"
+
+// Built-in random-pattern generation. Vectors are generated in memory, four
+// packed 64-vector blocks at a time, and handed to the engines as a packed
+// vector source, so no vector file is written or read. Every input has a
+// signal probability (0.5 unless a weights file says otherwise). The run
+// stops at the vector limit, at full coverage, or when coverage gained over
+// the last K blocks drops below a threshold. Only the vectors that were the
+// first to detect some fault are kept and written out: together they detect
+// everything the whole random sequence did.
+
+#define BLOCKS_PER_ROUND 4
+#define WEIGHT_LEVELS 256   // signal probabilities are quantized to 1/256
+
+// xoshiro256** seeded through splitmix64
+typedef struct {
+    uint64_t s[4];
+} RandomState;
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static void random_seed(RandomState* rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) rng->s[i] = splitmix64(seed += 0x9e3779b97f4a7c15ull);
+}
+
+static inline uint64_t random_next(RandomState* rng) {
+    uint64_t* s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+// Helper: 64 random bits that are each 1 with probability level / 256.
+// Walking the bits of 'level' from the least significant set bit up, OR
+// with a fresh word maps p to (1 + p) / 2 and AND maps p to p / 2.
+static uint64_t weighted_word(RandomState* rng, int level) {
+    if (level == WEIGHT_LEVELS / 2) return random_next(rng);
+    if (level <= 0) return 0;
+    if (level >= WEIGHT_LEVELS) return ~(uint64_t)0;
+    uint64_t word = 0;
+    for (int bit = __builtin_ctz(level); bit < 8; bit++) {
+        word = (level >> bit) & 1 ? word | random_next(rng) : word & random_next(rng);
+    }
+    return word;
+}
+
+// Helper: Read "input probability" lines into per-input weight levels
+static bool read_weights(const char* filename, const Circuit* circuit, int* levels) {
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        perror("Error opening weights file");
+        return false;
+    }
+    int* input_index = (int*)malloc((circuit->nets.count + 1) * sizeof(int));
+    for (int n = 0; n <= circuit->nets.count; n++) input_index[n] = -1;
+    for (int i = 0; i < circuit->num_primary_inputs; i++) input_index[circuit->primary_inputs[i]] = i;
+    char line[1024], name[512];
+    int line_num = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        line_num++;
+        double probability;
+        char first[2];
+        if (sscanf(line, " %1s", first) != 1 || first[0] == '#') continue;
+        if (sscanf(line, " %511s %lf", name, &probability) != 2 || probability < 0.0 || probability > 1.0) {
+            fprintf(stderr, "Error: %s line %d: expected '<input> <probability 0..1>'\n", filename, line_num);
+            ok = false;
+            break;
+        }
+        int net = symtab_lookup(&circuit->nets, name);
+        if (net < 0 || input_index[net] < 0) {
+            fprintf(stderr, "Error: %s line %d: '%s' is not a primary input\n", filename, line_num, name);
+            ok = false;
+            break;
+        }
+        levels[input_index[net]] = (int)(probability * WEIGHT_LEVELS + 0.5);
+    }
+    free(input_index);
+    fclose(file);
+    return ok;
+}
+
+// Helper: Append the vectors of this round that first detected a fault
+static void write_detecting_vectors(FILE* file, const uint64_t* words, int num_inputs, const bool* keep, int count) {
+    char* line = (char*)malloc(2 * num_inputs + 1);
+    for (int v = 0; v < count; v++) {
+        if (!keep[v]) continue;
+        const uint64_t* block = words + (size_t)(v / 64) * num_inputs;
+        for (int i = 0; i < num_inputs; i++) {
+            line[2 * i] = (char)('0' + ((block[i] >> (v & 63)) & 1));
+            line[2 * i + 1] = ' ';
+        }
+        line[2 * num_inputs - 1] = '\n';
+        fwrite(line, 1, 2 * num_inputs, file);
+    }
+    free(line);
+}
+
+int run_random_patterns(const char* engine, Circuit* circuit, const SimOptions* options,
+                        const RandomPatternOptions* random, const char* vectors_filename) {
+    int num_inputs = circuit->num_primary_inputs;
+    int* levels = (int*)malloc((num_inputs + 1) * sizeof(int));
+    for (int i = 0; i < num_inputs; i++) levels[i] = WEIGHT_LEVELS / 2;
+    if (random->weights_filename && !read_weights(random->weights_filename, circuit, levels)) {
+        free(levels);
+        return -1;
+    }
+    FILE* file = fopen(vectors_filename, "w");
+    if (!file) {
+        perror("Error opening detecting vectors file");
+        free(levels);
+        return -1;
+    }
+    printf("\nRunning random patterns with the %s engine (seed %llu, up to %d vectors, stop below %.3f%% gain over %d blocks)...\n",
+           engine, (unsigned long long)random->seed, random->max_vectors, random->stop_gain, random->stop_window);
+
+    RandomState rng;
+    random_seed(&rng, random->seed);
+    int round_vectors = BLOCKS_PER_ROUND * 64;
+    uint64_t* words = (uint64_t*)malloc((size_t)BLOCKS_PER_ROUND * (num_inputs + 1) * sizeof(uint64_t));
+    TestVectors tv;
+    memset(&tv, 0, sizeof(tv));
+    tv.num_inputs = num_inputs;
+    tv.packed = words;
+    SimOptions round_options = *options;
+    round_options.quiet = true;
+
+    int num_classes = circuit->num_faults + circuit->num_dominated_faults;
+    bool* was_detected = (bool*)malloc((num_classes + 1) * sizeof(bool));
+    bool* keep = (bool*)malloc(round_vectors * sizeof(bool));
+    int max_blocks = (random->max_vectors + 63) / 64;
+    double* coverage = (double*)calloc(max_blocks + 1, sizeof(double)); // after each block, in percent
+    int num_universe = circuit->num_uncollapsed_faults;
+    long long detected = 0;
+    for (int f = 0; f < num_classes; f++) {
+        if (circuit->faults[f].detected) detected += circuit->class_start[f + 1] - circuit->class_start[f];
+    }
+    int base = 0, num_blocks = 0, num_kept = 0;
+    const char* reason = "vector limit reached";
+    while (base < random->max_vectors) {
+        if (detected == num_universe) {
+            reason = "all faults detected";
+            break;
+        }
+        int count = random->max_vectors - base < round_vectors ? random->max_vectors - base : round_vectors;
+        tv.num_vectors = count;
+        tv.num_blocks = (count + 63) / 64;
+        for (int b = 0; b < tv.num_blocks; b++) {
+            for (int i = 0; i < num_inputs; i++) words[(size_t)b * num_inputs + i] = weighted_word(&rng, levels[i]);
+        }
+        for (int f = 0; f < num_classes; f++) was_detected[f] = circuit->faults[f].detected;
+        run_fault_simulation(engine, circuit, &tv, &round_options);
+
+        // Engines number vectors from 0 in every round; move new detections
+        // to the global sequence and tally them per block
+        memset(keep, 0, round_vectors * sizeof(bool));
+        long long new_in_block[BLOCKS_PER_ROUND] = { 0 };
+        for (int f = 0; f < num_classes; f++) {
+            Fault* fault = &circuit->faults[f];
+            if (!fault->detected || was_detected[f]) continue;
+            keep[fault->first_detected_vector] = true;
+            new_in_block[fault->first_detected_vector / 64] += circuit->class_start[f + 1] - circuit->class_start[f];
+            fault->first_detected_vector += base;
+        }
+        write_detecting_vectors(file, words, num_inputs, keep, count);
+        for (int v = 0; v < count; v++) num_kept += keep[v];
+        base += count;
+
+        bool saturated = false;
+        for (int b = 0; b < tv.num_blocks; b++) {
+            detected += new_in_block[b];
+            coverage[num_blocks] = num_universe > 0 ? 100.0 * detected / num_universe : 100.0;
+            if (num_blocks >= random->stop_window &&
+                coverage[num_blocks] - coverage[num_blocks - random->stop_window] < random->stop_gain) saturated = true;
+            num_blocks++;
+        }
+        if (saturated) {
+            reason = "coverage saturated";
+            break;
+        }
+    }
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) ok = false;
+    if (!ok) perror("Error writing detecting vectors file");
+    printf("Random patterns: %d vectors applied (%s), %.2f%% coverage; %d detecting vectors written to %s\n",
+           base, reason, num_universe > 0 ? 100.0 * detected / num_universe : 100.0, num_kept, vectors_filename);
+    free(coverage);
+    free(keep);
+    free(was_detected);
+    free(words);
+    free(levels);
+    return ok ? base : -1;
+}
@@ -0,0 +1,363 @@
+#include "fault_simulator.h"
+
+// Sequential circuits.
+// Full scan turns every flip-flop into a pseudo primary input (its Q net,
+// loaded through the scan chain) and a pseudo primary output (its D net,
+// unloaded through the scan chain), leaving a combinational circuit for the
+// regular engines.
+//
+// Without scan, vectors are applied one per clock cycle and flip-flop state
+// carries over between cycles. That rules out parallel patterns, so the
+// sequential engine runs parallel faults instead: bit 0 of every word is the
+// good machine and bits 1..63 are 63 faulty machines, each with its own
+// state. Flip-flops start from the reset state 0, or from X when asked to
+// model power-up without reset.
+//
+// Runs that can see an X keep a second word per net (dual rail: 'values'
+// has a lane set where the net is 1, 'values0' where it is 0, neither for
+// X). A lane is detected only where an output is 0 in one machine and 1 in
+// the other; an output known in the good machine and X in a faulty one
+// marks that fault as potentially detected.
+
+#define FAULTS_PER_WORD 63
+
+int count_flip_flops(const Circuit* circuit) {
+    int count = 0;
+    for (int g = 0; g < circuit->num_gates; g++) {
+        if (circuit->gate_type[g] == DFF) count++;
+    }
+    return count;
+}
+
+Circuit* full_scan_circuit(const Circuit* circuit) {
+    const SymbolTable* nets = &circuit->nets;
+    CircuitBuilder builder;
+    builder_init(&builder);
+    // Inputs: the primary inputs, then one scan cell per flip-flop
+    for (int i = 0; i < circuit->num_primary_inputs; i++) {
+        const char* name = symtab_name(nets, circuit->primary_inputs[i]);
+        builder_add_input(&builder, name, strlen(name));
+    }
+    for (int g = 0; g < circuit->num_gates; g++) {
+        if (circuit->gate_type[g] != DFF) continue;
+        const char* name = symtab_name(nets, circuit->gate_output[g]);
+        builder_add_input(&builder, name, strlen(name));
+    }
+    int* inputs = (int*)malloc((circuit->fanin_start[circuit->num_gates] + 1) * sizeof(int));
+    for (int g = 0; g < circuit->num_gates; g++) {
+        int type = circuit->gate_type[g];
+        if (type == INPUT || type == DFF) continue;
+        int num_inputs = 0;
+        for (int e = circuit->fanin_start[g]; e < circuit->fanin_start[g + 1]; e++) {
+            inputs[num_inputs++] = symtab_intern(&builder.circuit->nets, symtab_name(nets, circuit->fanin[e]));
+        }
+        int output = symtab_intern(&builder.circuit->nets, symtab_name(nets, circuit->gate_output[g]));
+        const char* name = gate_name(circuit, g);
+        builder_add_gate(&builder, type, name, strlen(name), output, inputs, num_inputs);
+    }
+    free(inputs);
+    // Outputs: the primary outputs, then the D net of every flip-flop
+    for (int i = 0; i < circuit->num_primary_outputs; i++) {
+        const char* name = symtab_name(nets, circuit->primary_outputs[i]);
+        builder_add_output(&builder, name, strlen(name));
+    }
+    for (int g = 0; g < circuit->num_gates; g++) {
+        if (circuit->gate_type[g] != DFF || circuit->fanin_start[g + 1] == circuit->fanin_start[g]) continue;
+        const char* name = symtab_name(nets, circuit->fanin[circuit->fanin_start[g]]);
+        builder_add_output(&builder, name, strlen(name));
+    }
+    return builder_finish(&builder);
+}
+
+// Helper: Word-parallel evaluation of op k; when 'forced', its input slots
+// take the branch faults of the current fault group lane by lane
+static inline uint64_t eval_op(const EvalProgram* prog, int k, const uint64_t* values,
+                               const uint64_t (*slot_force)[2], bool forced) {
+    const int* in = prog->in + prog->in_start[k];
+    int num_ins = prog->in_start[k + 1] - prog->in_start[k];
+    uint64_t acc = 0;
+    for (int j = 0; j < num_ins; j++) {
+        uint64_t v = values[in[j]];
+        if (forced) {
+            const uint64_t* f = slot_force[prog->in_start[k] + j];
+            v = (v & ~f[0]) | f[1];
+        }
+        if (j == 0) { acc = v; continue; }
+        switch (prog->op[k]) {
+            case AND: case NAND: acc &= v; break;
+            case OR: case NOR:   acc |= v; break;
+            case XOR: case XNOR: acc ^= v; break;
+            default: break;
+        }
+    }
+    switch (prog->op[k]) {
+        case AND: case OR: case XOR: case BUF: return acc;
+        case NAND: case NOR: case XNOR: case NOT: return ~acc;
+        default: return 0; // unsupported cells read as constant 0
+    }
+}
+
+// Helper: Dual-rail counterpart of eval_op()
+static inline void eval_op3(const EvalProgram* prog, int k, const uint64_t* ones, const uint64_t* zeros,
+                            const uint64_t (*slot_force)[2], bool forced, uint64_t* out1, uint64_t* out0) {
+    const int* in = prog->in + prog->in_start[k];
+    int num_ins = prog->in_start[k + 1] - prog->in_start[k];
+    uint64_t acc1 = 0, acc0 = 0;
+    for (int j = 0; j < num_ins; j++) {
+        uint64_t v1 = ones[in[j]], v0 = zeros[in[j]];
+        if (forced) {
+            const uint64_t* f = slot_force[prog->in_start[k] + j];
+            v1 = (v1 & ~f[0]) | f[1];
+            v0 = (v0 & ~f[1]) | f[0];
+        }
+        if (j == 0) { acc1 = v1; acc0 = v0; continue; }
+        switch (prog->op[k]) {
+            case AND: case NAND: acc1 &= v1; acc0 |= v0; break;
+            case OR: case NOR:   acc1 |= v1; acc0 &= v0; break;
+            case XOR: case XNOR: {
+                uint64_t t1 = (acc1 & v0) | (acc0 & v1);
+                acc0 = (acc1 & v1) | (acc0 & v0);
+                acc1 = t1;
+                break;
+            }
+            default: break;
+        }
+    }
+    switch (prog->op[k]) {
+        case AND: case OR: case XOR: case BUF: *out1 = acc1; *out0 = acc0; return;
+        case NAND: case NOR: case XNOR: case NOT: *out1 = acc0; *out0 = acc1; return;
+        default: *out1 = 0; *out0 = 0; return; // unsupported cells are X
+    }
+}
+
+// Per-thread machine state for one group of faults
+typedef struct {
+    const Circuit* circuit;
+    int num_dffs;
+    int* dff_gate;
+    uint64_t* values;             // one word per net plus the constant slot
+    uint64_t* state;              // one word per flip-flop
+    uint64_t* values0;            // dual rail: the zeros words of 'values'
+    uint64_t* state0;             // and 'state'; NULL when two-valued
+    bool unknown_state;           // flip-flops start at X
+    const CompiledKernel* kernel; // compiled step(), two-valued runs only
+    uint64_t (*net_force)[2];     // stem faults: lanes forced to 0 / to 1
+    uint64_t (*slot_force)[2];    // branch faults on op input slots
+    uint64_t (*dff_force)[2];     // branch faults on flip-flop D pins
+    bool* op_forced;              // op has a branch fault in this group
+    int* dff_index;               // gate -> flip-flop index, -1 otherwise
+} SequentialWorker;
+
+static void worker_init(SequentialWorker* w, const Circuit* circuit, int* dff_gate, int num_dffs, int* dff_index,
+                        bool dual_rail, bool unknown_state, const CompiledKernel* kernel) {
+    const EvalProgram* prog = &circuit->program;
+    int num_nets = circuit->nets.count;
+    int num_slots = prog->in_start[prog->num_ops];
+    w->circuit = circuit;
+    w->num_dffs = num_dffs;
+    w->dff_gate = dff_gate;
+    w->dff_index = dff_index;
+    w->values = (uint64_t*)calloc(num_nets + 1, sizeof(uint64_t));
+    w->state = (uint64_t*)calloc(num_dffs + 1, sizeof(uint64_t));
+    // Nets no vector or op ever sets (undriven, the X slot) stay X
+    w->values0 = dual_rail ? (uint64_t*)calloc(num_nets + 1, sizeof(uint64_t)) : NULL;
+    w->state0 = dual_rail ? (uint64_t*)calloc(num_dffs + 1, sizeof(uint64_t)) : NULL;
+    w->unknown_state = unknown_state;
+    w->kernel = !dual_rail && kernel && kernel->step ? kernel : NULL;
+    w->net_force = (uint64_t(*)[2])calloc(num_nets + 1, sizeof(uint64_t[2]));
+    w->slot_force = (uint64_t(*)[2])calloc(num_slots + 1, sizeof(uint64_t[2]));
+    w->dff_force = (uint64_t(*)[2])calloc(num_dffs + 1, sizeof(uint64_t[2]));
+    w->op_forced = (bool*)calloc(prog->num_ops + 1, sizeof(bool));
+}
+
+static void worker_free(SequentialWorker* w) {
+    free(w->op_forced);
+    free(w->dff_force);
+    free(w->slot_force);
+    free(w->net_force);
+    free(w->state0);
+    free(w->values0);
+    free(w->state);
+    free(w->values);
+}
+
+// Helper: Set or clear the injection of 'fault' in 'lane'
+static void inject_fault(SequentialWorker* w, const Fault* fault, int lane, bool set) {
+    const EvalProgram* prog = &w->circuit->program;
+    uint64_t bit = (uint64_t)1 << lane;
+    uint64_t* force;
+    if (fault->gate < 0) {
+        force = w->net_force[fault->net];
+    } else if (w->circuit->gate_type[fault->gate] == DFF) {
+        force = w->dff_force[w->dff_index[fault->gate]];
+    } else {
+        int k = prog->gate_op[fault->gate];
+        force = w->slot_force[prog->in_start[k] + fault->pin];
+        w->op_forced[k] = set;
+    }
+    if (set) force[fault->stuck_at_value] |= bit;
+    else force[fault->stuck_at_value] &= ~bit;
+}
+
+// Helper: Simulate all vectors, one clock cycle each, for up to 63 faults
+static void worker_simulate_group(SequentialWorker* w, Fault* faults, const int* group, int count,
+                                  const TestVectors* tv) {
+    const Circuit* circuit = w->circuit;
+    const EvalProgram* prog = &circuit->program;
+    uint64_t* values = w->values;
+    for (int i = 0; i < count; i++) inject_fault(w, &faults[group[i]], i + 1, true);
+    // Lanes of faults not yet detected; vectors run in order, so the first
+    // detection of a fault is final and its lane can retire either way
+    uint64_t live = (count == FAULTS_PER_WORD ? ~(uint64_t)0 : ((uint64_t)1 << (count + 1)) - 1) & ~(uint64_t)1;
+    uint64_t* values0 = w->values0;
+    memset(w->state, 0, (w->num_dffs + 1) * sizeof(uint64_t));
+    if (values0) memset(w->state0, w->unknown_state ? 0 : 0xff, (w->num_dffs + 1) * sizeof(uint64_t));
+    uint64_t* block_words = (uint64_t*)malloc((2 * tv->num_inputs + 1) * sizeof(uint64_t));
+    uint64_t* x_words = block_words + tv->num_inputs;
+    int loaded_block = -1;
+    for (int v = 0; v < tv->num_vectors && live; v++) {
+        if (v / 64 != loaded_block) {
+            loaded_block = v / 64;
+            load_vector_block(tv, loaded_block, block_words);
+            if (values0) load_vector_x(tv, loaded_block, x_words);
+        }
+        // Sources: every machine sees the same input vector and its own state
+        for (int i = 0; i < tv->num_inputs; i++) {
+            int net = circuit->primary_inputs[i];
+            uint64_t word = ((block_words[i] >> (v & 63)) & 1) ? ~(uint64_t)0 : 0;
+            const uint64_t* f = w->net_force[net];
+            if (values0) {
+                uint64_t known = ((x_words[i] >> (v & 63)) & 1) ? 0 : ~(uint64_t)0;
+                values[net] = (word & known & ~f[0]) | f[1];
+                values0[net] = (~word & known & ~f[1]) | f[0];
+            } else {
+                values[net] = (word & ~f[0]) | f[1];
+            }
+        }
+        for (int d = 0; d < w->num_dffs; d++) {
+            int net = circuit->gate_output[w->dff_gate[d]];
+            const uint64_t* f = w->net_force[net];
+            values[net] = (w->state[d] & ~f[0]) | f[1];
+            if (values0) values0[net] = (w->state0[d] & ~f[1]) | f[0];
+        }
+        // Combinational logic in level order
+        if (w->kernel) {
+            w->kernel->step(values, (const uint64_t(*)[2])w->net_force, (const uint64_t(*)[2])w->slot_force);
+        } else {
+            for (int k = 0; k < prog->num_ops; k++) {
+                int out = prog->out[k];
+                const uint64_t* f = w->net_force[out];
+                if (values0) {
+                    uint64_t word1, word0;
+                    eval_op3(prog, k, values, values0, w->slot_force, w->op_forced[k], &word1, &word0);
+                    values[out] = (word1 & ~f[0]) | f[1];
+                    values0[out] = (word0 & ~f[1]) | f[0];
+                } else {
+                    uint64_t word = eval_op(prog, k, values, w->slot_force, w->op_forced[k]);
+                    values[out] = (word & ~f[0]) | f[1];
+                }
+            }
+        }
+        INSTR_COUNT(COUNTER_GATE_EVALS, prog->num_ops);
+        // Lanes that differ from the good machine (lane 0) at an output
+        uint64_t detect = 0, unknown = 0;
+        for (int i = 0; i < circuit->num_primary_outputs; i++) {
+            int net = circuit->primary_outputs[i];
+            uint64_t word = values[net];
+            if (!values0) {
+                detect |= word ^ (0 - (word & 1));
+                continue;
+            }
+            uint64_t good1 = 0 - (word & 1), good0 = 0 - (values0[net] & 1);
+            detect |= (values0[net] & good1) | (word & good0);
+            unknown |= (good1 | good0) & ~(word | values0[net]);
+        }
+        detect &= live;
+        for (unknown &= live & ~detect; unknown; unknown &= unknown - 1) {
+            faults[group[__builtin_ctzll(unknown) - 1]].potential = true;
+        }
+        while (detect) {
+            int lane = __builtin_ctzll(detect);
+            detect &= detect - 1;
+            record_detection(&faults[group[lane - 1]], v);
+            live &= ~((uint64_t)1 << lane);
+        }
+        // Clock edge: every flip-flop captures its D input
+        for (int d = 0; d < w->num_dffs; d++) {
+            int g = w->dff_gate[d];
+            bool has_d = circuit->fanin_start[g + 1] > circuit->fanin_start[g];
+            uint64_t word = has_d ? values[circuit->fanin[circuit->fanin_start[g]]] : 0;
+            w->state[d] = (word & ~w->dff_force[d][0]) | w->dff_force[d][1];
+            if (values0) {
+                word = has_d ? values0[circuit->fanin[circuit->fanin_start[g]]] : 0;
+                w->state0[d] = (word & ~w->dff_force[d][1]) | w->dff_force[d][0];
+            }
+        }
+    }
+    free(block_words);
+    for (int i = 0; i < count; i++) inject_fault(w, &faults[group[i]], i + 1, false);
+}
+
+// Work item of the multithreaded run: one group of up to 63 faults
+typedef struct {
+    Circuit* circuit;
+    const TestVectors* tv;
+    const int* active;
+    int num_active;
+    SequentialWorker* workers;
+} SequentialTask;
+
+static void sequential_task(void* ctx, int thread_id, int item) {
+    SequentialTask* task = (SequentialTask*)ctx;
+    int begin = item * FAULTS_PER_WORD;
+    int count = task->num_active - begin < FAULTS_PER_WORD ? task->num_active - begin : FAULTS_PER_WORD;
+    worker_simulate_group(&task->workers[thread_id], task->circuit->faults, task->active + begin, count, task->tv);
+}
+
+void run_sequential_simulation(Circuit* circuit, const TestVectors* tv, const SimOptions* options) {
+    int num_threads = options->num_threads > 1 ? options->num_threads : 1;
+    int num_dffs = count_flip_flops(circuit);
+    int* dff_gate = (int*)malloc((num_dffs + 1) * sizeof(int));
+    int* dff_index = (int*)malloc((circuit->num_gates + 1) * sizeof(int));
+    bool dual_rail = tv->has_x || options->unknown_state || program_has_unknowns(circuit);
+    for (int g = 0, d = 0; g < circuit->num_gates; g++) {
+        dff_index[g] = -1;
+        if (circuit->gate_type[g] == DFF) {
+            dff_index[g] = d;
+            dff_gate[d++] = g;
+            // A flip-flop without a driven D input captures X
+            int begin = circuit->fanin_start[g];
+            if (circuit->fanin_start[g + 1] == begin || circuit->net_driver[circuit->fanin[begin]] < 0) dual_rail = true;
+        }
+    }
+    if (!options->quiet) {
+        printf("\nRunning Sequential Parallel-Fault Simulation (%d flip-flops, %d faults/word%s, %d thread%s)...\n",
+               num_dffs, FAULTS_PER_WORD, dual_rail ? ", 0/1/X" : "", num_threads, num_threads > 1 ? "s" : "");
+    }
+    // Faults still to simulate, packed into groups of 63
+    int* active = (int*)malloc((circuit->num_faults + 1) * sizeof(int));
+    int num_active = 0;
+    for (int f = 0; f < circuit->num_faults; f++) {
+        if (!(options->fault_dropping && circuit->faults[f].detected)) active[num_active++] = f;
+    }
+    int num_groups = (num_active + FAULTS_PER_WORD - 1) / FAULTS_PER_WORD;
+
+    SequentialTask task;
+    task.circuit = circuit;
+    task.tv = tv;
+    task.active = active;
+    task.num_active = num_active;
+    task.workers = (SequentialWorker*)malloc(num_threads * sizeof(SequentialWorker));
+    for (int t = 0; t < num_threads; t++) {
+        worker_init(&task.workers[t], circuit, dff_gate, num_dffs, dff_index, dual_rail, options->unknown_state,
+                    options->kernel);
+    }
+    // Groups touch disjoint faults, so results go straight into the circuit
+    parallel_for(num_groups, num_threads, sequential_task, &task);
+    for (int t = 0; t < num_threads; t++) worker_free(&task.workers[t]);
+    free(task.workers);
+    free(active);
+    free(dff_index);
+    free(dff_gate);
+    if (!options->quiet) printf("Sequential simulation run complete.\n");
+}
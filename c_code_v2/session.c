@@ -0,0 +1,280 @@
+#include "fault_simulator.h"
+#include "tvc.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <limits.h>
+
+// Simulation sessions behind tvc.h. The parsed, levelized and collapsed
+// circuit is built once, quietly, and shared by every session forked from
+// the one that opened it; the engines only read it. Each session works on
+// a shallow copy of the circuit whose fault array is its own, the same way
+// run_fault_simulation() hands the engines a view with more of the faults.
+//
+// The engines number vectors from 0 in every run; like the random-pattern
+// mode, a session moves new detections to its running vector count.
+
+// Circuit shared by a session and its forks, freed with the last of them
+typedef struct {
+    Circuit* circuit;       // faults stay as collapsed: the state of a reset session
+    CompiledKernel* kernel;
+    const char* engine;
+    SimOptions options;
+    atomic_int references;
+} SharedCircuit;
+
+struct TvcSession {
+    pthread_mutex_t lock;
+    SharedCircuit* shared;
+    Circuit circuit;        // shared->circuit with the session's own faults
+    int num_vectors;        // applied since open or reset
+    bool* was_detected;     // per collapsed fault, scratch of an apply call
+};
+
+struct TvcSnapshot {
+    SharedCircuit* shared;
+    Fault* faults;
+    int num_vectors;
+};
+
+// Helper: Number of collapsed faults, dominated ones included
+static int num_classes(const Circuit* circuit) {
+    return circuit->num_faults + circuit->num_dominated_faults;
+}
+
+// Helper: Copy of a fault array
+static Fault* copy_faults(const Circuit* circuit, const Fault* faults) {
+    int count = num_classes(circuit);
+    Fault* copy = (Fault*)malloc((count + 1) * sizeof(Fault));
+    memcpy(copy, faults, count * sizeof(Fault));
+    return copy;
+}
+
+static SharedCircuit* shared_acquire(SharedCircuit* shared) {
+    atomic_fetch_add(&shared->references, 1);
+    return shared;
+}
+
+static void shared_release(SharedCircuit* shared) {
+    if (atomic_fetch_sub(&shared->references, 1) != 1) return;
+    free_compiled_kernel(shared->kernel);
+    free_circuit(shared->circuit);
+    free(shared);
+}
+
+// Helper: A session on a shared circuit, holding a reference to it
+static TvcSession* session_create(SharedCircuit* shared, const Fault* faults, int num_vectors) {
+    TvcSession* session = (TvcSession*)calloc(1, sizeof(TvcSession));
+    pthread_mutex_init(&session->lock, NULL);
+    session->shared = shared_acquire(shared);
+    session->circuit = *shared->circuit;
+    session->circuit.faults = copy_faults(shared->circuit, faults);
+    session->num_vectors = num_vectors;
+    session->was_detected = (bool*)malloc((num_classes(shared->circuit) + 1) * sizeof(bool));
+    return session;
+}
+
+void tvc_options_init(TvcOptions* options) {
+    memset(options, 0, sizeof(*options));
+    options->engine = "deductive";
+    options->num_threads = 1;
+    options->dominance = true;
+}
+
+TvcSession* tvc_session_open(const char* netlist_filename, const TvcOptions* options) {
+    TvcOptions defaults;
+    if (!options) {
+        tvc_options_init(&defaults);
+        options = &defaults;
+    }
+    const char* engine = options->engine ? options->engine : "deductive";
+    if (strcmp(engine, "deductive") != 0 && strcmp(engine, "ppsfp") != 0) {
+        fprintf(stderr, "Error: unknown simulation engine '%s'\n", engine);
+        return NULL;
+    }
+    Circuit* circuit = build_circuit(netlist_filename, options->full_scan, options->dominance, true);
+    if (!circuit) return NULL;
+    if (count_flip_flops(circuit) > 0) {
+        if (options->engine && strcmp(options->engine, "deductive") != 0) {
+            fprintf(stderr, "Error: %s has flip-flops and runs on the sequential engine (or use full scan)\n",
+                    netlist_filename);
+            free_circuit(circuit);
+            return NULL;
+        }
+        engine = "sequential";
+    }
+    if (options->kernel_dir && strcmp(engine, "deductive") == 0) {
+        fprintf(stderr, "Error: compiled kernels need the ppsfp or sequential engine\n");
+        free_circuit(circuit);
+        return NULL;
+    }
+
+    SharedCircuit* shared = (SharedCircuit*)calloc(1, sizeof(SharedCircuit));
+    shared->circuit = circuit;
+    shared->engine = engine;
+    if (options->kernel_dir) {
+        shared->kernel = load_compiled_kernel(circuit, options->kernel_dir);
+        if (!shared->kernel) {
+            free_circuit(circuit);
+            free(shared);
+            return NULL;
+        }
+    }
+    shared->options.fault_dropping = true; // fault status is the first detection
+    shared->options.num_threads = options->num_threads > 1 ? options->num_threads : 1;
+    shared->options.quiet = true;
+    shared->options.unknown_state = options->unknown_state;
+    shared->options.kernel = shared->kernel;
+    atomic_init(&shared->references, 0);
+    return session_create(shared, circuit->faults, 0);
+}
+
+TvcSession* tvc_session_fork(TvcSession* session) {
+    pthread_mutex_lock(&session->lock);
+    TvcSession* fork = session_create(session->shared, session->circuit.faults, session->num_vectors);
+    pthread_mutex_unlock(&session->lock);
+    return fork;
+}
+
+void tvc_session_close(TvcSession* session) {
+    if (!session) return;
+    free(session->was_detected);
+    free(session->circuit.faults);
+    shared_release(session->shared);
+    pthread_mutex_destroy(&session->lock);
+    free(session);
+}
+
+int tvc_num_inputs(TvcSession* session) {
+    return session->circuit.num_primary_inputs;
+}
+
+int tvc_num_faults(TvcSession* session) {
+    return session->circuit.num_uncollapsed_faults;
+}
+
+// Helper: Simulate a vector set after the session's vectors; the lock is held
+static int apply_locked(TvcSession* session, const TestVectors* tv) {
+    Circuit* circuit = &session->circuit;
+    if (tv->num_vectors > INT_MAX - session->num_vectors) {
+        fprintf(stderr, "Error: a session is limited to %d vectors\n", INT_MAX);
+        return -1;
+    }
+    int count = num_classes(circuit);
+    for (int f = 0; f < count; f++) session->was_detected[f] = circuit->faults[f].detected;
+    run_fault_simulation(session->shared->engine, circuit, tv, &session->shared->options);
+    int newly_detected = 0;
+    for (int f = 0; f < count; f++) {
+        Fault* fault = &circuit->faults[f];
+        if (!fault->detected || session->was_detected[f]) continue;
+        fault->first_detected_vector += session->num_vectors;
+        newly_detected += circuit->class_start[f + 1] - circuit->class_start[f];
+    }
+    session->num_vectors += tv->num_vectors;
+    return newly_detected;
+}
+
+int tvc_apply_vectors(TvcSession* session, const uint64_t* words, const uint64_t* x_words, int num_vectors) {
+    if (num_vectors < 0) {
+        fprintf(stderr, "Error: negative vector count\n");
+        return -1;
+    }
+    TestVectors tv;
+    memset(&tv, 0, sizeof(tv));
+    tv.num_inputs = session->circuit.num_primary_inputs;
+    tv.num_vectors = num_vectors;
+    tv.num_blocks = (num_vectors + 63) / 64;
+    tv.packed = words;
+    tv.has_x = x_words != NULL;
+    tv.packed_x = x_words;
+    pthread_mutex_lock(&session->lock);
+    int result = apply_locked(session, &tv);
+    pthread_mutex_unlock(&session->lock);
+    return result;
+}
+
+int tvc_apply_file(TvcSession* session, const char* vectors_filename) {
+    TestVectors* tv = read_test_vectors(vectors_filename);
+    if (!tv) return -1;
+    int result = -1;
+    if (tv->num_vectors > 0 && tv->num_inputs != session->circuit.num_primary_inputs) {
+        fprintf(stderr, "Error: %s has %d inputs per vector, the circuit %d\n", vectors_filename,
+                tv->num_inputs, session->circuit.num_primary_inputs);
+    } else {
+        pthread_mutex_lock(&session->lock);
+        result = apply_locked(session, tv);
+        pthread_mutex_unlock(&session->lock);
+    }
+    free_test_vectors(tv);
+    return result;
+}
+
+void tvc_get_coverage(TvcSession* session, TvcCoverage* coverage) {
+    pthread_mutex_lock(&session->lock);
+    const Circuit* circuit = &session->circuit;
+    memset(coverage, 0, sizeof(*coverage));
+    coverage->num_faults = circuit->num_uncollapsed_faults;
+    coverage->num_vectors = session->num_vectors;
+    for (int f = 0; f < num_classes(circuit); f++) {
+        int size = circuit->class_start[f + 1] - circuit->class_start[f];
+        if (circuit->faults[f].detected) coverage->detected += size;
+        else if (circuit->faults[f].potential) coverage->potentially_detected += size;
+    }
+    coverage->coverage = coverage->num_faults > 0 ? 100.0 * coverage->detected / coverage->num_faults : 100.0;
+    pthread_mutex_unlock(&session->lock);
+}
+
+int tvc_get_fault(TvcSession* session, int index, TvcFault* fault) {
+    const Circuit* circuit = &session->circuit;
+    if (index < 0 || index >= circuit->num_uncollapsed_faults) {
+        fprintf(stderr, "Error: fault index %d out of range\n", index);
+        return -1;
+    }
+    const FaultClassMember* member = &circuit->fault_classes[index];
+    fault->net = symtab_name(&circuit->nets, member->net);
+    fault->gate = member->gate >= 0 ? gate_name(circuit, member->gate) : NULL;
+    fault->pin = member->pin;
+    fault->stuck_at = member->stuck_at_value;
+    pthread_mutex_lock(&session->lock);
+    const Fault* collapsed = &circuit->faults[member->collapsed];
+    fault->status = collapsed->detected ? TVC_DETECTED : collapsed->potential ? TVC_POTENTIALLY_DETECTED : TVC_UNDETECTED;
+    fault->first_vector = collapsed->detected ? collapsed->first_detected_vector : -1;
+    pthread_mutex_unlock(&session->lock);
+    return 0;
+}
+
+void tvc_reset(TvcSession* session) {
+    pthread_mutex_lock(&session->lock);
+    const Circuit* pristine = session->shared->circuit;
+    memcpy(session->circuit.faults, pristine->faults, num_classes(pristine) * sizeof(Fault));
+    session->num_vectors = 0;
+    pthread_mutex_unlock(&session->lock);
+}
+
+TvcSnapshot* tvc_snapshot(TvcSession* session) {
+    TvcSnapshot* snapshot = (TvcSnapshot*)malloc(sizeof(TvcSnapshot));
+    pthread_mutex_lock(&session->lock);
+    snapshot->shared = shared_acquire(session->shared);
+    snapshot->faults = copy_faults(&session->circuit, session->circuit.faults);
+    snapshot->num_vectors = session->num_vectors;
+    pthread_mutex_unlock(&session->lock);
+    return snapshot;
+}
+
+int tvc_restore(TvcSession* session, const TvcSnapshot* snapshot) {
+    if (snapshot->shared != session->shared) {
+        fprintf(stderr, "Error: snapshot was taken on another circuit\n");
+        return -1;
+    }
+    pthread_mutex_lock(&session->lock);
+    memcpy(session->circuit.faults, snapshot->faults, num_classes(&session->circuit) * sizeof(Fault));
+    session->num_vectors = snapshot->num_vectors;
+    pthread_mutex_unlock(&session->lock);
+    return 0;
+}
+
+void tvc_snapshot_free(TvcSnapshot* snapshot) {
+    if (!snapshot) return;
+    free(snapshot->faults);
+    shared_release(snapshot->shared);
+    free(snapshot);
+}
@@ -0,0 +1,113 @@
+#include "fault_simulator.h"
+
+// String-interning symbol table: every distinct net name gets a dense ID
+// (0, 1, 2, ...) so the rest of the simulator can work on integers.
+// Names are stored back to back in one pool and are only read for reporting.
+
+#define SYMTAB_INITIAL_SLOTS 64
+
+// Helper: FNV-1a hash of a name
+static uint32_t hash_name(const char* name, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Helper: Rebuild the open-addressing slot array at a new size
+static void symtab_rehash(SymbolTable* table, int num_slots) {
+    free(table->slots);
+    table->slots = (int*)malloc(num_slots * sizeof(int));
+    for (int i = 0; i < num_slots; i++) table->slots[i] = -1;
+    table->num_slots = num_slots;
+    for (int id = 0; id < table->count; id++) {
+        uint32_t s = table->hashes[id] & (num_slots - 1);
+        while (table->slots[s] != -1) s = (s + 1) & (num_slots - 1);
+        table->slots[s] = id;
+    }
+}
+
+// Helper: Compare a stored name with a length-delimited one
+static bool name_equals(const SymbolTable* table, int id, const char* name, size_t len) {
+    const char* stored = table->pool + table->offsets[id];
+    return strncmp(stored, name, len) == 0 && stored[len] == '\0';
+}
+
+void symtab_init(SymbolTable* table) {
+    table->pool = NULL;
+    table->pool_size = 0;
+    table->pool_capacity = 0;
+    table->offsets = NULL;
+    table->hashes = NULL;
+    table->count = 0;
+    table->capacity = 0;
+    table->slots = NULL;
+    table->num_slots = 0;
+    symtab_rehash(table, SYMTAB_INITIAL_SLOTS);
+}
+
+int symtab_lookup(const SymbolTable* table, const char* name) {
+    size_t len = strlen(name);
+    uint32_t h = hash_name(name, len);
+    uint32_t s = h & (table->num_slots - 1);
+    while (table->slots[s] != -1) {
+        int id = table->slots[s];
+        if (table->hashes[id] == h && name_equals(table, id, name, len)) return id;
+        s = (s + 1) & (table->num_slots - 1);
+    }
+    return -1;
+}
+
+int symtab_intern(SymbolTable* table, const char* name) {
+    return symtab_intern_n(table, name, strlen(name));
+}
+
+// Intern a name given by pointer and length, e.g. straight out of a mapped file
+int symtab_intern_n(SymbolTable* table, const char* name, size_t len) {
+    uint32_t h = hash_name(name, len);
+    uint32_t s = h & (table->num_slots - 1);
+    while (table->slots[s] != -1) {
+        int id = table->slots[s];
+        if (table->hashes[id] == h && name_equals(table, id, name, len)) return id;
+        s = (s + 1) & (table->num_slots - 1);
+    }
+    if (table->count == table->capacity) {
+        table->capacity = table->capacity ? table->capacity * 2 : 64;
+        table->offsets = (uint32_t*)realloc(table->offsets, table->capacity * sizeof(uint32_t));
+        table->hashes = (uint32_t*)realloc(table->hashes, table->capacity * sizeof(uint32_t));
+    }
+    if (table->pool_size + len + 1 > table->pool_capacity) {
+        table->pool_capacity = table->pool_capacity ? table->pool_capacity * 2 : 4096;
+        if (table->pool_capacity < table->pool_size + len + 1) table->pool_capacity = table->pool_size + len + 1;
+        table->pool = (char*)realloc(table->pool, table->pool_capacity);
+    }
+    int id = table->count++;
+    table->offsets[id] = (uint32_t)table->pool_size;
+    memcpy(table->pool + table->pool_size, name, len);
+    table->pool[table->pool_size + len] = '\0';
+    table->pool_size += len + 1;
+    table->hashes[id] = h;
+    table->slots[s] = id;
+    // Keep the load factor below 1/2
+    if (table->count * 2 > table->num_slots) symtab_rehash(table, table->num_slots * 2);
+    return id;
+}
+
+const char* symtab_name(const SymbolTable* table, int id) {
+    return (id >= 0 && id < table->count) ? table->pool + table->offsets[id] : "?";
+}
+
+void symtab_free(SymbolTable* table) {
+    free(table->pool);
+    free(table->offsets);
+    free(table->hashes);
+    free(table->slots);
+    table->pool = NULL;
+    table->offsets = NULL;
+    table->hashes = NULL;
+    table->slots = NULL;
+    table->pool_size = table->pool_capacity = 0;
+    table->count = table->capacity = table->num_slots = 0;
+}
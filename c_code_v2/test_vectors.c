@@ -0,0 +1,280 @@
+#include "fault_simulator.h"
+#include <limits.h>
+
+// Test vector sources. Vectors are handed to the simulators in packed blocks
+// of 64: load_vector_block() fills one uint64_t per primary input, where bit p
+// is the input value in vector block * 64 + p.
+//
+// Two file formats are accepted:
+// - text: one vector per line, one 0/1/x per input, separated by blanks or
+//   not. The file is mapped and indexed once (one offset per block); blocks
+//   are parsed on demand, so memory use does not grow with the vector count.
+// - packed binary (written by write_packed_vectors()): a 64-byte header
+//   followed by words[block * num_inputs + input]. It is mapped and used
+//   in place without any parsing. Sets with X inputs flag it in the header
+//   and append a second plane of the same layout with the X bits.
+//
+// An X input has its bit clear in the words of load_vector_block() and set
+// in those of load_vector_x().
+//
+// select_test_vectors() builds a packed set in memory from chosen vectors
+// of another set, in any order, for runs over a subset.
+
+static const char PACKED_MAGIC[8] = { 'T', 'V', 'C', 'V', 'E', 'C', '1', '\0' };
+#define PACKED_HEADER_SIZE 64
+#define PACKED_ENDIAN_MARK 0x01020304u
+#define PACKED_FLAG_X 1u
+
+// On-disk header of the packed binary format
+typedef struct {
+    char magic[8];
+    uint32_t endian_mark;
+    uint32_t num_inputs;
+    uint64_t num_vectors;
+    uint32_t flags;
+    char reserved[PACKED_HEADER_SIZE - 28];
+} PackedHeader;
+
+// Helper: Open a packed binary file that is already mapped
+static bool open_packed(TestVectors* tv, const char* filename) {
+    const PackedHeader* header = (const PackedHeader*)tv->file.data;
+    if (header->endian_mark != PACKED_ENDIAN_MARK || header->num_vectors > INT_MAX || header->num_inputs > INT_MAX) {
+        fprintf(stderr, "Error: %s is not a packed vector file for this platform\n", filename);
+        return false;
+    }
+    tv->num_inputs = (int)header->num_inputs;
+    tv->num_vectors = (int)header->num_vectors;
+    tv->num_blocks = (tv->num_vectors + 63) / 64;
+    tv->has_x = (header->flags & PACKED_FLAG_X) != 0;
+    // The words the header promises, checked against the file size without
+    // forming a product that could overflow
+    uint64_t num_planes = tv->has_x ? 2 : 1;
+    uint64_t file_words = (tv->file.size - PACKED_HEADER_SIZE) / sizeof(uint64_t);
+    if (tv->num_blocks > 0 && (uint64_t)tv->num_inputs > file_words / num_planes / (uint64_t)tv->num_blocks) {
+        fprintf(stderr, "Error: packed vector file %s is truncated\n", filename);
+        return false;
+    }
+    size_t plane = (size_t)tv->num_blocks * tv->num_inputs;
+    tv->packed = (const uint64_t*)(tv->file.data + PACKED_HEADER_SIZE);
+    if (tv->has_x) tv->packed_x = tv->packed + plane;
+    return true;
+}
+
+// Helper: Index a text file: validate every line and record each block's offset
+static bool open_text(TestVectors* tv, const char* filename) {
+    const char* data = tv->file.data;
+    size_t size = tv->file.size;
+    size_t capacity = 64;
+    tv->block_offsets = (size_t*)malloc(capacity * sizeof(size_t));
+    tv->num_inputs = -1;
+    int line_num = 0;
+    size_t pos = 0;
+    while (pos < size) {
+        const char* line = data + pos;
+        const char* nl = (const char*)memchr(line, '\n', size - pos);
+        size_t len = nl ? (size_t)(nl - line) : size - pos;
+        line_num++;
+        int count = 0;
+        for (size_t i = 0; i < len; i++) {
+            char c = line[i];
+            if (c == '0' || c == '1') {
+                count++;
+            } else if (c == 'x' || c == 'X') {
+                count++;
+                tv->has_x = true;
+            } else if (c != ' ' && c != '\t' && c != '\r') {
+                fprintf(stderr, "Error: %s line %d: unexpected character '%c'\n", filename, line_num, c);
+                return false;
+            }
+        }
+        if (count > 0) {
+            if (tv->num_inputs < 0) tv->num_inputs = count;
+            if (count != tv->num_inputs) {
+                fprintf(stderr, "Error: %s line %d: %d values, expected %d\n", filename, line_num, count, tv->num_inputs);
+                return false;
+            }
+            if (tv->num_vectors % 64 == 0) {
+                if (tv->num_blocks == (int)capacity) {
+                    capacity *= 2;
+                    tv->block_offsets = (size_t*)realloc(tv->block_offsets, capacity * sizeof(size_t));
+                }
+                tv->block_offsets[tv->num_blocks++] = pos;
+            }
+            tv->num_vectors++;
+        }
+        pos += len + 1;
+    }
+    if (tv->num_inputs < 0) tv->num_inputs = 0;
+    return true;
+}
+
+TestVectors* read_test_vectors(const char* filename) {
+    TestVectors* tv = (TestVectors*)calloc(1, sizeof(TestVectors));
+    if (!map_file(filename, &tv->file)) {
+        perror("Error opening test vector file");
+        free(tv);
+        return NULL;
+    }
+    bool ok;
+    if (tv->file.size >= PACKED_HEADER_SIZE && memcmp(tv->file.data, PACKED_MAGIC, sizeof(PACKED_MAGIC)) == 0) {
+        ok = open_packed(tv, filename);
+    } else {
+        ok = open_text(tv, filename);
+    }
+    if (!ok) {
+        free_test_vectors(tv);
+        return NULL;
+    }
+    return tv;
+}
+
+void load_vector_block(const TestVectors* tv, int block, uint64_t* words) {
+    if (tv->packed) {
+        memcpy(words, tv->packed + (size_t)block * tv->num_inputs, tv->num_inputs * sizeof(uint64_t));
+        return;
+    }
+    memset(words, 0, tv->num_inputs * sizeof(uint64_t));
+    const char* data = tv->file.data;
+    const char* end = data + tv->file.size;
+    const char* p = data + tv->block_offsets[block];
+    int count = tv->num_vectors - block * 64 < 64 ? tv->num_vectors - block * 64 : 64;
+    // Lines were validated when the file was indexed; blank lines are skipped
+    for (int v = 0; v < count; ) {
+        int i = 0;
+        while (p < end && *p != '\n') {
+            if (*p == '1') words[i++] |= (uint64_t)1 << v;
+            else if (*p == '0' || *p == 'x' || *p == 'X') i++;
+            p++;
+        }
+        p++;
+        if (i > 0) v++;
+    }
+}
+
+void load_vector_x(const TestVectors* tv, int block, uint64_t* words) {
+    if (!tv->has_x) {
+        memset(words, 0, tv->num_inputs * sizeof(uint64_t));
+        return;
+    }
+    if (tv->packed) {
+        memcpy(words, tv->packed_x + (size_t)block * tv->num_inputs, tv->num_inputs * sizeof(uint64_t));
+        return;
+    }
+    memset(words, 0, tv->num_inputs * sizeof(uint64_t));
+    const char* end = tv->file.data + tv->file.size;
+    const char* p = tv->file.data + tv->block_offsets[block];
+    int count = tv->num_vectors - block * 64 < 64 ? tv->num_vectors - block * 64 : 64;
+    for (int v = 0; v < count; ) {
+        int i = 0;
+        while (p < end && *p != '\n') {
+            if (*p == 'x' || *p == 'X') words[i++] |= (uint64_t)1 << v;
+            else if (*p == '0' || *p == '1') i++;
+            p++;
+        }
+        p++;
+        if (i > 0) v++;
+    }
+}
+
+int write_packed_vectors(const TestVectors* tv, const char* filename) {
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        perror("Error opening packed vector file");
+        return -1;
+    }
+    PackedHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PACKED_MAGIC, sizeof(PACKED_MAGIC));
+    header.endian_mark = PACKED_ENDIAN_MARK;
+    header.num_inputs = (uint32_t)tv->num_inputs;
+    header.num_vectors = (uint64_t)tv->num_vectors;
+    header.flags = tv->has_x ? PACKED_FLAG_X : 0;
+    fwrite(&header, sizeof(header), 1, file);
+    uint64_t* words = (uint64_t*)malloc((tv->num_inputs + 1) * sizeof(uint64_t));
+    for (int b = 0; b < tv->num_blocks; b++) {
+        load_vector_block(tv, b, words);
+        fwrite(words, sizeof(uint64_t), tv->num_inputs, file);
+    }
+    for (int b = 0; tv->has_x && b < tv->num_blocks; b++) {
+        load_vector_x(tv, b, words);
+        fwrite(words, sizeof(uint64_t), tv->num_inputs, file);
+    }
+    free(words);
+    int status = ferror(file) ? -1 : 0;
+    fclose(file);
+    return status;
+}
+
+int write_text_vectors(const TestVectors* tv, const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        perror("Error opening test vector file");
+        return -1;
+    }
+    uint64_t* words = (uint64_t*)malloc((2 * tv->num_inputs + 1) * sizeof(uint64_t));
+    uint64_t* x_words = words + tv->num_inputs;
+    char* line = (char*)malloc(2 * tv->num_inputs + 2);
+    for (int v = 0; v < tv->num_vectors; v++) {
+        if (v % 64 == 0) {
+            load_vector_block(tv, v / 64, words);
+            load_vector_x(tv, v / 64, x_words);
+        }
+        for (int i = 0; i < tv->num_inputs; i++) {
+            bool x = (x_words[i] >> (v % 64)) & 1;
+            line[2 * i] = x ? 'x' : (char)('0' + ((words[i] >> (v % 64)) & 1));
+            line[2 * i + 1] = ' ';
+        }
+        line[tv->num_inputs > 0 ? 2 * tv->num_inputs - 1 : 0] = '\n';
+        fwrite(line, 1, tv->num_inputs > 0 ? 2 * tv->num_inputs : 1, file);
+    }
+    free(line);
+    free(words);
+    int status = ferror(file) ? -1 : 0;
+    if (fclose(file) != 0) status = -1;
+    return status;
+}
+
+// Write a vector set in the format its file name asks for: packed for .tvb
+int write_test_vectors(const TestVectors* tv, const char* filename) {
+    size_t len = strlen(filename);
+    if (len > 4 && strcmp(filename + len - 4, ".tvb") == 0) return write_packed_vectors(tv, filename);
+    return write_text_vectors(tv, filename);
+}
+
+TestVectors* select_test_vectors(const TestVectors* tv, const int* vectors, int count) {
+    TestVectors* selected = (TestVectors*)calloc(1, sizeof(TestVectors));
+    selected->num_inputs = tv->num_inputs;
+    selected->num_vectors = count;
+    selected->num_blocks = (count + 63) / 64;
+    selected->has_x = tv->has_x;
+    size_t plane = (size_t)selected->num_blocks * tv->num_inputs;
+    selected->words = (uint64_t*)calloc((tv->has_x ? 2 : 1) * plane + 1, sizeof(uint64_t));
+    selected->packed = selected->words;
+    if (tv->has_x) selected->packed_x = selected->words + plane;
+    uint64_t* block = (uint64_t*)malloc((2 * tv->num_inputs + 1) * sizeof(uint64_t));
+    uint64_t* x_block = block + tv->num_inputs;
+    int loaded = -1;
+    for (int k = 0; k < count; k++) {
+        int v = vectors[k];
+        if (v / 64 != loaded) {
+            loaded = v / 64;
+            load_vector_block(tv, loaded, block);
+            load_vector_x(tv, loaded, x_block);
+        }
+        size_t offset = (size_t)(k / 64) * tv->num_inputs;
+        for (int i = 0; i < tv->num_inputs; i++) {
+            selected->words[offset + i] |= ((block[i] >> (v % 64)) & 1) << (k % 64);
+            if (tv->has_x) selected->words[plane + offset + i] |= ((x_block[i] >> (v % 64)) & 1) << (k % 64);
+        }
+    }
+    free(block);
+    return selected;
+}
+
+void free_test_vectors(TestVectors* tv) {
+    if (!tv) return;
+    unmap_file(&tv->file);
+    free(tv->block_offsets);
+    free(tv->words);
+    free(tv);
+}
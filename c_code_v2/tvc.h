@@ -0,0 +1,86 @@
+#ifndef TVC_H
+#define TVC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Library interface of the fault simulator (see session.c). A session owns
+// one parsed circuit with its collapsed fault list; vector blocks are applied
+// to it incrementally, and coverage and per-fault status can be read at any
+// point. Nothing is printed to stdout: errors are described on stderr and
+// reported by the return value (NULL or -1).
+//
+// Sessions are independent and may be used from any number of threads; the
+// calls on one session are serialized by its own lock. tvc_session_fork()
+// opens a second session on the same parsed circuit, which is shared
+// read-only, so concurrent requests against a hot circuit each get their
+// own fault state without parsing it again.
+
+typedef struct TvcSession TvcSession;
+typedef struct TvcSnapshot TvcSnapshot;
+
+typedef struct {
+    const char* engine;     // "deductive" (default) or "ppsfp"; circuits with flip-flops
+                            // and no full scan always run on the sequential engine
+    int num_threads;        // worker threads per apply call, 1 for a serial run
+    bool dominance;         // collapse by dominance as well as equivalence
+    bool full_scan;         // flip-flops become pseudo primary inputs and outputs
+    bool unknown_state;     // sequential engine: flip-flops power up at X, not 0
+    const char* kernel_dir; // compiled kernel cache directory (ppsfp, sequential), NULL to interpret
+} TvcOptions;
+
+typedef enum {
+    TVC_UNDETECTED,
+    TVC_DETECTED,
+    TVC_POTENTIALLY_DETECTED // an output was X in the faulty machine only; not counted as detected
+} TvcFaultStatus;
+
+// One fault of the uncollapsed universe
+typedef struct {
+    const char* net;        // fault site; names stay valid while the circuit is open
+    const char* gate;       // branch faults: instance reading the net, NULL for stem faults
+    int pin;                // branch faults: input index on that instance
+    int stuck_at;           // 0 or 1
+    TvcFaultStatus status;
+    int first_vector;       // first detecting vector since open or reset, -1 if undetected
+} TvcFault;
+
+typedef struct {
+    int num_faults;         // uncollapsed fault universe
+    int detected;
+    int potentially_detected;
+    int num_vectors;        // applied since open or reset
+    double coverage;        // detected, in percent of the universe
+} TvcCoverage;
+
+// Defaults: deductive engine, one thread, dominance on, no full scan
+void tvc_options_init(TvcOptions* options);
+
+TvcSession* tvc_session_open(const char* netlist_filename, const TvcOptions* options);
+TvcSession* tvc_session_fork(TvcSession* session);
+void tvc_session_close(TvcSession* session);
+
+int tvc_num_inputs(TvcSession* session);
+int tvc_num_faults(TvcSession* session);
+
+// Apply vectors after those already applied. words[block * num_inputs + input]
+// holds the input in vectors block * 64 + p at bit p, the layout of packed
+// vector files; x_words, laid out the same, marks X inputs and may be NULL.
+// Circuits run on the sequential engine take each call as one test sequence
+// from reset. Returns the number of faults newly detected, or -1.
+int tvc_apply_vectors(TvcSession* session, const uint64_t* words, const uint64_t* x_words, int num_vectors);
+int tvc_apply_file(TvcSession* session, const char* vectors_filename);
+
+void tvc_get_coverage(TvcSession* session, TvcCoverage* coverage);
+int tvc_get_fault(TvcSession* session, int index, TvcFault* fault);
+
+// Forget every detection and vector applied
+void tvc_reset(TvcSession* session);
+
+// Detection state of a session, to be restored into it or any session on the
+// same circuit (forks included)
+TvcSnapshot* tvc_snapshot(TvcSession* session);
+int tvc_restore(TvcSession* session, const TvcSnapshot* snapshot);
+void tvc_snapshot_free(TvcSnapshot* snapshot);
+
+#endif // TVC_H